@@ -0,0 +1,601 @@
+#include "AVLTree.h"
+
+#include <iostream>
+#include <cassert>
+#include <thread>
+#include <utility>
+
+class AVLNode {
+    private:
+        AVLNode(double value): data{value}, left{nullptr}, right{nullptr}, height{1}, count{1} {
+
+        }
+
+        double data;
+        AVLNode* left;
+        AVLNode* right;
+        int height; // Levels in this subtree; a leaf has height 1
+        std::size_t count; // Keys in this subtree
+
+    friend class AVLTree;
+};
+
+// Runs left on a new thread while running right on this one when parallel,
+// else runs both here
+template <typename L, typename R>
+static void fork_join(bool parallel, L&& left, R&& right) {
+    if (!parallel) {
+        left();
+        right();
+        return;
+    }
+
+    std::thread left_worker{std::forward<L>(left)};
+    right();
+    left_worker.join();
+}
+
+AVLTree::AVLTree(): root{nullptr}, size{0} {
+
+}
+
+AVLTree::AVLTree(const AVLTree& orig): root{clone(orig.root)}, size{orig.size} {
+
+}
+
+AVLTree::AVLTree(AVLTree&& orig) noexcept: root{orig.root}, size{orig.size} {
+    orig.root = nullptr;
+    orig.size = 0;
+}
+
+AVLTree& AVLTree::operator=(const AVLTree& rhs) {
+    if (this == &rhs) {
+        return *this;
+    }
+
+    clear();
+    root = clone(rhs.root);
+    size = rhs.size;
+
+    return *this;
+}
+
+AVLTree& AVLTree::operator=(AVLTree&& rhs) noexcept {
+    if (this == &rhs) {
+        return *this;
+    }
+
+    clear();
+    root = rhs.root;
+    size = rhs.size;
+    rhs.root = nullptr;
+    rhs.size = 0;
+
+    return *this;
+}
+
+AVLTree::~AVLTree() {
+    clear();
+}
+
+void AVLTree::clear() {
+    clear(root);
+    size = 0;
+}
+
+std::size_t AVLTree::get_size() const {
+    return size;
+}
+
+bool AVLTree::empty() const {
+    return size == 0;
+}
+
+void AVLTree::insert(double value) {
+    root = insert(root, value);
+}
+
+bool AVLTree::contains(double value) const {
+    const AVLNode* curr{root};
+
+    while (curr != nullptr) {
+        if (value == curr->data) {
+            return true;
+        }
+
+        curr = value < curr->data ? curr->left : curr->right;
+    }
+
+    return false;
+}
+
+double AVLTree::min() const {
+    assert(!empty());
+    const AVLNode* curr{root};
+
+    while (curr->left != nullptr) {
+        curr = curr->left;
+    }
+
+    return curr->data;
+}
+
+double AVLTree::max() const {
+    assert(!empty());
+    const AVLNode* curr{root};
+
+    while (curr->right != nullptr) {
+        curr = curr->right;
+    }
+
+    return curr->data;
+}
+
+std::size_t AVLTree::height() const {
+    return static_cast<std::size_t>(height(root));
+}
+
+void AVLTree::inorder_print() const {
+    inorder_print(root);
+    std::cout << "\n";
+}
+
+void AVLTree::preorder_print() const {
+    preorder_print(root);
+    std::cout << "\n";
+}
+
+void AVLTree::postorder_print() const {
+    postorder_print(root);
+    std::cout << "\n";
+}
+
+// Prints one level at a time; the tree is only O(log n) levels deep, so this
+// needs no queue and visits each node O(log n) times at most
+void AVLTree::levelorder_print() const {
+    for (int depth{0}; depth < height(root); ++depth) {
+        level_print(root, depth);
+    }
+
+    std::cout << "\n";
+}
+
+void AVLTree::erase(double value) {
+    root = erase(root, value);
+}
+
+// Checks the ordering, the cached heights and sizes, and the AVL balance of every node
+bool AVLTree::is_valid_bst() const {
+    return is_valid_bst(root, nullptr, nullptr);
+}
+
+// Moves the keys below key into less and those above it into greater, leaving
+// this tree empty. key itself is dropped; returns whether it was present. O(log n).
+bool AVLTree::split(double key, AVLTree& less, AVLTree& greater) {
+    AVLNode* below{nullptr};
+    AVLNode* above{nullptr};
+    AVLNode* found{split(root, key, below, above)};
+    root = nullptr;
+    size = 0;
+    delete found;
+    less = AVLTree{};
+    greater = AVLTree{};
+    less.root = below;
+    less.size = count(below);
+    greater.root = above;
+    greater.size = count(above);
+
+    return found != nullptr;
+}
+
+// Concatenates two trees whose keys do not interleave, every key of less
+// being below every key of greater, in O(log n); both are left empty
+AVLTree AVLTree::join(AVLTree&& less, AVLTree&& greater) {
+    assert(less.empty() || greater.empty() || less.max() < greater.min());
+    AVLTree result;
+    result.root = join2(less.root, greater.root);
+    result.size = less.size + greater.size;
+    less.root = nullptr;
+    less.size = 0;
+    greater.root = nullptr;
+    greater.size = 0;
+
+    return result;
+}
+
+// Adds every key of other; nodes are copied from other only for keys this tree lacks
+void AVLTree::union_with(const AVLTree& other, unsigned threads) {
+    if (this == &other) {
+        return;
+    }
+
+    root = union_of(root, other.root, threads == 0 ? 1 : threads);
+    size = count(root);
+}
+
+// Keeps only the keys other also holds
+void AVLTree::intersect_with(const AVLTree& other, unsigned threads) {
+    if (this == &other) {
+        return;
+    }
+
+    root = intersection_of(root, other.root, threads == 0 ? 1 : threads);
+    size = count(root);
+}
+
+// Removes every key other holds
+void AVLTree::difference_with(const AVLTree& other, unsigned threads) {
+    if (this == &other) {
+        clear();
+        return;
+    }
+
+    root = difference_of(root, other.root, threads == 0 ? 1 : threads);
+    size = count(root);
+}
+
+AVLNode* AVLTree::clone(const AVLNode* curr) {
+    if (curr == nullptr) {
+        return nullptr;
+    }
+
+    AVLNode* new_node{new AVLNode{curr->data}};
+    new_node->left  = clone(curr->left);
+    new_node->right = clone(curr->right);
+    new_node->height = curr->height;
+    new_node->count = curr->count;
+
+    return new_node;
+}
+
+void AVLTree::clear(AVLNode*& curr) {
+    if (curr == nullptr) {
+        return;
+    }
+
+    clear(curr->left);
+    clear(curr->right);
+    delete curr;
+    curr = nullptr;
+}
+
+int AVLTree::height(const AVLNode* curr) {
+    return curr == nullptr ? 0 : curr->height;
+}
+
+std::size_t AVLTree::count(const AVLNode* curr) {
+    return curr == nullptr ? 0 : curr->count;
+}
+
+void AVLTree::update(AVLNode* curr) {
+    int l{height(curr->left)};
+    int r{height(curr->right)};
+    curr->height = 1 + (l >= r ? l : r);
+    curr->count = 1 + count(curr->left) + count(curr->right);
+}
+
+AVLNode* AVLTree::rotate_left(AVLNode* curr) {
+    AVLNode* pivot{curr->right};
+    curr->right = pivot->left;
+    pivot->left = curr;
+    update(curr);
+    update(pivot);
+
+    return pivot;
+}
+
+AVLNode* AVLTree::rotate_right(AVLNode* curr) {
+    AVLNode* pivot{curr->left};
+    curr->left = pivot->right;
+    pivot->right = curr;
+    update(curr);
+    update(pivot);
+
+    return pivot;
+}
+
+// Restores the balance of curr after one of its subtrees changed height by one.
+// Returns the new root of the subtree.
+AVLNode* AVLTree::rebalance(AVLNode* curr) {
+    update(curr);
+    int balance{height(curr->left) - height(curr->right)};
+
+    if (balance > 1) {
+        if (height(curr->left->left) < height(curr->left->right)) {
+            curr->left = rotate_left(curr->left);
+        }
+
+        return rotate_right(curr);
+    }
+
+    if (balance < -1) {
+        if (height(curr->right->right) < height(curr->right->left)) {
+            curr->right = rotate_right(curr->right);
+        }
+
+        return rotate_left(curr);
+    }
+
+    return curr;
+}
+
+AVLNode* AVLTree::insert(AVLNode* curr, double value) {
+    if (curr == nullptr) {
+        ++size;
+        return new AVLNode{value};
+    }
+
+    if (value == curr->data) {
+        return curr;
+    } else if (value < curr->data) {
+        curr->left = insert(curr->left, value);
+    } else {
+        curr->right = insert(curr->right, value);
+    }
+
+    return rebalance(curr);
+}
+
+AVLNode* AVLTree::erase(AVLNode* curr, double value) {
+    if (curr == nullptr) {
+        return nullptr;
+    }
+
+    if (value < curr->data) {
+        curr->left = erase(curr->left, value);
+    } else if (value > curr->data) {
+        curr->right = erase(curr->right, value);
+    } else {
+        AVLNode* left{curr->left};
+        AVLNode* right{curr->right};
+        delete curr;
+        --size;
+
+        if (right == nullptr) {
+            return left;
+        }
+
+        // The successor takes the erased node's place
+        AVLNode* successor{nullptr};
+        right = erase_min(right, successor);
+        successor->left = left;
+        successor->right = right;
+
+        return rebalance(successor);
+    }
+
+    return rebalance(curr);
+}
+
+// Unlinks the smallest node of the subtree into min_node and returns the rebalanced rest
+AVLNode* AVLTree::erase_min(AVLNode* curr, AVLNode*& min_node) {
+    if (curr->left == nullptr) {
+        min_node = curr;
+        return curr->right;
+    }
+
+    curr->left = erase_min(curr->left, min_node);
+
+    return rebalance(curr);
+}
+
+// Joins two trees around mid, which must sit between their keys. The shorter
+// tree is hung from the taller one's spine at the first node no more than one
+// level taller than it, and the spine is rebalanced on the way back up, so
+// the cost is O(difference in heights).
+AVLNode* AVLTree::join(AVLNode* less, AVLNode* mid, AVLNode* greater) {
+    if (height(less) > height(greater) + 1) {
+        return join_right(less, mid, greater);
+    }
+
+    if (height(greater) > height(less) + 1) {
+        return join_left(less, mid, greater);
+    }
+
+    mid->left = less;
+    mid->right = greater;
+    update(mid);
+
+    return mid;
+}
+
+AVLNode* AVLTree::join_right(AVLNode* less, AVLNode* mid, AVLNode* greater) {
+    if (height(less->right) <= height(greater) + 1) {
+        mid->left = less->right;
+        mid->right = greater;
+        update(mid);
+        less->right = mid;
+    } else {
+        less->right = join_right(less->right, mid, greater);
+    }
+
+    return rebalance(less);
+}
+
+AVLNode* AVLTree::join_left(AVLNode* less, AVLNode* mid, AVLNode* greater) {
+    if (height(greater->left) <= height(less) + 1) {
+        mid->left = less;
+        mid->right = greater->left;
+        update(mid);
+        greater->left = mid;
+    } else {
+        greater->left = join_left(less, mid, greater->left);
+    }
+
+    return rebalance(greater);
+}
+
+// Joins two trees with no key between them by pulling out greater's minimum
+AVLNode* AVLTree::join2(AVLNode* less, AVLNode* greater) {
+    if (greater == nullptr) {
+        return less;
+    }
+
+    AVLNode* mid{nullptr};
+    greater = erase_min(greater, mid);
+
+    return join(less, mid, greater);
+}
+
+// Splits the subtree into the keys below and above key, joining the pieces cut
+// off on each side of the search path. Returns the detached node holding key,
+// or nullptr.
+AVLNode* AVLTree::split(AVLNode* curr, double key, AVLNode*& less, AVLNode*& greater) {
+    if (curr == nullptr) {
+        less = nullptr;
+        greater = nullptr;
+        return nullptr;
+    }
+
+    AVLNode* left{curr->left};
+    AVLNode* right{curr->right};
+
+    if (key == curr->data) {
+        less = left;
+        greater = right;
+        curr->left = nullptr;
+        curr->right = nullptr;
+        update(curr);
+        return curr;
+    }
+
+    AVLNode* found{nullptr};
+
+    if (key < curr->data) {
+        AVLNode* cut{nullptr};
+        found = split(left, key, less, cut);
+        greater = join(cut, curr, right);
+    } else {
+        AVLNode* cut{nullptr};
+        found = split(right, key, cut, greater);
+        less = join(left, curr, cut);
+    }
+
+    return found;
+}
+
+// Splits mine at the root key of other and unites each half with the matching
+// subtree of other. Only keys missing from mine get new nodes.
+AVLNode* AVLTree::union_of(AVLNode* mine, const AVLNode* other, unsigned threads) {
+    if (other == nullptr) {
+        return mine;
+    }
+
+    if (mine == nullptr) {
+        return clone(other);
+    }
+
+    AVLNode* less{nullptr};
+    AVLNode* greater{nullptr};
+    AVLNode* mid{split(mine, other->data, less, greater)};
+
+    if (mid == nullptr) {
+        mid = new AVLNode{other->data};
+    }
+
+    fork_join(threads > 1 && count(less) + count(greater) + other->count >= parallel_set_cutoff,
+        [&] { less = union_of(less, other->left, threads / 2); },
+        [&] { greater = union_of(greater, other->right, threads - threads / 2); });
+
+    return join(less, mid, greater);
+}
+
+AVLNode* AVLTree::intersection_of(AVLNode* mine, const AVLNode* other, unsigned threads) {
+    if (mine == nullptr || other == nullptr) {
+        clear(mine);
+        return nullptr;
+    }
+
+    AVLNode* less{nullptr};
+    AVLNode* greater{nullptr};
+    AVLNode* mid{split(mine, other->data, less, greater)};
+
+    fork_join(threads > 1 && count(less) + count(greater) + other->count >= parallel_set_cutoff,
+        [&] { less = intersection_of(less, other->left, threads / 2); },
+        [&] { greater = intersection_of(greater, other->right, threads - threads / 2); });
+
+    return mid != nullptr ? join(less, mid, greater) : join2(less, greater);
+}
+
+AVLNode* AVLTree::difference_of(AVLNode* mine, const AVLNode* other, unsigned threads) {
+    if (mine == nullptr || other == nullptr) {
+        return mine;
+    }
+
+    AVLNode* less{nullptr};
+    AVLNode* greater{nullptr};
+    delete split(mine, other->data, less, greater);
+
+    fork_join(threads > 1 && count(less) + count(greater) + other->count >= parallel_set_cutoff,
+        [&] { less = difference_of(less, other->left, threads / 2); },
+        [&] { greater = difference_of(greater, other->right, threads - threads / 2); });
+
+    return join2(less, greater);
+}
+
+void AVLTree::inorder_print(const AVLNode* curr) const {
+    if (curr == nullptr) {
+        return;
+    }
+
+    inorder_print(curr->left);
+    std::cout << curr->data << " ";
+    inorder_print(curr->right);
+}
+
+void AVLTree::preorder_print(const AVLNode* curr) const {
+    if (curr == nullptr) {
+        return;
+    }
+
+    std::cout << curr->data << " ";
+    preorder_print(curr->left);
+    preorder_print(curr->right);
+}
+
+void AVLTree::postorder_print(const AVLNode* curr) const {
+    if (curr == nullptr) {
+        return;
+    }
+
+    postorder_print(curr->left);
+    postorder_print(curr->right);
+    std::cout << curr->data << " ";
+}
+
+void AVLTree::level_print(const AVLNode* curr, int depth) const {
+    if (curr == nullptr) {
+        return;
+    }
+
+    if (depth == 0) {
+        std::cout << curr->data << " ";
+        return;
+    }
+
+    level_print(curr->left, depth - 1);
+    level_print(curr->right, depth - 1);
+}
+
+bool AVLTree::is_valid_bst(const AVLNode* curr, const AVLNode* min_node, const AVLNode* max_node) const {
+    if (curr == nullptr) {
+        return true;
+    }
+
+    if (min_node != nullptr && curr->data <= min_node->data) {
+        return false;
+    }
+
+    if (max_node != nullptr && curr->data >= max_node->data) {
+        return false;
+    }
+
+    int l{height(curr->left)};
+    int r{height(curr->right)};
+
+    if (curr->height != 1 + (l >= r ? l : r) || l - r > 1 || r - l > 1 || curr->count != 1 + count(curr->left) + count(curr->right)) {
+        return false;
+    }
+
+    return is_valid_bst(curr->left, min_node, curr) && is_valid_bst(curr->right, curr, max_node);
+}
@@ -0,0 +1,79 @@
+#ifndef AVLTREE_H
+#define AVLTREE_H
+
+#include <cstddef>
+
+class AVLNode;
+
+// BinarySearchTree with AVL rebalancing: the heights of every node's subtrees
+// differ by at most one, so the tree stays within 1.44 log2(n) levels whatever
+// the insertion order, and insert, erase and contains are O(log n) worst case.
+// Each node caches its height, so height() is O(1) and the recursive helpers
+// only ever recurse O(log n) deep. Nodes also cache their subtree size, which
+// lets split, join and the set operations below keep get_size() exact.
+//
+// The set operations are join-based: split one tree at the other's root key,
+// combine the halves recursively and join the results around that key. They
+// take O(m log(n / m + 1)) work for sets of sizes m <= n, which is O(m log n)
+// for a small set against a big one and O(n) for two of similar size, and with
+// threads > 1 the two recursive halves of large inputs run on separate threads.
+class AVLTree {
+    public:
+        AVLTree();
+        AVLTree(const AVLTree& orig);
+        AVLTree(AVLTree&& orig) noexcept;
+        AVLTree& operator=(const AVLTree& rhs);
+        AVLTree& operator=(AVLTree&& rhs) noexcept;
+        ~AVLTree();
+        void clear();
+        std::size_t get_size() const;
+        bool empty() const;
+        void insert(double value);
+        bool contains(double value) const;
+        double min() const;
+        double max() const;
+        std::size_t height() const;
+        void inorder_print() const;
+        void preorder_print() const;
+        void postorder_print() const;
+        void levelorder_print() const;
+        void erase(double value);
+        bool is_valid_bst() const;
+        bool split(double key, AVLTree& less, AVLTree& greater);
+        static AVLTree join(AVLTree&& less, AVLTree&& greater);
+        void union_with(const AVLTree& other, unsigned threads = 1);
+        void intersect_with(const AVLTree& other, unsigned threads = 1);
+        void difference_with(const AVLTree& other, unsigned threads = 1);
+
+    private:
+        static constexpr std::size_t parallel_set_cutoff{1 << 16}; // Smaller inputs are not worth a thread
+
+        AVLNode* root;
+        std::size_t size;
+        static AVLNode* clone(const AVLNode* curr);
+        static void clear(AVLNode*& curr);
+        static int height(const AVLNode* curr);
+        static std::size_t count(const AVLNode* curr);
+        static void update(AVLNode* curr);
+        static AVLNode* rotate_left(AVLNode* curr);
+        static AVLNode* rotate_right(AVLNode* curr);
+        static AVLNode* rebalance(AVLNode* curr);
+        AVLNode* insert(AVLNode* curr, double value);
+        AVLNode* erase(AVLNode* curr, double value);
+        static AVLNode* erase_min(AVLNode* curr, AVLNode*& min_node);
+        static AVLNode* join(AVLNode* less, AVLNode* mid, AVLNode* greater);
+        static AVLNode* join_right(AVLNode* less, AVLNode* mid, AVLNode* greater);
+        static AVLNode* join_left(AVLNode* less, AVLNode* mid, AVLNode* greater);
+        static AVLNode* join2(AVLNode* less, AVLNode* greater);
+        static AVLNode* split(AVLNode* curr, double key, AVLNode*& less, AVLNode*& greater);
+        static AVLNode* union_of(AVLNode* mine, const AVLNode* other, unsigned threads);
+        static AVLNode* intersection_of(AVLNode* mine, const AVLNode* other, unsigned threads);
+        static AVLNode* difference_of(AVLNode* mine, const AVLNode* other, unsigned threads);
+        void inorder_print(const AVLNode* curr) const;
+        void preorder_print(const AVLNode* curr) const;
+        void postorder_print(const AVLNode* curr) const;
+        void level_print(const AVLNode* curr, int depth) const;
+        bool is_valid_bst(const AVLNode* curr, const AVLNode* min_node, const AVLNode* max_node) const;
+};
+
+#endif
@@ -0,0 +1,613 @@
+#include "BPlusTree.h"
+
+#include <iostream>
+#include <algorithm>
+#include <cassert>
+#include <utility>
+#include <vector>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+// Number of the first n keys that are < value, or <= value when Inclusive. The
+// keys are sorted, so this is also the search position; comparing a whole node
+// costs a handful of vector compares and no unpredictable branches.
+template <bool Inclusive>
+static std::uint32_t count_below(const double* keys, std::uint32_t n, double value) {
+    std::uint32_t count{0};
+    std::uint32_t i{0};
+#if defined(__AVX__)
+    __m256d v{_mm256_set1_pd(value)};
+
+    for (; i + 4 <= n; i += 4) {
+        __m256d lt{_mm256_cmp_pd(_mm256_loadu_pd(keys + i), v, Inclusive ? _CMP_LE_OQ : _CMP_LT_OQ)};
+        count += static_cast<std::uint32_t>(__builtin_popcount(_mm256_movemask_pd(lt)));
+    }
+#elif defined(__SSE2__)
+    __m128d v{_mm_set1_pd(value)};
+
+    for (; i + 2 <= n; i += 2) {
+        __m128d k{_mm_loadu_pd(keys + i)};
+        __m128d lt{Inclusive ? _mm_cmple_pd(k, v) : _mm_cmplt_pd(k, v)};
+        count += static_cast<std::uint32_t>(__builtin_popcount(_mm_movemask_pd(lt)));
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    float64x2_t v{vdupq_n_f64(value)};
+
+    for (; i + 2 <= n; i += 2) {
+        float64x2_t k{vld1q_f64(keys + i)};
+        uint64x2_t lt{Inclusive ? vcleq_f64(k, v) : vcltq_f64(k, v)};
+        count += static_cast<std::uint32_t>(vaddvq_u64(vshrq_n_u64(lt, 63)));
+    }
+#endif
+
+    for (; i < n; ++i) {
+        count += Inclusive ? keys[i] <= value : keys[i] < value;
+    }
+
+    return count;
+}
+
+BPlusTree::BPlusTree(): root{nullptr}, head{nullptr}, size{0}, levels{0} {
+
+}
+
+// Sorts and deduplicates a copy of values, then builds each level from the one
+// below. Nodes are filled evenly, so every node but the root has at least
+// min_keys keys.
+BPlusTree::BPlusTree(const double* values, std::size_t n): root{nullptr}, head{nullptr}, size{0}, levels{0} {
+    std::vector<double> sorted(values, values + n);
+    std::sort(sorted.begin(), sorted.end());
+    sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+
+    if (sorted.empty()) {
+        return;
+    }
+
+    size = sorted.size();
+    std::size_t groups{(size + capacity - 1) / capacity};
+    std::vector<Node*> nodes(groups);
+    std::vector<double> lows(groups);
+    Leaf* prev{nullptr};
+    std::size_t start{0};
+
+    for (std::size_t g{0}; g < groups; ++g) {
+        std::size_t end{size * (g + 1) / groups};
+        Leaf* leaf{new Leaf{}};
+        leaf->leaf = true;
+        leaf->count = static_cast<std::uint32_t>(end - start);
+        std::copy(sorted.begin() + start, sorted.begin() + end, leaf->keys);
+
+        if (prev == nullptr) {
+            head = leaf;
+        } else {
+            prev->next = leaf;
+        }
+
+        prev = leaf;
+        nodes[g] = leaf;
+        lows[g] = sorted[start];
+        start = end;
+    }
+
+    levels = 1;
+
+    while (nodes.size() > 1) {
+        groups = (nodes.size() + capacity) / (capacity + 1);
+        std::vector<Node*> parents(groups);
+        std::vector<double> parent_lows(groups);
+        start = 0;
+
+        for (std::size_t g{0}; g < groups; ++g) {
+            std::size_t end{nodes.size() * (g + 1) / groups};
+            Inner* inner{new Inner{}};
+            inner->leaf = false;
+            inner->count = static_cast<std::uint32_t>(end - start - 1);
+
+            for (std::size_t j{start}; j < end; ++j) {
+                inner->children[j - start] = nodes[j];
+
+                if (j > start) {
+                    inner->keys[j - start - 1] = lows[j];
+                }
+            }
+
+            parents[g] = inner;
+            parent_lows[g] = lows[start];
+            start = end;
+        }
+
+        nodes.swap(parents);
+        lows.swap(parent_lows);
+        ++levels;
+    }
+
+    root = nodes[0];
+}
+
+BPlusTree::BPlusTree(const BPlusTree& orig): root{nullptr}, head{nullptr}, size{orig.size}, levels{orig.levels} {
+    Leaf* prev_leaf{nullptr};
+    root = clone(orig.root, prev_leaf);
+
+    Node* curr{root};
+
+    while (curr != nullptr && !curr->leaf) {
+        curr = static_cast<Inner*>(curr)->children[0];
+    }
+
+    head = static_cast<Leaf*>(curr);
+}
+
+BPlusTree::BPlusTree(BPlusTree&& orig) noexcept: root{orig.root}, head{orig.head}, size{orig.size}, levels{orig.levels} {
+    orig.root = nullptr;
+    orig.head = nullptr;
+    orig.size = 0;
+    orig.levels = 0;
+}
+
+BPlusTree& BPlusTree::operator=(const BPlusTree& rhs) {
+    if (this == &rhs) {
+        return *this;
+    }
+
+    BPlusTree copy{rhs};
+    *this = std::move(copy);
+
+    return *this;
+}
+
+BPlusTree& BPlusTree::operator=(BPlusTree&& rhs) noexcept {
+    if (this == &rhs) {
+        return *this;
+    }
+
+    clear();
+    root = rhs.root;
+    head = rhs.head;
+    size = rhs.size;
+    levels = rhs.levels;
+    rhs.root = nullptr;
+    rhs.head = nullptr;
+    rhs.size = 0;
+    rhs.levels = 0;
+
+    return *this;
+}
+
+BPlusTree::~BPlusTree() {
+    clear();
+}
+
+void BPlusTree::clear() {
+    clear(root);
+    root = nullptr;
+    head = nullptr;
+    size = 0;
+    levels = 0;
+}
+
+std::size_t BPlusTree::get_size() const {
+    return size;
+}
+
+bool BPlusTree::empty() const {
+    return size == 0;
+}
+
+void BPlusTree::insert(double value) {
+    if (root == nullptr) {
+        Leaf* leaf{new Leaf{}};
+        leaf->leaf = true;
+        root = leaf;
+        head = leaf;
+        levels = 1;
+    }
+
+    double separator{0.0};
+    Node* split{insert(root, value, separator)};
+
+    if (split != nullptr) {
+        Inner* new_root{new Inner{}};
+        new_root->leaf = false;
+        new_root->count = 1;
+        new_root->keys[0] = separator;
+        new_root->children[0] = root;
+        new_root->children[1] = split;
+        root = new_root;
+        ++levels;
+    }
+}
+
+bool BPlusTree::contains(double value) const {
+    std::uint32_t pos{0};
+    const Leaf* leaf{lower_leaf(value, pos)};
+
+    return leaf != nullptr && pos < leaf->count && leaf->keys[pos] == value;
+}
+
+double BPlusTree::min() const {
+    assert(!empty());
+
+    return head->keys[0];
+}
+
+double BPlusTree::max() const {
+    assert(!empty());
+    const Node* curr{root};
+
+    while (!curr->leaf) {
+        curr = static_cast<const Inner*>(curr)->children[curr->count];
+    }
+
+    return static_cast<const Leaf*>(curr)->keys[curr->count - 1];
+}
+
+std::size_t BPlusTree::height() const {
+    return levels;
+}
+
+void BPlusTree::inorder_print() const {
+    for (const Leaf* leaf{head}; leaf != nullptr; leaf = leaf->next) {
+        for (std::uint32_t i{0}; i < leaf->count; ++i) {
+            std::cout << leaf->keys[i] << " ";
+        }
+    }
+
+    std::cout << "\n";
+}
+
+void BPlusTree::erase(double value) {
+    if (root == nullptr || !erase(root, value)) {
+        return;
+    }
+
+    --size;
+
+    if (root->count > 0) {
+        return;
+    }
+
+    if (root->leaf) {
+        delete static_cast<Leaf*>(root);
+        root = nullptr;
+        head = nullptr;
+        levels = 0;
+    } else {
+        Inner* old_root{static_cast<Inner*>(root)};
+        root = old_root->children[0];
+        delete old_root;
+        --levels;
+    }
+}
+
+// Checks key order and separator bounds, node fill, that every leaf sits at
+// the same depth, and that the leaf chain holds exactly size keys in order
+bool BPlusTree::is_valid() const {
+    if (root == nullptr) {
+        return size == 0 && head == nullptr && levels == 0;
+    }
+
+    const Leaf* prev_leaf{nullptr};
+
+    if (!is_valid(root, nullptr, nullptr, 0, prev_leaf) || prev_leaf->next != nullptr) {
+        return false;
+    }
+
+    std::size_t count{0};
+    const double* prev_key{nullptr};
+
+    for (const Leaf* leaf{head}; leaf != nullptr; leaf = leaf->next) {
+        for (std::uint32_t i{0}; i < leaf->count; ++i, ++count) {
+            if (prev_key != nullptr && leaf->keys[i] <= *prev_key) {
+                return false;
+            }
+
+            prev_key = &leaf->keys[i];
+        }
+    }
+
+    return count == size;
+}
+
+// Number of keys in [low, high)
+std::size_t BPlusTree::count_range(double low, double high) const {
+    std::size_t count{0};
+    for_each_in_range(low, high, [&](double) { ++count; });
+
+    return count;
+}
+
+BPlusTree::Node* BPlusTree::clone(const Node* curr, Leaf*& prev_leaf) const {
+    if (curr == nullptr) {
+        return nullptr;
+    }
+
+    if (curr->leaf) {
+        Leaf* leaf{new Leaf(*static_cast<const Leaf*>(curr))};
+        leaf->next = nullptr;
+
+        if (prev_leaf != nullptr) {
+            prev_leaf->next = leaf;
+        }
+
+        prev_leaf = leaf;
+        return leaf;
+    }
+
+    Inner* inner{new Inner(*static_cast<const Inner*>(curr))};
+
+    for (std::uint32_t i{0}; i <= inner->count; ++i) {
+        inner->children[i] = clone(inner->children[i], prev_leaf);
+    }
+
+    return inner;
+}
+
+void BPlusTree::clear(Node* curr) {
+    if (curr == nullptr) {
+        return;
+    }
+
+    if (curr->leaf) {
+        delete static_cast<Leaf*>(curr);
+        return;
+    }
+
+    Inner* inner{static_cast<Inner*>(curr)};
+
+    for (std::uint32_t i{0}; i <= inner->count; ++i) {
+        clear(inner->children[i]);
+    }
+
+    delete inner;
+}
+
+// Inserts value below curr. If curr had to split, returns the new right
+// sibling and sets separator to the lowest key under it; otherwise nullptr.
+BPlusTree::Node* BPlusTree::insert(Node* curr, double value, double& separator) {
+    if (curr->leaf) {
+        Leaf* leaf{static_cast<Leaf*>(curr)};
+        std::uint32_t pos{count_below<false>(leaf->keys, leaf->count, value)};
+
+        if (pos < leaf->count && leaf->keys[pos] == value) {
+            return nullptr;
+        }
+
+        ++size;
+
+        if (leaf->count < capacity) {
+            std::copy_backward(leaf->keys + pos, leaf->keys + leaf->count, leaf->keys + leaf->count + 1);
+            leaf->keys[pos] = value;
+            ++leaf->count;
+            return nullptr;
+        }
+
+        Leaf* right{new Leaf{}};
+        right->leaf = true;
+        right->count = capacity - min_keys;
+        std::copy(leaf->keys + min_keys, leaf->keys + capacity, right->keys);
+        leaf->count = min_keys;
+        right->next = leaf->next;
+        leaf->next = right;
+        Leaf* target{pos <= min_keys ? leaf : right};
+        pos = pos <= min_keys ? pos : pos - min_keys;
+        std::copy_backward(target->keys + pos, target->keys + target->count, target->keys + target->count + 1);
+        target->keys[pos] = value;
+        ++target->count;
+        separator = right->keys[0];
+
+        return right;
+    }
+
+    Inner* inner{static_cast<Inner*>(curr)};
+    std::uint32_t i{count_below<true>(inner->keys, inner->count, value)};
+    double child_separator{0.0};
+    Node* split{insert(inner->children[i], value, child_separator)};
+
+    if (split == nullptr) {
+        return nullptr;
+    }
+
+    if (inner->count < capacity) {
+        std::copy_backward(inner->keys + i, inner->keys + inner->count, inner->keys + inner->count + 1);
+        std::copy_backward(inner->children + i + 1, inner->children + inner->count + 1, inner->children + inner->count + 2);
+        inner->keys[i] = child_separator;
+        inner->children[i + 1] = split;
+        ++inner->count;
+        return nullptr;
+    }
+
+    // Lay out all capacity + 1 keys in order, then push the middle one up
+    double all_keys[capacity + 1];
+    Node* all_children[capacity + 2];
+    std::copy(inner->keys, inner->keys + i, all_keys);
+    all_keys[i] = child_separator;
+    std::copy(inner->keys + i, inner->keys + capacity, all_keys + i + 1);
+    std::copy(inner->children, inner->children + i + 1, all_children);
+    all_children[i + 1] = split;
+    std::copy(inner->children + i + 1, inner->children + capacity + 1, all_children + i + 2);
+
+    Inner* right{new Inner{}};
+    right->leaf = false;
+    right->count = capacity - min_keys;
+    std::copy(all_keys + min_keys + 1, all_keys + capacity + 1, right->keys);
+    std::copy(all_children + min_keys + 1, all_children + capacity + 2, right->children);
+    inner->count = min_keys;
+    std::copy(all_keys, all_keys + min_keys, inner->keys);
+    std::copy(all_children, all_children + min_keys + 1, inner->children);
+    separator = all_keys[min_keys];
+
+    return right;
+}
+
+// Separators left behind by an erased key still route correctly, so they are
+// only rewritten when keys move between siblings
+bool BPlusTree::erase(Node* curr, double value) {
+    if (curr->leaf) {
+        Leaf* leaf{static_cast<Leaf*>(curr)};
+        std::uint32_t pos{count_below<false>(leaf->keys, leaf->count, value)};
+
+        if (pos == leaf->count || leaf->keys[pos] != value) {
+            return false;
+        }
+
+        std::copy(leaf->keys + pos + 1, leaf->keys + leaf->count, leaf->keys + pos);
+        --leaf->count;
+        return true;
+    }
+
+    Inner* inner{static_cast<Inner*>(curr)};
+    std::uint32_t i{count_below<true>(inner->keys, inner->count, value)};
+
+    if (!erase(inner->children[i], value)) {
+        return false;
+    }
+
+    if (inner->children[i]->count < min_keys) {
+        fix_underflow(inner, i);
+    }
+
+    return true;
+}
+
+// Refills parent->children[i] by taking one key from a sibling that can spare
+// it, or else merges it with a sibling, always into the left node of the pair
+void BPlusTree::fix_underflow(Inner* parent, std::uint32_t i) {
+    if (parent->children[i]->leaf) {
+        Leaf* child{static_cast<Leaf*>(parent->children[i])};
+        Leaf* left{i > 0 ? static_cast<Leaf*>(parent->children[i - 1]) : nullptr};
+        Leaf* right{i < parent->count ? static_cast<Leaf*>(parent->children[i + 1]) : nullptr};
+
+        if (left != nullptr && left->count > min_keys) {
+            std::copy_backward(child->keys, child->keys + child->count, child->keys + child->count + 1);
+            child->keys[0] = left->keys[--left->count];
+            ++child->count;
+            parent->keys[i - 1] = child->keys[0];
+            return;
+        }
+
+        if (right != nullptr && right->count > min_keys) {
+            child->keys[child->count++] = right->keys[0];
+            std::copy(right->keys + 1, right->keys + right->count, right->keys);
+            --right->count;
+            parent->keys[i] = right->keys[0];
+            return;
+        }
+
+        if (left == nullptr) {
+            left = child;
+            child = right;
+            ++i;
+        }
+
+        std::copy(child->keys, child->keys + child->count, left->keys + left->count);
+        left->count += child->count;
+        left->next = child->next;
+        delete child;
+    } else {
+        Inner* child{static_cast<Inner*>(parent->children[i])};
+        Inner* left{i > 0 ? static_cast<Inner*>(parent->children[i - 1]) : nullptr};
+        Inner* right{i < parent->count ? static_cast<Inner*>(parent->children[i + 1]) : nullptr};
+
+        if (left != nullptr && left->count > min_keys) {
+            std::copy_backward(child->keys, child->keys + child->count, child->keys + child->count + 1);
+            std::copy_backward(child->children, child->children + child->count + 1, child->children + child->count + 2);
+            child->keys[0] = parent->keys[i - 1];
+            child->children[0] = left->children[left->count];
+            ++child->count;
+            parent->keys[i - 1] = left->keys[--left->count];
+            return;
+        }
+
+        if (right != nullptr && right->count > min_keys) {
+            child->keys[child->count] = parent->keys[i];
+            child->children[child->count + 1] = right->children[0];
+            ++child->count;
+            parent->keys[i] = right->keys[0];
+            std::copy(right->keys + 1, right->keys + right->count, right->keys);
+            std::copy(right->children + 1, right->children + right->count + 1, right->children);
+            --right->count;
+            return;
+        }
+
+        if (left == nullptr) {
+            left = child;
+            child = right;
+            ++i;
+        }
+
+        left->keys[left->count] = parent->keys[i - 1];
+        std::copy(child->keys, child->keys + child->count, left->keys + left->count + 1);
+        std::copy(child->children, child->children + child->count + 1, left->children + left->count + 1);
+        left->count += child->count + 1;
+        delete child;
+    }
+
+    // Drop the separator and pointer of the node that was merged away
+    std::copy(parent->keys + i, parent->keys + parent->count, parent->keys + i - 1);
+    std::copy(parent->children + i + 1, parent->children + parent->count + 1, parent->children + i);
+    --parent->count;
+}
+
+// The leaf and position of the first key >= value. The position may be one
+// past the leaf's last key, in which case the answer starts at the next leaf.
+const BPlusTree::Leaf* BPlusTree::lower_leaf(double value, std::uint32_t& pos) const {
+    const Node* curr{root};
+
+    if (curr == nullptr) {
+        return nullptr;
+    }
+
+    while (!curr->leaf) {
+        const Inner* inner{static_cast<const Inner*>(curr)};
+        curr = inner->children[count_below<true>(inner->keys, inner->count, value)];
+    }
+
+    const Leaf* leaf{static_cast<const Leaf*>(curr)};
+    pos = count_below<false>(leaf->keys, leaf->count, value);
+
+    return leaf;
+}
+
+bool BPlusTree::is_valid(const Node* curr, const double* low, const double* high, std::size_t depth, const Leaf*& prev_leaf) const {
+    const double* keys{curr->leaf ? static_cast<const Leaf*>(curr)->keys : static_cast<const Inner*>(curr)->keys};
+
+    if (curr->count > capacity || curr->count < (curr == root ? 1 : min_keys)) {
+        return false;
+    }
+
+    for (std::uint32_t i{0}; i < curr->count; ++i) {
+        if ((i > 0 && keys[i] <= keys[i - 1]) || (low != nullptr && keys[i] < *low) || (high != nullptr && keys[i] >= *high)) {
+            return false;
+        }
+    }
+
+    if (curr->leaf) {
+        const Leaf* leaf{static_cast<const Leaf*>(curr)};
+
+        if (depth + 1 != levels || (prev_leaf == nullptr ? head != leaf : prev_leaf->next != leaf)) {
+            return false;
+        }
+
+        prev_leaf = leaf;
+        return true;
+    }
+
+    const Inner* inner{static_cast<const Inner*>(curr)};
+
+    for (std::uint32_t i{0}; i <= inner->count; ++i) {
+        const double* child_low{i == 0 ? low : &inner->keys[i - 1]};
+        const double* child_high{i == inner->count ? high : &inner->keys[i]};
+
+        if (!is_valid(inner->children[i], child_low, child_high, depth + 1, prev_leaf)) {
+            return false;
+        }
+    }
+
+    return true;
+}
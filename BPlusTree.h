@@ -0,0 +1,86 @@
+#ifndef BPLUSTREE_H
+#define BPLUSTREE_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Ordered set of doubles with the BinarySearchTree API, stored as a B+tree.
+// Every node holds up to 32 keys in a few cache lines and is searched with
+// SIMD compares, so a lookup costs one or two misses per level over about
+// log32(n) levels instead of one per level over log2(n). All keys live in the
+// leaves, which are chained in order, so a range scan walks arrays rather
+// than chasing pointers. The bulk constructor sorts its input and builds full
+// leaves bottom-up in O(n log n).
+class BPlusTree {
+    private:
+        static constexpr std::uint32_t capacity{32}; // Keys per node
+        static constexpr std::uint32_t min_keys{capacity / 2}; // Below this a non-root node borrows or merges
+
+        struct Node {
+            std::uint32_t count;
+            bool leaf;
+        };
+
+        struct alignas(64) Leaf : Node {
+            double keys[capacity];
+            Leaf* next;
+        };
+
+        struct alignas(64) Inner : Node {
+            double keys[capacity]; // Every key in children[i + 1] is >= keys[i], every key in children[i] is < it
+            Node* children[capacity + 1];
+        };
+
+    public:
+        BPlusTree();
+        BPlusTree(const double* values, std::size_t n);
+        BPlusTree(const BPlusTree& orig);
+        BPlusTree(BPlusTree&& orig) noexcept;
+        BPlusTree& operator=(const BPlusTree& rhs);
+        BPlusTree& operator=(BPlusTree&& rhs) noexcept;
+        ~BPlusTree();
+        void clear();
+        std::size_t get_size() const;
+        bool empty() const;
+        void insert(double value);
+        bool contains(double value) const;
+        double min() const;
+        double max() const;
+        std::size_t height() const;
+        void inorder_print() const;
+        void erase(double value);
+        bool is_valid() const;
+        std::size_t count_range(double low, double high) const;
+
+        // Calls f(key) for every key in [low, high) in ascending order, matching
+        // BinarySearchTree::count_range
+        template <typename F>
+        void for_each_in_range(double low, double high, F&& f) const {
+            std::uint32_t pos{0};
+
+            for (const Leaf* leaf{lower_leaf(low, pos)}; leaf != nullptr; leaf = leaf->next, pos = 0) {
+                for (; pos < leaf->count; ++pos) {
+                    if (leaf->keys[pos] >= high) {
+                        return;
+                    }
+
+                    f(leaf->keys[pos]);
+                }
+            }
+        }
+
+    private:
+        Node* root;
+        Leaf* head; // Leftmost leaf; never freed by a merge, which always keeps the left node
+        std::size_t size;
+        std::size_t levels;
+        Node* clone(const Node* curr, Leaf*& prev_leaf) const;
+        void clear(Node* curr);
+        Node* insert(Node* curr, double value, double& separator);
+        bool erase(Node* curr, double value);
+        void fix_underflow(Inner* parent, std::uint32_t i);
+        const Leaf* lower_leaf(double value, std::uint32_t& pos) const;
+        bool is_valid(const Node* curr, const double* low, const double* high, std::size_t depth, const Leaf*& prev_leaf) const;
+};
+
+#endif
@@ -1,100 +1,172 @@
 #include "BinarySearchTree.h"
 
 #include <iostream>
+#include <algorithm>
 #include <cassert>
+#include <functional>
+#include <new>
+#include <thread>
+#include <vector>
+
+// Contiguous stack for the tree walks. The first 64 entries live inside the
+// object, which covers any walk of a reasonably balanced tree without touching
+// the heap; deeper walks double a heap array.
+template <typename T>
+class WalkStack {
+    public:
+        WalkStack(): items{local}, size{0}, capacity{local_capacity} {
 
-class PtrNode {
-    private:
-        PtrNode(const Node* value, PtrNode* new_next): data{value}, next{new_next} {
+        }
 
+        WalkStack(const WalkStack& orig) = delete;
+        WalkStack(WalkStack&& orig) noexcept = delete;
+        WalkStack& operator=(const WalkStack& rhs) = delete;
+        WalkStack& operator=(WalkStack&& rhs) noexcept = delete;
+
+        ~WalkStack() {
+            if (items != local) {
+                delete[] items;
+            }
         }
 
-        const Node* data;
-        PtrNode* next;
+        bool empty() const {
+            return size == 0;
+        }
 
-    friend class PtrQueue;
-};
+        void push(const T& x) {
+            if (size == capacity) {
+                grow();
+            }
 
-class PtrQueue {
-    public:
-        PtrQueue(): head{nullptr}, tail{nullptr} {
+            items[size++] = x;
+        }
 
+        T pop() {
+            assert(!empty());
+            return items[--size];
         }
 
-        PtrQueue(const PtrQueue& orig) = delete;
-        PtrQueue(PtrQueue&& orig) noexcept = delete;
-        PtrQueue& operator=(const PtrQueue& rhs) = delete;
-        PtrQueue& operator=(PtrQueue&& rhs) noexcept = delete;
+        const T& top() const {
+            assert(!empty());
+            return items[size - 1];
+        }
 
-        ~PtrQueue() {
-            while (!empty()) {
-                dequeue();
+    private:
+        static constexpr std::size_t local_capacity{64};
+        T local[local_capacity];
+        T* items;
+        std::size_t size;
+        std::size_t capacity;
+
+        void grow() {
+            T* bigger{new T[capacity * 2]};
+            std::copy(items, items + size, bigger);
+
+            if (items != local) {
+                delete[] items;
             }
-        }
 
-        bool empty() const {
-            return head == nullptr;
+            items = bigger;
+            capacity *= 2;
         }
+};
 
-        void enqueue(const Node* x) {
-            if (empty()) {
-                head = new PtrNode{x, nullptr};
-                tail = head;
-                return;
-            }
+// Ring buffer queue for level order, with the same inline first 64 slots
+template <typename T>
+class WalkQueue {
+    public:
+        WalkQueue(): items{local}, head{0}, size{0}, capacity{local_capacity} {
 
-            tail->next = new PtrNode{x, nullptr};
-            tail = tail->next;
         }
 
-        void dequeue() {
-            if (empty()) {
-                return;
+        WalkQueue(const WalkQueue& orig) = delete;
+        WalkQueue(WalkQueue&& orig) noexcept = delete;
+        WalkQueue& operator=(const WalkQueue& rhs) = delete;
+        WalkQueue& operator=(WalkQueue&& rhs) noexcept = delete;
+
+        ~WalkQueue() {
+            if (items != local) {
+                delete[] items;
             }
+        }
 
-            PtrNode* temp{head};
-            head = head->next;
-            delete temp;
+        bool empty() const {
+            return size == 0;
+        }
 
-            if (head == nullptr) {
-                tail = nullptr;
+        void enqueue(const T& x) {
+            if (size == capacity) {
+                grow();
             }
+
+            items[(head + size) & (capacity - 1)] = x;
+            ++size;
         }
 
-        const Node* front() const {
+        T dequeue() {
             assert(!empty());
-            return head->data;
+            T x{items[head]};
+            head = (head + 1) & (capacity - 1);
+            --size;
+
+            return x;
         }
 
     private:
-        PtrNode* head;
-        PtrNode* tail;
+        static constexpr std::size_t local_capacity{64}; // Power of two, as is every later capacity
+        T local[local_capacity];
+        T* items;
+        std::size_t head;
+        std::size_t size;
+        std::size_t capacity;
+
+        void grow() {
+            T* bigger{new T[capacity * 2]};
+
+            for (std::size_t i{0}; i < size; ++i) {
+                bigger[i] = items[(head + i) & (capacity - 1)];
+            }
+
+            if (items != local) {
+                delete[] items;
+            }
+
+            items = bigger;
+            head = 0;
+            capacity *= 2;
+        }
 };
 
 class Node {
     private:
-        Node(double value): data{value}, left{nullptr}, right{nullptr} {
+        Node(double value, Node* new_parent): data{value}, left{nullptr}, right{nullptr}, parent{new_parent}, count{1} {
 
         }
 
         double data;
         Node* left;
         Node* right;
+        Node* parent; // Lets iterators step to the next or previous key without a stack
+        std::size_t count; // Nodes in this subtree, for rank and select
 
     friend class BinarySearchTree;
 };
 
-BinarySearchTree::BinarySearchTree(): root{nullptr}, size{0} {
+BinarySearchTree::BinarySearchTree(): root{nullptr}, size{0}, block{nullptr}, block_size{0}, mode{AccessMode::Static}, splay_depth{0} {
 
 }
 
-BinarySearchTree::BinarySearchTree(const BinarySearchTree& orig): root{clone(orig.root)}, size{orig.size} {
+BinarySearchTree::BinarySearchTree(const BinarySearchTree& orig): root{clone(orig.root)}, size{orig.size}, block{nullptr}, block_size{0},
+                                                                  mode{orig.mode}, splay_depth{orig.splay_depth} {
 
 }
 
-BinarySearchTree::BinarySearchTree(BinarySearchTree&& orig) noexcept: root{orig.root}, size{orig.size} {
+BinarySearchTree::BinarySearchTree(BinarySearchTree&& orig) noexcept: root{orig.root}, size{orig.size}, block{orig.block},
+                                                                      block_size{orig.block_size}, mode{orig.mode}, splay_depth{orig.splay_depth} {
     orig.root = nullptr;
     orig.size = 0;
+    orig.block = nullptr;
+    orig.block_size = 0;
 }
 
 BinarySearchTree& BinarySearchTree::operator=(const BinarySearchTree& rhs) {
@@ -105,6 +177,8 @@ BinarySearchTree& BinarySearchTree::operator=(const BinarySearchTree& rhs) {
     clear();
     root = clone(rhs.root);
     size = rhs.size;
+    mode = rhs.mode;
+    splay_depth = rhs.splay_depth;
 
     return *this;
 }
@@ -117,8 +191,14 @@ BinarySearchTree& BinarySearchTree::operator=(BinarySearchTree&& rhs) noexcept {
     clear();
     root = rhs.root;
     size = rhs.size;
+    block = rhs.block;
+    block_size = rhs.block_size;
+    mode = rhs.mode;
+    splay_depth = rhs.splay_depth;
     rhs.root = nullptr;
     rhs.size = 0;
+    rhs.block = nullptr;
+    rhs.block_size = 0;
 
     return *this;
 }
@@ -130,6 +210,9 @@ BinarySearchTree::~BinarySearchTree() {
 void BinarySearchTree::clear() {
     clear(root);
     size = 0;
+    ::operator delete(block);
+    block = nullptr;
+    block_size = 0;
 }
 
 std::size_t BinarySearchTree::get_size() const {
@@ -142,33 +225,41 @@ bool BinarySearchTree::empty() const {
 
 void BinarySearchTree::insert(double value) {
     if (root == nullptr) {
-        root = new Node{value};
+        root = new Node{value, nullptr};
         ++size;
         return;
     }
 
     Node* curr{root};
+    std::size_t depth{0};
 
     while (true) {
         if (value == curr->data) {
+            adjust(curr, depth);
             return;
         } else if (value < curr->data) {
             if (curr->left == nullptr) {
-                curr->left = new Node{value};
+                curr->left = new Node{value, curr};
                 ++size;
+                add_to_counts(curr, 1);
+                adjust(curr->left, depth + 1);
                 return;
             } else {
                 curr = curr->left;
             }
         } else {
             if (curr->right == nullptr) {
-                curr->right = new Node{value};
+                curr->right = new Node{value, curr};
                 ++size;
+                add_to_counts(curr, 1);
+                adjust(curr->right, depth + 1);
                 return;
             } else {
                 curr = curr->right;
             }
         }
+
+        ++depth;
     }
 }
 
@@ -225,22 +316,22 @@ std::size_t BinarySearchTree::height() const {
 }
 
 void BinarySearchTree::inorder_print() const {
-    inorder_print(root);
+    walk_inorder(root, [](const Node* curr) { std::cout << curr->data << " "; });
     std::cout << "\n";
 }
 
 void BinarySearchTree::preorder_print() const {
-    preorder_print(root);
+    walk_preorder(root, [](const Node* curr) { std::cout << curr->data << " "; });
     std::cout << "\n";
 }
 
 void BinarySearchTree::postorder_print() const {
-    postorder_print(root);
+    walk_postorder(root, [](const Node* curr) { std::cout << curr->data << " "; });
     std::cout << "\n";
 }
 
 void BinarySearchTree::levelorder_print() const {
-    levelorder_print(root);
+    walk_levelorder(root, [](const Node* curr) { std::cout << curr->data << " "; });
     std::cout << "\n";
 }
 
@@ -248,155 +339,627 @@ void BinarySearchTree::erase(double value) {
     erase(root, value);
 }
 
+// Valid exactly when the in-order walk is strictly increasing
 bool BinarySearchTree::is_valid_bst() const {
-    return is_valid_bst(root, nullptr, nullptr);
+    const Node* prev{nullptr};
+    bool valid{root == nullptr || root->parent == nullptr};
+
+    // Rotations relink parents and recount subtrees, so check those too
+    walk_inorder(root, [&](const Node* curr) {
+        valid = valid && (prev == nullptr || prev->data < curr->data)
+                      && (curr->left == nullptr || curr->left->parent == curr)
+                      && (curr->right == nullptr || curr->right->parent == curr)
+                      && curr->count == 1 + count_of(curr->left) + count_of(curr->right);
+        prev = curr;
+    });
+
+    return valid;
 }
 
-Node* BinarySearchTree::clone(const Node* curr) const {
+// In Splay mode, keys found at depth >= min_depth (the root is depth 0) are
+// splayed to the root; min_depth 0 gives a classic splay tree
+void BinarySearchTree::set_access_mode(AccessMode new_mode, std::size_t min_depth) {
+    mode = new_mode;
+    splay_depth = min_depth;
+}
+
+BinarySearchTree::AccessMode BinarySearchTree::get_access_mode() const {
+    return mode;
+}
+
+// contains() that, in Splay mode, also splays the key found, or on a miss the
+// last node visited, so a run of misses near one spot gets cheaper too
+bool BinarySearchTree::access(double value) {
+    Node* curr{root};
+    Node* last{nullptr};
+    std::size_t depth{0};
+
+    while (curr != nullptr && curr->data != value) {
+        last = curr;
+        curr = value < curr->data ? curr->left : curr->right;
+        ++depth;
+    }
+
+    if (curr != nullptr) {
+        adjust(curr, depth);
+    } else if (last != nullptr) {
+        adjust(last, depth - 1);
+    }
+
+    return curr != nullptr;
+}
+
+BinarySearchTree::Iterator BinarySearchTree::begin() const {
+    const Node* curr{root};
+
+    while (curr != nullptr && curr->left != nullptr) {
+        curr = curr->left;
+    }
+
+    return Iterator{this, curr};
+}
+
+BinarySearchTree::Iterator BinarySearchTree::end() const {
+    return Iterator{this, nullptr};
+}
+
+BinarySearchTree::reverse_iterator BinarySearchTree::rbegin() const {
+    return reverse_iterator{end()};
+}
+
+BinarySearchTree::reverse_iterator BinarySearchTree::rend() const {
+    return reverse_iterator{begin()};
+}
+
+// Builds a perfectly balanced tree from strictly ascending keys in O(n), with
+// every node in one allocation. With threads > 1 the top subtrees are built
+// on separate threads.
+BinarySearchTree BinarySearchTree::build_from_sorted(const double* keys, std::size_t n, unsigned threads) {
+    assert(std::adjacent_find(keys, keys + n, std::greater_equal<double>{}) == keys + n);
+    BinarySearchTree tree;
+
+    if (n == 0) {
+        return tree;
+    }
+
+    tree.block = static_cast<Node*>(::operator new(n * sizeof(Node)));
+    tree.block_size = n;
+    tree.size = n;
+    tree.root = build(tree.block, keys, 0, n, nullptr, threads == 0 ? 1 : threads);
+
+    return tree;
+}
+
+// Sorts and deduplicates a copy of keys, then builds as build_from_sorted
+BinarySearchTree BinarySearchTree::build_from_unsorted(const double* keys, std::size_t n, unsigned threads) {
+    std::vector<double> sorted(keys, keys + n);
+    std::sort(sorted.begin(), sorted.end());
+    sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+
+    return build_from_sorted(sorted.data(), sorted.size(), threads);
+}
+
+// Number of keys < value
+std::size_t BinarySearchTree::rank(double value) const {
+    std::size_t below{0};
+    const Node* curr{root};
+
+    while (curr != nullptr) {
+        if (value <= curr->data) {
+            curr = curr->left;
+        } else {
+            below += count_of(curr->left) + 1;
+            curr = curr->right;
+        }
+    }
+
+    return below;
+}
+
+// The k-th smallest key, counting from 0
+double BinarySearchTree::select(std::size_t k) const {
+    assert(k < size);
+    const Node* curr{root};
+
+    while (true) {
+        std::size_t left{count_of(curr->left)};
+
+        if (k == left) {
+            return curr->data;
+        } else if (k < left) {
+            curr = curr->left;
+        } else {
+            k -= left + 1;
+            curr = curr->right;
+        }
+    }
+}
+
+// Number of keys in [low, high)
+std::size_t BinarySearchTree::count_range(double low, double high) const {
+    return low < high ? rank(high) - rank(low) : 0;
+}
+
+// First key >= value, or end()
+BinarySearchTree::Iterator BinarySearchTree::lower_bound(double value) const {
+    const Node* found{nullptr};
+
+    for (const Node* curr{root}; curr != nullptr; ) {
+        if (curr->data >= value) {
+            found = curr;
+            curr = curr->left;
+        } else {
+            curr = curr->right;
+        }
+    }
+
+    return Iterator{this, found};
+}
+
+// First key > value, or end()
+BinarySearchTree::Iterator BinarySearchTree::upper_bound(double value) const {
+    const Node* found{nullptr};
+
+    for (const Node* curr{root}; curr != nullptr; ) {
+        if (curr->data > value) {
+            found = curr;
+            curr = curr->left;
+        } else {
+            curr = curr->right;
+        }
+    }
+
+    return Iterator{this, found};
+}
+
+// The keys in [low, high), for a range-based for loop
+BinarySearchTree::Range BinarySearchTree::range(double low, double high) const {
+    Iterator first{lower_bound(low)};
+
+    return Range{first, low < high ? lower_bound(high) : first};
+}
+
+// Replaces out's contents with the keys in ascending order
+void BinarySearchTree::to_array(DynamicArray& out) const {
+    out.clear();
+    out.reserve(size);
+    walk_inorder(root, [&out](const Node* curr) { out.push_back(curr->data); });
+}
+
+void BinarySearchTree::visit_inorder(Visitor visit, void* context) const {
+    walk_inorder(root, [=](const Node* curr) { visit(context, curr->data); });
+}
+
+void BinarySearchTree::visit_preorder(Visitor visit, void* context) const {
+    walk_preorder(root, [=](const Node* curr) { visit(context, curr->data); });
+}
+
+void BinarySearchTree::visit_postorder(Visitor visit, void* context) const {
+    walk_postorder(root, [=](const Node* curr) { visit(context, curr->data); });
+}
+
+void BinarySearchTree::visit_levelorder(Visitor visit, void* context) const {
+    walk_levelorder(root, [=](const Node* curr) { visit(context, curr->data); });
+}
+
+const Node* BinarySearchTree::successor(const Node* curr) {
+    if (curr->right != nullptr) {
+        curr = curr->right;
+
+        while (curr->left != nullptr) {
+            curr = curr->left;
+        }
+
+        return curr;
+    }
+
+    while (curr->parent != nullptr && curr->parent->right == curr) {
+        curr = curr->parent;
+    }
+
+    return curr->parent;
+}
+
+// The largest node when curr is nullptr (end)
+const Node* BinarySearchTree::predecessor(const BinarySearchTree* tree, const Node* curr) {
     if (curr == nullptr) {
+        curr = tree->root;
+
+        while (curr->right != nullptr) {
+            curr = curr->right;
+        }
+
+        return curr;
+    }
+
+    if (curr->left != nullptr) {
+        curr = curr->left;
+
+        while (curr->right != nullptr) {
+            curr = curr->right;
+        }
+
+        return curr;
+    }
+
+    while (curr->parent != nullptr && curr->parent->left == curr) {
+        curr = curr->parent;
+    }
+
+    return curr->parent;
+}
+
+// Builds keys[low, high) as a subtree whose root is the middle key. Key i
+// always goes to nodes[i], so subtrees never share memory and can be built
+// concurrently.
+Node* BinarySearchTree::build(Node* nodes, const double* keys, std::size_t low, std::size_t high, Node* parent, unsigned threads) {
+    if (low == high) {
         return nullptr;
     }
 
-    Node* new_node{new Node{curr->data}};
-    new_node->left  = clone(curr->left);
-    new_node->right = clone(curr->right);
+    std::size_t mid{low + (high - low) / 2};
+    Node* curr{new (nodes + mid) Node{keys[mid], parent}};
+    curr->count = high - low;
 
-    return new_node;
+    if (threads > 1 && high - low >= parallel_build_cutoff) {
+        std::thread left_builder{[&] {
+            curr->left = build(nodes, keys, low, mid, curr, threads / 2);
+        }};
+        curr->right = build(nodes, keys, mid + 1, high, curr, threads - threads / 2);
+        left_builder.join();
+    } else {
+        curr->left = build(nodes, keys, low, mid, curr, 1);
+        curr->right = build(nodes, keys, mid + 1, high, curr, 1);
+    }
+
+    return curr;
 }
 
-void BinarySearchTree::clear(Node*& curr) {
-    if (curr == nullptr) {
+// Nodes inside block are freed together by clear(); erase leaves their slots unused until then
+void BinarySearchTree::release(Node* curr) const {
+    std::less<const Node*> before;
+
+    if (block != nullptr && !before(curr, block) && before(curr, block + block_size)) {
         return;
     }
 
-    clear(curr->left);
-    clear(curr->right);
     delete curr;
-    curr = nullptr;
 }
 
-std::size_t BinarySearchTree::height(const Node* curr) const {
-    if (curr == nullptr) {
-        return 0;
+std::size_t BinarySearchTree::count_of(const Node* curr) {
+    return curr == nullptr ? 0 : curr->count;
+}
+
+// Adds delta to the subtree size of curr and every ancestor
+void BinarySearchTree::add_to_counts(Node* curr, int delta) {
+    for (; curr != nullptr; curr = curr->parent) {
+        curr->count += delta;
+    }
+}
+
+// Rotates curr above its parent, keeping parent links and subtree counts
+void BinarySearchTree::rotate_up(Node* curr) {
+    Node* parent{curr->parent};
+    Node* grandparent{parent->parent};
+
+    if (curr == parent->left) {
+        parent->left = curr->right;
+
+        if (curr->right != nullptr) {
+            curr->right->parent = parent;
+        }
+
+        curr->right = parent;
+    } else {
+        parent->right = curr->left;
+
+        if (curr->left != nullptr) {
+            curr->left->parent = parent;
+        }
+
+        curr->left = parent;
     }
 
-    std::size_t l{height(curr->left)};
-    std::size_t r{height(curr->right)};
+    parent->parent = curr;
+    curr->parent = grandparent;
 
-    return 1 + (l >= r ? l : r);
+    if (grandparent == nullptr) {
+        root = curr;
+    } else if (grandparent->left == parent) {
+        grandparent->left = curr;
+    } else {
+        grandparent->right = curr;
+    }
+
+    curr->count = parent->count;
+    parent->count = 1 + count_of(parent->left) + count_of(parent->right);
 }
 
-void BinarySearchTree::inorder_print(const Node* curr) const {
-    if (curr == nullptr) {
+// Splays curr to the root if the tree is in Splay mode and curr is deep
+// enough. Zig-zig steps rotate the parent first, which roughly halves the
+// depth of every node on the path, not just curr's.
+void BinarySearchTree::adjust(Node* curr, std::size_t depth) {
+    if (mode != AccessMode::Splay || depth < splay_depth) {
         return;
     }
 
-    inorder_print(curr->left);
-    std::cout << curr->data << " ";
-    inorder_print(curr->right);
+    while (curr->parent != nullptr) {
+        Node* parent{curr->parent};
+        Node* grandparent{parent->parent};
+
+        if (grandparent == nullptr) {
+            rotate_up(curr);
+        } else if ((curr == parent->left) == (parent == grandparent->left)) {
+            rotate_up(parent);
+            rotate_up(curr);
+        } else {
+            rotate_up(curr);
+            rotate_up(curr);
+        }
+    }
+}
+
+const double& BinarySearchTree::data_of(const Node* curr) {
+    return curr->data;
+}
+
+BinarySearchTree::Iterator::Iterator(const BinarySearchTree* new_tree, const Node* new_node): tree{new_tree}, node{new_node} {
+
+}
+
+const double& BinarySearchTree::Iterator::operator*() const {
+    return data_of(node);
+}
+
+const double* BinarySearchTree::Iterator::operator->() const {
+    return &data_of(node);
 }
 
-void BinarySearchTree::preorder_print(const Node* curr) const {
+BinarySearchTree::Iterator& BinarySearchTree::Iterator::operator++() {
+    node = successor(node);
+    return *this;
+}
+
+BinarySearchTree::Iterator BinarySearchTree::Iterator::operator++(int) {
+    Iterator temp{*this};
+    ++*this;
+    return temp;
+}
+
+// Decrementing begin() is undefined, as for the standard containers
+BinarySearchTree::Iterator& BinarySearchTree::Iterator::operator--() {
+    node = predecessor(tree, node);
+    return *this;
+}
+
+BinarySearchTree::Iterator BinarySearchTree::Iterator::operator--(int) {
+    Iterator temp{*this};
+    --*this;
+    return temp;
+}
+
+Node* BinarySearchTree::clone(const Node* curr) const {
     if (curr == nullptr) {
-        return;
+        return nullptr;
+    }
+
+    struct Step {
+        const Node* from;
+        Node* to;
+    };
+
+    Node* new_root{new Node{curr->data, nullptr}};
+    new_root->count = curr->count;
+    WalkStack<Step> pending;
+    pending.push({curr, new_root});
+
+    while (!pending.empty()) {
+        Step step{pending.pop()};
+
+        if (step.from->left != nullptr) {
+            step.to->left = new Node{step.from->left->data, step.to};
+            step.to->left->count = step.from->left->count;
+            pending.push({step.from->left, step.to->left});
+        }
+
+        if (step.from->right != nullptr) {
+            step.to->right = new Node{step.from->right->data, step.to};
+            step.to->right->count = step.from->right->count;
+            pending.push({step.from->right, step.to->right});
+        }
     }
 
-    std::cout << curr->data << " ";
-    preorder_print(curr->left);
-    preorder_print(curr->right);
+    return new_root;
 }
 
-void BinarySearchTree::postorder_print(const Node* curr) const {
+// Rotates each left child up until the top node has none, then frees it and
+// moves right, so teardown takes O(n) time and no extra memory at any depth
+void BinarySearchTree::clear(Node*& curr) {
+    while (curr != nullptr) {
+        if (curr->left != nullptr) {
+            Node* left{curr->left};
+            curr->left = left->right;
+            left->right = curr;
+            curr = left;
+        } else {
+            Node* right{curr->right};
+            release(curr);
+            curr = right;
+        }
+    }
+}
+
+std::size_t BinarySearchTree::height(const Node* curr) const {
     if (curr == nullptr) {
-        return;
+        return 0;
     }
 
-    postorder_print(curr->left);
-    postorder_print(curr->right);
-    std::cout << curr->data << " ";
+    struct Step {
+        const Node* node;
+        std::size_t depth;
+    };
+
+    std::size_t deepest{0};
+    WalkStack<Step> pending;
+    pending.push({curr, 1});
+
+    while (!pending.empty()) {
+        Step step{pending.pop()};
+        deepest = step.depth > deepest ? step.depth : deepest;
+
+        if (step.node->left != nullptr) {
+            pending.push({step.node->left, step.depth + 1});
+        }
+
+        if (step.node->right != nullptr) {
+            pending.push({step.node->right, step.depth + 1});
+        }
+    }
+
+    return deepest;
 }
 
-void BinarySearchTree::levelorder_print(const Node* curr) const {
+// Writes the keys in ascending order starting at out, advancing out past them
+void BinarySearchTree::inorder_copy(const Node* curr, double*& out) const {
+    walk_inorder(curr, [&](const Node* node) { *out++ = node->data; });
+}
+
+template <typename F>
+void BinarySearchTree::walk_inorder(const Node* curr, F&& visit) const {
+    WalkStack<const Node*> pending;
+
+    while (curr != nullptr || !pending.empty()) {
+        while (curr != nullptr) {
+            pending.push(curr);
+            curr = curr->left;
+        }
+
+        curr = pending.pop();
+        visit(curr);
+        curr = curr->right;
+    }
+}
+
+template <typename F>
+void BinarySearchTree::walk_preorder(const Node* curr, F&& visit) const {
     if (curr == nullptr) {
         return;
     }
 
-    PtrQueue q;
-    q.enqueue(curr);
+    WalkStack<const Node*> pending;
+    pending.push(curr);
 
-    while (!q.empty()) {
-        const Node* temp{q.front()};
-        q.dequeue();
-        std::cout << temp->data << " ";
+    while (!pending.empty()) {
+        curr = pending.pop();
+        visit(curr);
 
-        if (temp->left != nullptr) {
-            q.enqueue(temp->left);
+        if (curr->right != nullptr) {
+            pending.push(curr->right);
         }
 
-        if(temp->right != nullptr) {
-            q.enqueue(temp->right);
+        if (curr->left != nullptr) {
+            pending.push(curr->left);
         }
     }
 }
 
-void BinarySearchTree::erase(Node*& curr, double value) {
-    if (curr == nullptr) {
-        return;
-    } else if (value == curr->data) {
-        if (curr->left == nullptr && curr->right == nullptr) {
-            delete curr;
-            curr = nullptr;
-            --size;
-        } else if (curr->left == nullptr) {
-            Node* temp{curr};
-            curr = curr->right;
-            delete temp;
-            --size;
-        } else if (curr->right == nullptr) {
-            Node* temp{curr};
+// A node is visited once its right subtree is done, which is when the walk
+// comes back up from its right child (or it has none)
+template <typename F>
+void BinarySearchTree::walk_postorder(const Node* curr, F&& visit) const {
+    WalkStack<const Node*> pending;
+    const Node* last{nullptr};
+
+    while (curr != nullptr || !pending.empty()) {
+        if (curr != nullptr) {
+            pending.push(curr);
             curr = curr->left;
-            delete temp;
-            --size;
+        } else if (pending.top()->right != nullptr && pending.top()->right != last) {
+            curr = pending.top()->right;
         } else {
-            Node* prev{curr};
-            Node* temp{curr->right};
+            last = pending.pop();
+            visit(last);
+        }
+    }
+}
 
-            while (temp->left != nullptr) {
-                prev = temp;
-                temp = temp->left;
-            }
+template <typename F>
+void BinarySearchTree::walk_levelorder(const Node* curr, F&& visit) const {
+    if (curr == nullptr) {
+        return;
+    }
 
-            curr->data = temp->data;
+    WalkQueue<const Node*> pending;
+    pending.enqueue(curr);
 
-            if (prev->left == temp) {
-                prev->left = temp->right;
-            } else {
-                prev->right = temp->right;
-            }
+    while (!pending.empty()) {
+        curr = pending.dequeue();
+        visit(curr);
 
-            delete temp;
-            --size;
+        if (curr->left != nullptr) {
+            pending.enqueue(curr->left);
+        }
+
+        if (curr->right != nullptr) {
+            pending.enqueue(curr->right);
         }
-    } else if (value < curr->data) {
-        erase(curr->left, value);
-    } else {
-        erase(curr->right, value);
     }
 }
 
-bool BinarySearchTree::is_valid_bst(const Node* curr, const Node* min_node, const Node* max_node) const {
-    if (curr == nullptr) {
-        return true;
-    }
+void BinarySearchTree::erase(Node*& curr, double value) {
+    Node** link{&curr};
 
-    if (min_node != nullptr && curr->data <= min_node->data) {
-        return false;
+    while (*link != nullptr && (*link)->data != value) {
+        link = value < (*link)->data ? &(*link)->left : &(*link)->right;
     }
 
-    if (max_node != nullptr && curr->data >= max_node->data) {
-        return false;
+    Node* target{*link};
+
+    if (target == nullptr) {
+        return;
+    } else if (target->left == nullptr || target->right == nullptr) {
+        Node* child{target->left == nullptr ? target->right : target->left};
+
+        if (child != nullptr) {
+            child->parent = target->parent;
+        }
+
+        *link = child;
+        add_to_counts(target->parent, -1);
+        release(target);
+    } else {
+        // Move the successor node itself into target's place, so iterators to
+        // every other key keep pointing at the key they had
+        Node* successor{target->right};
+
+        while (successor->left != nullptr) {
+            successor = successor->left;
+        }
+
+        if (successor != target->right) {
+            Node* successor_parent{successor->parent};
+            successor_parent->left = successor->right;
+
+            if (successor->right != nullptr) {
+                successor->right->parent = successor_parent;
+            }
+
+            for (Node* above{successor_parent}; above != target; above = above->parent) {
+                --above->count;
+            }
+
+            successor->right = target->right;
+            successor->right->parent = successor;
+        }
+
+        successor->left = target->left;
+        successor->left->parent = successor;
+        successor->parent = target->parent;
+        successor->count = target->count - 1;
+        *link = successor;
+        add_to_counts(target->parent, -1);
+        release(target);
     }
 
-    return is_valid_bst(curr->left, min_node, curr) && is_valid_bst(curr->right, curr, max_node);
+    --size;
 }
-
@@ -1,18 +1,34 @@
 #ifndef BINARYSEARCHTREE_H
 #define BINARYSEARCHTREE_H
 
+#include "DynamicArray.h"
+
 #include <cstddef>
+#include <iterator>
 
 class Node;
 
 class BinarySearchTree {
     public:
+        class Iterator;
+        using iterator = Iterator;
+        using const_iterator = Iterator;
+        using reverse_iterator = std::reverse_iterator<Iterator>;
+        struct Range;
+
+        // Splay moves every key that insert or access finds deeper than a
+        // threshold up to the root with splay rotations, so keys used often
+        // stay near the top and on hot cache lines. contains() never adjusts.
+        enum class AccessMode { Static, Splay };
+
         BinarySearchTree();
         BinarySearchTree(const BinarySearchTree& orig);
         BinarySearchTree(BinarySearchTree&& orig) noexcept;
         BinarySearchTree& operator=(const BinarySearchTree& rhs);
         BinarySearchTree& operator=(BinarySearchTree&& rhs) noexcept;
         ~BinarySearchTree();
+        static BinarySearchTree build_from_sorted(const double* keys, std::size_t n, unsigned threads = 1);
+        static BinarySearchTree build_from_unsorted(const double* keys, std::size_t n, unsigned threads = 1);
         void clear();
         std::size_t get_size() const;
         bool empty() const;
@@ -27,19 +43,134 @@ class BinarySearchTree {
         void levelorder_print() const;
         void erase(double value);
         bool is_valid_bst() const;
+        void set_access_mode(AccessMode new_mode, std::size_t min_depth = 0);
+        AccessMode get_access_mode() const;
+        bool access(double value);
+        Iterator begin() const;
+        Iterator end() const;
+        reverse_iterator rbegin() const;
+        reverse_iterator rend() const;
+        void to_array(DynamicArray& out) const;
+        std::size_t rank(double value) const;
+        double select(std::size_t k) const;
+        std::size_t count_range(double low, double high) const;
+        Iterator lower_bound(double value) const;
+        Iterator upper_bound(double value) const;
+        Range range(double low, double high) const;
+
+        // Call f(key) on every key in the named order without allocating per
+        // node. Cheaper than iterators, which climb parent links between keys.
+        template <typename F>
+        void for_each_inorder(F f) const {
+            visit_inorder(&call<F>, &f);
+        }
+
+        template <typename F>
+        void for_each_preorder(F f) const {
+            visit_preorder(&call<F>, &f);
+        }
+
+        template <typename F>
+        void for_each_postorder(F f) const {
+            visit_postorder(&call<F>, &f);
+        }
+
+        template <typename F>
+        void for_each_levelorder(F f) const {
+            visit_levelorder(&call<F>, &f);
+        }
 
     private:
+        using Visitor = void (*)(void* context, double value);
+
+        static constexpr std::size_t parallel_build_cutoff{1 << 16}; // Smaller subtrees are not worth a thread
+
         Node* root;
         std::size_t size;
+        Node* block;            // Nodes of a bulk-built tree, allocated together; nullptr otherwise
+        std::size_t block_size;
+        AccessMode mode;
+        std::size_t splay_depth; // Splay mode leaves keys found above this depth in place
         Node* clone(const Node* curr) const;
         void clear(Node*& curr);
+        static Node* build(Node* nodes, const double* keys, std::size_t low, std::size_t high, Node* parent, unsigned threads);
+        void release(Node* curr) const;
         std::size_t height(const Node* curr) const;
-        void inorder_print(const Node* curr) const;
-        void preorder_print(const Node* curr) const;
-        void postorder_print(const Node* curr) const;
-        void levelorder_print(const Node* curr) const;
+        void inorder_copy(const Node* curr, double*& out) const;
+        template <typename F> void walk_inorder(const Node* curr, F&& visit) const;
+        template <typename F> void walk_preorder(const Node* curr, F&& visit) const;
+        template <typename F> void walk_postorder(const Node* curr, F&& visit) const;
+        template <typename F> void walk_levelorder(const Node* curr, F&& visit) const;
         void erase(Node*& curr, double value);
-        bool is_valid_bst(const Node* curr, const Node* min_node, const Node* max_node) const;
+        void visit_inorder(Visitor visit, void* context) const;
+        void visit_preorder(Visitor visit, void* context) const;
+        void visit_postorder(Visitor visit, void* context) const;
+        void visit_levelorder(Visitor visit, void* context) const;
+        static const Node* successor(const Node* curr);
+        static const Node* predecessor(const BinarySearchTree* tree, const Node* curr);
+        static std::size_t count_of(const Node* curr);
+        static void add_to_counts(Node* curr, int delta);
+        void rotate_up(Node* curr);
+        void adjust(Node* curr, std::size_t depth);
+        static const double& data_of(const Node* curr);
+
+        template <typename F>
+        static void call(void* f, double value) {
+            (*static_cast<F*>(f))(value);
+        }
+
+    friend class FrozenSet;
+};
+
+// Bidirectional iterator over the keys in ascending order. It stays valid
+// until its own key is erased, since erase relinks nodes rather than moving
+// keys between them; end() is a null node.
+class BinarySearchTree::Iterator {
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = double;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const double*;
+        using reference = const double&;
+
+        Iterator(): tree{nullptr}, node{nullptr} {
+
+        }
+
+        const double& operator*() const;
+        const double* operator->() const;
+        Iterator& operator++();
+        Iterator operator++(int);
+        Iterator& operator--();
+        Iterator operator--(int);
+
+        bool operator==(const Iterator& rhs) const {
+            return node == rhs.node;
+        }
+
+        bool operator!=(const Iterator& rhs) const {
+            return node != rhs.node;
+        }
+
+    private:
+        Iterator(const BinarySearchTree* new_tree, const Node* new_node);
+        const BinarySearchTree* tree; // For stepping back from end()
+        const Node* node;
+
+    friend class BinarySearchTree;
+};
+
+struct BinarySearchTree::Range {
+    Iterator first;
+    Iterator last;
+
+    Iterator begin() const {
+        return first;
+    }
+
+    Iterator end() const {
+        return last;
+    }
 };
 
 #endif
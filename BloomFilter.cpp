@@ -0,0 +1,246 @@
+#include "BloomFilter.h"
+
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+// Odd multipliers, one per word, that pick each word's bit from the same 32-bit hash
+static constexpr std::uint32_t salts[8]{0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+                                        0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U};
+
+// Position of the key's bit within word i of its block
+static unsigned salted_bit(std::uint32_t h, int i) {
+    return (h * salts[i]) >> 27;
+}
+
+BlockedBloomFilter::BlockedBloomFilter(std::size_t expected_keys, double bits_per_key): block_count{1}, blocks{nullptr} {
+    std::size_t bits{static_cast<std::size_t>(expected_keys * bits_per_key)};
+
+    if (bits > 256) {
+        block_count = (bits + 255) / 256;
+    }
+
+    blocks = new Block[block_count]{};
+}
+
+BlockedBloomFilter::BlockedBloomFilter(const BlockedBloomFilter& orig): block_count{orig.block_count}, blocks{new Block[block_count]} {
+    std::memcpy(blocks, orig.blocks, block_count * sizeof(Block));
+}
+
+// Leaves orig as an empty one-block filter so it stays usable
+BlockedBloomFilter::BlockedBloomFilter(BlockedBloomFilter&& orig) noexcept: block_count{orig.block_count}, blocks{orig.blocks} {
+    orig.block_count = 1;
+    orig.blocks = new Block[1]{};
+}
+
+BlockedBloomFilter& BlockedBloomFilter::operator=(const BlockedBloomFilter& rhs) {
+    if (this == &rhs) {
+        return *this;
+    }
+
+    Block* new_blocks{new Block[rhs.block_count]};
+    std::memcpy(new_blocks, rhs.blocks, rhs.block_count * sizeof(Block));
+    delete[] blocks;
+    block_count = rhs.block_count;
+    blocks = new_blocks;
+
+    return *this;
+}
+
+BlockedBloomFilter& BlockedBloomFilter::operator=(BlockedBloomFilter&& rhs) noexcept {
+    if (this == &rhs) {
+        return *this;
+    }
+
+    delete[] blocks;
+    block_count = rhs.block_count;
+    blocks = rhs.blocks;
+    rhs.block_count = 1;
+    rhs.blocks = new Block[1]{};
+
+    return *this;
+}
+
+BlockedBloomFilter::~BlockedBloomFilter() {
+    delete[] blocks;
+    blocks = nullptr;
+}
+
+std::size_t BlockedBloomFilter::get_bit_count() const {
+    return block_count * 256;
+}
+
+void BlockedBloomFilter::clear() {
+    std::memset(blocks, 0, block_count * sizeof(Block));
+}
+
+void BlockedBloomFilter::insert_hash(std::uint64_t h) {
+    Block& block{blocks[block_of(h)]};
+#if defined(__AVX2__)
+    __m256i* p{reinterpret_cast<__m256i*>(block.words)};
+    __m256i lanes{_mm256_srli_epi32(_mm256_mullo_epi32(_mm256_set1_epi32(static_cast<int>(h)),
+                                                       _mm256_loadu_si256(reinterpret_cast<const __m256i*>(salts))), 27)};
+    _mm256_store_si256(p, _mm256_or_si256(_mm256_load_si256(p), _mm256_sllv_epi32(_mm256_set1_epi32(1), lanes)));
+#else
+    Block mask;
+    make_mask(static_cast<std::uint32_t>(h), mask);
+
+    for (int i{0}; i < 8; ++i) {
+        block.words[i] |= mask.words[i];
+    }
+#endif
+}
+
+// True when every one of the key's eight bits is set: one masked compare per block
+bool BlockedBloomFilter::may_contain_hash(std::uint64_t h) const {
+    const Block& block{blocks[block_of(h)]};
+#if defined(__AVX2__)
+    __m256i lanes{_mm256_srli_epi32(_mm256_mullo_epi32(_mm256_set1_epi32(static_cast<int>(h)),
+                                                       _mm256_loadu_si256(reinterpret_cast<const __m256i*>(salts))), 27)};
+    __m256i mask{_mm256_sllv_epi32(_mm256_set1_epi32(1), lanes)};
+    return _mm256_testc_si256(_mm256_load_si256(reinterpret_cast<const __m256i*>(block.words)), mask);
+#else
+    Block mask;
+    make_mask(static_cast<std::uint32_t>(h), mask);
+#if defined(__SSE2__)
+    const __m128i* p{reinterpret_cast<const __m128i*>(block.words)};
+    const __m128i* m{reinterpret_cast<const __m128i*>(mask.words)};
+    __m128i lo{_mm_cmpeq_epi32(_mm_and_si128(_mm_load_si128(p), _mm_load_si128(m)), _mm_load_si128(m))};
+    __m128i hi{_mm_cmpeq_epi32(_mm_and_si128(_mm_load_si128(p + 1), _mm_load_si128(m + 1)), _mm_load_si128(m + 1))};
+    return _mm_movemask_epi8(_mm_and_si128(lo, hi)) == 0xffff;
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    uint32x4_t m_lo{vld1q_u32(mask.words)};
+    uint32x4_t m_hi{vld1q_u32(mask.words + 4)};
+    uint32x4_t lo{vceqq_u32(vandq_u32(vld1q_u32(block.words), m_lo), m_lo)};
+    uint32x4_t hi{vceqq_u32(vandq_u32(vld1q_u32(block.words + 4), m_hi), m_hi)};
+    return vminvq_u32(vandq_u32(lo, hi)) == 0xffffffffU;
+#else
+    std::uint32_t missing{0};
+
+    for (int i{0}; i < 8; ++i) {
+        missing |= mask.words[i] & ~block.words[i];
+    }
+
+    return missing == 0;
+#endif
+#endif
+}
+
+// High half of the hash picks the block by multiply-shift; the low half picks the bits
+std::size_t BlockedBloomFilter::block_of(std::uint64_t h) const {
+    return static_cast<std::size_t>(((h >> 32) * block_count) >> 32);
+}
+
+void BlockedBloomFilter::make_mask(std::uint32_t h, Block& mask) {
+    for (int i{0}; i < 8; ++i) {
+        mask.words[i] = std::uint32_t{1} << salted_bit(h, i);
+    }
+}
+
+CountingBloomFilter::CountingBloomFilter(std::size_t expected_keys, double bits_per_key):
+    bits{expected_keys, bits_per_key}, counters{new std::uint8_t[counter_bytes()]{}} {
+
+}
+
+CountingBloomFilter::CountingBloomFilter(const CountingBloomFilter& orig): bits{orig.bits}, counters{new std::uint8_t[counter_bytes()]} {
+    std::memcpy(counters, orig.counters, counter_bytes());
+}
+
+CountingBloomFilter::CountingBloomFilter(CountingBloomFilter&& orig) noexcept: bits{std::move(orig.bits)}, counters{orig.counters} {
+    orig.counters = new std::uint8_t[orig.counter_bytes()]{};
+}
+
+CountingBloomFilter& CountingBloomFilter::operator=(const CountingBloomFilter& rhs) {
+    if (this == &rhs) {
+        return *this;
+    }
+
+    std::uint8_t* new_counters{new std::uint8_t[rhs.counter_bytes()]};
+    std::memcpy(new_counters, rhs.counters, rhs.counter_bytes());
+    bits = rhs.bits;
+    delete[] counters;
+    counters = new_counters;
+
+    return *this;
+}
+
+CountingBloomFilter& CountingBloomFilter::operator=(CountingBloomFilter&& rhs) noexcept {
+    if (this == &rhs) {
+        return *this;
+    }
+
+    bits = std::move(rhs.bits);
+    delete[] counters;
+    counters = rhs.counters;
+    rhs.counters = new std::uint8_t[rhs.counter_bytes()]{};
+
+    return *this;
+}
+
+CountingBloomFilter::~CountingBloomFilter() {
+    delete[] counters;
+    counters = nullptr;
+}
+
+std::size_t CountingBloomFilter::get_bit_count() const {
+    return bits.get_bit_count();
+}
+
+void CountingBloomFilter::clear() {
+    bits.clear();
+    std::memset(counters, 0, counter_bytes());
+}
+
+void CountingBloomFilter::insert_hash(std::uint64_t h) {
+    std::size_t b{bits.block_of(h)};
+
+    for (int i{0}; i < 8; ++i) {
+        unsigned in_word{salted_bit(static_cast<std::uint32_t>(h), i)};
+        std::size_t bit{b * 256 + i * 32 + in_word};
+        std::uint8_t& byte{counters[bit / 2]};
+        unsigned shift{static_cast<unsigned>(bit % 2) * 4};
+
+        if (((byte >> shift) & 0xf) != 0xf) {
+            byte = static_cast<std::uint8_t>(byte + (1u << shift));
+        }
+
+        bits.blocks[b].words[i] |= std::uint32_t{1} << in_word;
+    }
+}
+
+// Clears a filter bit only once its counter drops to zero
+void CountingBloomFilter::remove_hash(std::uint64_t h) {
+    std::size_t b{bits.block_of(h)};
+
+    for (int i{0}; i < 8; ++i) {
+        unsigned in_word{salted_bit(static_cast<std::uint32_t>(h), i)};
+        std::size_t bit{b * 256 + i * 32 + in_word};
+        std::uint8_t& byte{counters[bit / 2]};
+        unsigned shift{static_cast<unsigned>(bit % 2) * 4};
+        unsigned count{(byte >> shift) & 0xfu};
+
+        if (count == 0 || count == 0xf) {
+            continue;
+        }
+
+        byte = static_cast<std::uint8_t>(byte - (1u << shift));
+
+        if (count == 1) {
+            bits.blocks[b].words[i] &= ~(std::uint32_t{1} << in_word);
+        }
+    }
+}
+
+bool CountingBloomFilter::may_contain_hash(std::uint64_t h) const {
+    return bits.may_contain_hash(h);
+}
+
+std::size_t CountingBloomFilter::counter_bytes() const {
+    return bits.get_bit_count() / 2;
+}
@@ -0,0 +1,93 @@
+#ifndef BLOOMFILTER_H
+#define BLOOMFILTER_H
+
+#include "HashMap.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// Split-block Bloom filter. Each key maps to one 256-bit block, and sets one
+// bit in each of the block's eight 32-bit words, so a query touches a single
+// cache line and tests all eight bits at once with SIMD where available. At
+// the default 10 bits per key about 1% of absent keys pass.
+//
+// Meant to sit in front of any of the library's containers, keyed the same
+// way, so that most misses skip the container entirely:
+//     if (filter.may_contain(key) && map.contains(key)) { ... }
+class BlockedBloomFilter {
+    public:
+        explicit BlockedBloomFilter(std::size_t expected_keys, double bits_per_key = 10.0);
+        BlockedBloomFilter(const BlockedBloomFilter& orig);
+        BlockedBloomFilter(BlockedBloomFilter&& orig) noexcept;
+        BlockedBloomFilter& operator=(const BlockedBloomFilter& rhs);
+        BlockedBloomFilter& operator=(BlockedBloomFilter&& rhs) noexcept;
+        ~BlockedBloomFilter();
+        std::size_t get_bit_count() const;
+        void clear();
+        void insert_hash(std::uint64_t h);
+        bool may_contain_hash(std::uint64_t h) const;
+
+        template <typename T>
+        void insert(const T& key) {
+            insert_hash(MixHash{}(key));
+        }
+
+        template <typename T>
+        bool may_contain(const T& key) const {
+            return may_contain_hash(MixHash{}(key));
+        }
+
+    private:
+        struct alignas(32) Block {
+            std::uint32_t words[8];
+        };
+
+        std::size_t block_count;
+        Block* blocks;
+        std::size_t block_of(std::uint64_t h) const;
+        static void make_mask(std::uint32_t h, Block& mask);
+
+    friend class CountingBloomFilter;
+};
+
+// Blocked Bloom filter that also supports remove. Every filter bit has a
+// 4-bit counter kept in a separate array, touched only by insert and remove,
+// so queries read the same single block as BlockedBloomFilter. A counter that
+// reaches 15 sticks there, which keeps remove safe at the cost of that bit
+// never clearing. Removing a key that was never inserted corrupts the filter.
+class CountingBloomFilter {
+    public:
+        explicit CountingBloomFilter(std::size_t expected_keys, double bits_per_key = 10.0);
+        CountingBloomFilter(const CountingBloomFilter& orig);
+        CountingBloomFilter(CountingBloomFilter&& orig) noexcept;
+        CountingBloomFilter& operator=(const CountingBloomFilter& rhs);
+        CountingBloomFilter& operator=(CountingBloomFilter&& rhs) noexcept;
+        ~CountingBloomFilter();
+        std::size_t get_bit_count() const;
+        void clear();
+        void insert_hash(std::uint64_t h);
+        void remove_hash(std::uint64_t h);
+        bool may_contain_hash(std::uint64_t h) const;
+
+        template <typename T>
+        void insert(const T& key) {
+            insert_hash(MixHash{}(key));
+        }
+
+        template <typename T>
+        void remove(const T& key) {
+            remove_hash(MixHash{}(key));
+        }
+
+        template <typename T>
+        bool may_contain(const T& key) const {
+            return may_contain_hash(MixHash{}(key));
+        }
+
+    private:
+        BlockedBloomFilter bits;
+        std::uint8_t* counters; // Two 4-bit counters per byte, one per filter bit
+        std::size_t counter_bytes() const;
+};
+
+#endif
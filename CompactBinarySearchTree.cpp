@@ -0,0 +1,308 @@
+#include "CompactBinarySearchTree.h"
+
+#include <iostream>
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+CompactBinarySearchTree::CompactBinarySearchTree(): nodes{nullptr}, used{0}, capacity{0}, root{npos}, free_head{npos}, size{0} {
+
+}
+
+// Copies only the slots in use, free list included, in a single memcpy
+CompactBinarySearchTree::CompactBinarySearchTree(const CompactBinarySearchTree& orig):
+    nodes{new Node[orig.used]}, used{orig.used}, capacity{orig.used}, root{orig.root}, free_head{orig.free_head}, size{orig.size} {
+    if (used > 0) {
+        std::memcpy(nodes, orig.nodes, used * sizeof(Node));
+    }
+}
+
+CompactBinarySearchTree::CompactBinarySearchTree(CompactBinarySearchTree&& orig) noexcept:
+    nodes{orig.nodes}, used{orig.used}, capacity{orig.capacity}, root{orig.root}, free_head{orig.free_head}, size{orig.size} {
+    orig.nodes = nullptr;
+    orig.used = 0;
+    orig.capacity = 0;
+    orig.root = npos;
+    orig.free_head = npos;
+    orig.size = 0;
+}
+
+CompactBinarySearchTree& CompactBinarySearchTree::operator=(const CompactBinarySearchTree& rhs) {
+    if (this == &rhs) {
+        return *this;
+    }
+
+    if (capacity < rhs.used) {
+        delete[] nodes;
+        nodes = new Node[rhs.used];
+        capacity = rhs.used;
+    }
+
+    if (rhs.used > 0) {
+        std::memcpy(nodes, rhs.nodes, rhs.used * sizeof(Node));
+    }
+
+    used = rhs.used;
+    root = rhs.root;
+    free_head = rhs.free_head;
+    size = rhs.size;
+
+    return *this;
+}
+
+CompactBinarySearchTree& CompactBinarySearchTree::operator=(CompactBinarySearchTree&& rhs) noexcept {
+    if (this == &rhs) {
+        return *this;
+    }
+
+    delete[] nodes;
+    nodes = rhs.nodes;
+    used = rhs.used;
+    capacity = rhs.capacity;
+    root = rhs.root;
+    free_head = rhs.free_head;
+    size = rhs.size;
+    rhs.nodes = nullptr;
+    rhs.used = 0;
+    rhs.capacity = 0;
+    rhs.root = npos;
+    rhs.free_head = npos;
+    rhs.size = 0;
+
+    return *this;
+}
+
+CompactBinarySearchTree::~CompactBinarySearchTree() {
+    delete[] nodes;
+    nodes = nullptr;
+}
+
+// O(1): forgets every slot but keeps the arena
+void CompactBinarySearchTree::clear() {
+    used = 0;
+    root = npos;
+    free_head = npos;
+    size = 0;
+}
+
+std::size_t CompactBinarySearchTree::get_size() const {
+    return size;
+}
+
+bool CompactBinarySearchTree::empty() const {
+    return size == 0;
+}
+
+void CompactBinarySearchTree::reserve(std::size_t new_capacity) {
+    if (new_capacity <= capacity) {
+        return;
+    }
+
+    if (new_capacity >= npos) {
+        throw std::length_error{"CompactBinarySearchTree: capacity past the 32-bit index space"};
+    }
+
+    Node* bigger{new Node[new_capacity]};
+
+    if (used > 0) {
+        std::memcpy(bigger, nodes, used * sizeof(Node));
+    }
+
+    delete[] nodes;
+    nodes = bigger;
+    capacity = static_cast<std::uint32_t>(new_capacity);
+}
+
+void CompactBinarySearchTree::insert(double value) {
+    // Grow first, so the links below stay valid while they are followed
+    if (free_head == npos && used == capacity) {
+        if (capacity == npos - 1) {
+            if (contains(value)) {
+                return;
+            }
+
+            throw std::length_error{"CompactBinarySearchTree: every 32-bit index is in use"};
+        }
+
+        std::size_t grown{capacity == 0 ? 16 : std::size_t{capacity} * 2};
+        reserve(grown < npos ? grown : npos - 1);
+    }
+
+    std::uint32_t* link{&root};
+
+    while (*link != npos) {
+        Node& curr{nodes[*link]};
+
+        if (value == curr.data) {
+            return;
+        }
+
+        link = value < curr.data ? &curr.left : &curr.right;
+    }
+
+    *link = allocate(value);
+    ++size;
+}
+
+bool CompactBinarySearchTree::contains(double value) const {
+    std::uint32_t curr{root};
+
+    while (curr != npos) {
+        const Node& node{nodes[curr]};
+
+        if (value == node.data) {
+            return true;
+        }
+
+        curr = value < node.data ? node.left : node.right;
+    }
+
+    return false;
+}
+
+double CompactBinarySearchTree::min() const {
+    assert(!empty());
+    std::uint32_t curr{root};
+
+    while (nodes[curr].left != npos) {
+        curr = nodes[curr].left;
+    }
+
+    return nodes[curr].data;
+}
+
+double CompactBinarySearchTree::max() const {
+    assert(!empty());
+    std::uint32_t curr{root};
+
+    while (nodes[curr].right != npos) {
+        curr = nodes[curr].right;
+    }
+
+    return nodes[curr].data;
+}
+
+std::size_t CompactBinarySearchTree::height() const {
+    struct Step {
+        std::uint32_t node;
+        std::uint32_t depth;
+    };
+
+    std::uint32_t deepest{0};
+    std::vector<Step> pending;
+
+    if (root != npos) {
+        pending.push_back({root, 1});
+    }
+
+    while (!pending.empty()) {
+        Step step{pending.back()};
+        pending.pop_back();
+        deepest = step.depth > deepest ? step.depth : deepest;
+
+        if (nodes[step.node].left != npos) {
+            pending.push_back({nodes[step.node].left, step.depth + 1});
+        }
+
+        if (nodes[step.node].right != npos) {
+            pending.push_back({nodes[step.node].right, step.depth + 1});
+        }
+    }
+
+    return deepest;
+}
+
+void CompactBinarySearchTree::inorder_print() const {
+    walk_inorder([](double value) { std::cout << value << " "; });
+    std::cout << "\n";
+}
+
+void CompactBinarySearchTree::erase(double value) {
+    std::uint32_t* link{&root};
+
+    while (*link != npos && nodes[*link].data != value) {
+        link = value < nodes[*link].data ? &nodes[*link].left : &nodes[*link].right;
+    }
+
+    if (*link == npos) {
+        return;
+    }
+
+    Node& target{nodes[*link]};
+    std::uint32_t freed{*link};
+
+    if (target.left == npos) {
+        *link = target.right;
+    } else if (target.right == npos) {
+        *link = target.left;
+    } else {
+        // Move the successor's key up and unlink the successor instead
+        std::uint32_t* successor{&target.right};
+
+        while (nodes[*successor].left != npos) {
+            successor = &nodes[*successor].left;
+        }
+
+        freed = *successor;
+        target.data = nodes[freed].data;
+        *successor = nodes[freed].right;
+    }
+
+    nodes[freed].left = free_head;
+    free_head = freed;
+    --size;
+}
+
+// Valid exactly when the in-order walk is strictly increasing
+bool CompactBinarySearchTree::is_valid_bst() const {
+    bool valid{true};
+    bool first{true};
+    double prev{0.0};
+
+    walk_inorder([&](double value) {
+        valid = valid && (first || prev < value);
+        first = false;
+        prev = value;
+    });
+
+    return valid;
+}
+
+// Bytes held by the arena, including free and not yet used slots
+std::size_t CompactBinarySearchTree::memory_bytes() const {
+    return std::size_t{capacity} * sizeof(Node);
+}
+
+// Takes a freed slot if there is one, else the next unused slot; the caller ensures there is room
+std::uint32_t CompactBinarySearchTree::allocate(double value) {
+    std::uint32_t i{free_head};
+
+    if (i == npos) {
+        i = used++;
+    } else {
+        free_head = nodes[i].left;
+    }
+
+    nodes[i] = Node{value, npos, npos};
+
+    return i;
+}
+
+template <typename F>
+void CompactBinarySearchTree::walk_inorder(F&& visit) const {
+    std::vector<std::uint32_t> pending;
+    std::uint32_t curr{root};
+
+    while (curr != npos || !pending.empty()) {
+        while (curr != npos) {
+            pending.push_back(curr);
+            curr = nodes[curr].left;
+        }
+
+        curr = pending.back();
+        pending.pop_back();
+        visit(nodes[curr].data);
+        curr = nodes[curr].right;
+    }
+}
@@ -0,0 +1,54 @@
+#ifndef COMPACTBINARYSEARCHTREE_H
+#define COMPACTBINARYSEARCHTREE_H
+
+#include <cstddef>
+#include <cstdint>
+
+// BinarySearchTree whose nodes live in one contiguous arena and link to their
+// children by 32-bit index. A node is 16 bytes with no per-node allocation, so
+// more of the tree fits in cache, clear() is O(1), and a copy is one memcpy.
+// Erased slots are kept on a free list for later inserts, and clear() keeps
+// the arena for the next fill. Holds fewer than 2^32 - 1 keys; inserting a new
+// key past that, or reserving more slots, throws std::length_error.
+class CompactBinarySearchTree {
+    public:
+        CompactBinarySearchTree();
+        CompactBinarySearchTree(const CompactBinarySearchTree& orig);
+        CompactBinarySearchTree(CompactBinarySearchTree&& orig) noexcept;
+        CompactBinarySearchTree& operator=(const CompactBinarySearchTree& rhs);
+        CompactBinarySearchTree& operator=(CompactBinarySearchTree&& rhs) noexcept;
+        ~CompactBinarySearchTree();
+        void clear();
+        std::size_t get_size() const;
+        bool empty() const;
+        void reserve(std::size_t new_capacity);
+        void insert(double value);
+        bool contains(double value) const;
+        double min() const;
+        double max() const;
+        std::size_t height() const;
+        void inorder_print() const;
+        void erase(double value);
+        bool is_valid_bst() const;
+        std::size_t memory_bytes() const;
+
+    private:
+        static constexpr std::uint32_t npos{UINT32_MAX};
+
+        struct Node {
+            double data;
+            std::uint32_t left;  // npos when absent; links the free list in freed slots
+            std::uint32_t right;
+        };
+
+        Node* nodes;
+        std::uint32_t used;      // Slots handed out so far, including freed ones
+        std::uint32_t capacity;
+        std::uint32_t root;
+        std::uint32_t free_head; // Freed slots, chained through left
+        std::size_t size;
+        std::uint32_t allocate(double value);
+        template <typename F> void walk_inorder(F&& visit) const;
+};
+
+#endif
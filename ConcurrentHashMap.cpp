@@ -0,0 +1,5 @@
+#include "ConcurrentHashMap.h"
+
+// ConcurrentHashMap is a class template defined in ConcurrentHashMap.h;
+// instantiating the default map here type-checks every member
+template class ConcurrentHashMap<>;
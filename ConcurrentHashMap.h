@@ -0,0 +1,176 @@
+#ifndef CONCURRENTHASHMAP_H
+#define CONCURRENTHASHMAP_H
+
+#include "HashMap.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <utility>
+
+// A HashMap split into independently locked shards. The shard is picked by the
+// high bits of the hash, while each shard's HashMap indexes by the low bits, so
+// the two choices stay independent; the key is hashed once for both. Readers
+// take a shard's lock shared, writers take it exclusive, and every shard grows
+// on its own. HashMap's statistics counters are atomic, so a HASHMAP_STATS
+// build keeps the shared readers.
+template <typename K = int, typename V = int, typename Hash = MixHash, typename Eq = std::equal_to<>>
+class ConcurrentHashMap {
+    public:
+        explicit ConcurrentHashMap(std::size_t min_shards = 64);
+        ConcurrentHashMap(const ConcurrentHashMap& orig) = delete;
+        ConcurrentHashMap(ConcurrentHashMap&& orig) noexcept = delete;
+        ConcurrentHashMap& operator=(const ConcurrentHashMap& rhs) = delete;
+        ConcurrentHashMap& operator=(ConcurrentHashMap&& rhs) noexcept = delete;
+        ~ConcurrentHashMap();
+        std::size_t get_size() const;
+        std::size_t get_shard_count() const;
+        bool empty() const;
+        void clear();
+        void insert(const K& key, const V& value);
+        template <typename... Args>
+        bool try_emplace(const K& key, Args&&... args);
+        template <typename M>
+        bool insert_or_assign(const K& key, M&& value);
+        bool contains(const K& key) const;
+        bool get(const K& key, V& out) const;
+        void remove(const K& key);
+
+    private:
+        // One cache line per shard header so neighbouring locks do not false-share
+        struct alignas(64) Shard {
+            mutable std::shared_mutex lock;
+            HashMap<K, V, Hash, Eq> map;
+            std::atomic<std::size_t> count{0}; // Mirrors map.get_size() for lock-free get_size()
+        };
+
+        std::size_t shard_count; // Always a power of two
+        unsigned shard_shift;    // 64 - log2(shard_count)
+        Shard* shards;
+        Hash hasher;
+        Shard& shard_for(std::uint64_t h) const;
+};
+
+template <typename K, typename V, typename Hash, typename Eq>
+ConcurrentHashMap<K, V, Hash, Eq>::ConcurrentHashMap(std::size_t min_shards): shard_count{1}, shard_shift{64}, shards{nullptr}, hasher{} {
+    while (shard_count < min_shards) {
+        shard_count *= 2;
+        --shard_shift;
+    }
+
+    shards = new Shard[shard_count];
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+ConcurrentHashMap<K, V, Hash, Eq>::~ConcurrentHashMap() {
+    delete[] shards;
+    shards = nullptr;
+}
+
+// Sums per-shard counters without locking; exact once writers are quiescent
+template <typename K, typename V, typename Hash, typename Eq>
+std::size_t ConcurrentHashMap<K, V, Hash, Eq>::get_size() const {
+    std::size_t total{0};
+
+    for (std::size_t k{0}; k < shard_count; ++k) {
+        total += shards[k].count.load(std::memory_order_relaxed);
+    }
+
+    return total;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+std::size_t ConcurrentHashMap<K, V, Hash, Eq>::get_shard_count() const {
+    return shard_count;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+bool ConcurrentHashMap<K, V, Hash, Eq>::empty() const {
+    return get_size() == 0;
+}
+
+// Clears shard by shard, so concurrent inserts into already cleared shards survive
+template <typename K, typename V, typename Hash, typename Eq>
+void ConcurrentHashMap<K, V, Hash, Eq>::clear() {
+    for (std::size_t k{0}; k < shard_count; ++k) {
+        std::unique_lock<std::shared_mutex> guard{shards[k].lock};
+        shards[k].map.clear();
+        shards[k].count.store(0, std::memory_order_relaxed);
+    }
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+void ConcurrentHashMap<K, V, Hash, Eq>::insert(const K& key, const V& value) {
+    insert_or_assign(key, value);
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+template <typename... Args>
+bool ConcurrentHashMap<K, V, Hash, Eq>::try_emplace(const K& key, Args&&... args) {
+    std::uint64_t h{hasher(key)};
+    Shard& shard{shard_for(h)};
+    std::unique_lock<std::shared_mutex> guard{shard.lock};
+    bool inserted{shard.map.try_emplace_hashed(h, key, std::forward<Args>(args)...)};
+    shard.count.store(shard.map.get_size(), std::memory_order_relaxed);
+
+    return inserted;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+template <typename M>
+bool ConcurrentHashMap<K, V, Hash, Eq>::insert_or_assign(const K& key, M&& value) {
+    std::uint64_t h{hasher(key)};
+    Shard& shard{shard_for(h)};
+    std::unique_lock<std::shared_mutex> guard{shard.lock};
+    bool inserted{shard.map.insert_or_assign_hashed(h, key, std::forward<M>(value))};
+    shard.count.store(shard.map.get_size(), std::memory_order_relaxed);
+
+    return inserted;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+bool ConcurrentHashMap<K, V, Hash, Eq>::contains(const K& key) const {
+    std::uint64_t h{hasher(key)};
+    Shard& shard{shard_for(h)};
+    std::shared_lock<std::shared_mutex> guard{shard.lock};
+
+    return shard.map.find_hashed(h, key) != nullptr;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+bool ConcurrentHashMap<K, V, Hash, Eq>::get(const K& key, V& out) const {
+    std::uint64_t h{hasher(key)};
+    Shard& shard{shard_for(h)};
+    std::shared_lock<std::shared_mutex> guard{shard.lock};
+
+    const V* value{shard.map.find_hashed(h, key)};
+
+    if (value == nullptr) {
+        return false;
+    }
+
+    out = *value;
+    return true;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+void ConcurrentHashMap<K, V, Hash, Eq>::remove(const K& key) {
+    std::uint64_t h{hasher(key)};
+    Shard& shard{shard_for(h)};
+    std::unique_lock<std::shared_mutex> guard{shard.lock};
+    shard.map.remove_hashed(h, key);
+    shard.count.store(shard.map.get_size(), std::memory_order_relaxed);
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+typename ConcurrentHashMap<K, V, Hash, Eq>::Shard& ConcurrentHashMap<K, V, Hash, Eq>::shard_for(std::uint64_t h) const {
+    // A shift by 64 is undefined, and a single shard needs no bits at all
+    std::size_t k{shard_count == 1 ? 0 : static_cast<std::size_t>(h >> shard_shift)};
+
+    return shards[k];
+}
+
+#endif
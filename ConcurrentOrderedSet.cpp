@@ -0,0 +1,516 @@
+#include "ConcurrentOrderedSet.h"
+
+#include <limits>
+
+// Node fields are atomics so that a reader overlapping a writer is a benign
+// race: it reads with relaxed loads and throws the result away when the
+// version check fails. The acquire fence in validate pairs with the release
+// fence in try_lock, so a reader that saw any store made under the lock also
+// sees the odd version that came before it. An inner node's count is stored
+// with release after its children and loaded with acquire, so a reader that
+// sees a new count also sees the child it covers; a reader that still meets a
+// null child in a half-shifted node restarts rather than following it.
+
+ConcurrentOrderedSet::ConcurrentOrderedSet(): root{new Node{true}}, size{0} {
+
+}
+
+// Not safe to run while another thread is still using the set
+ConcurrentOrderedSet::~ConcurrentOrderedSet() {
+    destroy(root.load(std::memory_order_relaxed));
+    root.store(nullptr, std::memory_order_relaxed);
+}
+
+std::size_t ConcurrentOrderedSet::get_size() const {
+    return size.load(std::memory_order_relaxed);
+}
+
+bool ConcurrentOrderedSet::empty() const {
+    return get_size() == 0;
+}
+
+void ConcurrentOrderedSet::insert(double value) {
+    while (!try_insert(value)) {
+
+    }
+}
+
+bool ConcurrentOrderedSet::contains(double value) const {
+    while (true) {
+        std::uint64_t version{0};
+        const Node* leaf{find_leaf(value, version)};
+
+        if (leaf == nullptr) {
+            continue;
+        }
+
+        std::uint32_t n{leaf->count.load(std::memory_order_relaxed)};
+        std::uint32_t pos{count_below(leaf, n, value, false)};
+        bool found{pos < n && leaf->keys[pos].load(std::memory_order_relaxed) == value};
+
+        if (validate(leaf, version)) {
+            return found;
+        }
+    }
+}
+
+// Searches for the first key at or above a bound, starting unbounded. A search
+// that lands in an emptied leaf moves the bound up to the leaf's upper
+// separator and tries again.
+double ConcurrentOrderedSet::min() const {
+    bool bounded{false};
+    double bound{0.0};
+    double out{0.0};
+
+    while (true) {
+        Probe probe{first_from(bounded, bound, out)};
+
+        if (probe == Probe::Found) {
+            return out;
+        }
+
+        if (probe == Probe::Exhausted) {
+            return std::numeric_limits<double>::quiet_NaN();
+        }
+
+        bounded = bounded || probe == Probe::Next;
+    }
+}
+
+double ConcurrentOrderedSet::max() const {
+    bool bounded{false};
+    double bound{0.0};
+    double out{0.0};
+
+    while (true) {
+        Probe probe{last_before(bounded, bound, out)};
+
+        if (probe == Probe::Found) {
+            return out;
+        }
+
+        if (probe == Probe::Exhausted) {
+            return std::numeric_limits<double>::quiet_NaN();
+        }
+
+        bounded = bounded || probe == Probe::Next;
+    }
+}
+
+void ConcurrentOrderedSet::erase(double value) {
+    while (true) {
+        std::uint64_t version{0};
+        Node* leaf{find_leaf(value, version)};
+
+        if (leaf == nullptr || !try_lock(leaf, version)) {
+            continue;
+        }
+
+        std::uint32_t n{leaf->count.load(std::memory_order_relaxed)};
+        std::uint32_t pos{count_below(leaf, n, value, false)};
+
+        if (pos < n && leaf->keys[pos].load(std::memory_order_relaxed) == value) {
+            for (std::uint32_t i{pos}; i + 1 < n; ++i) {
+                leaf->keys[i].store(leaf->keys[i + 1].load(std::memory_order_relaxed), std::memory_order_relaxed);
+            }
+
+            leaf->count.store(n - 1, std::memory_order_relaxed);
+            size.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        unlock(leaf);
+        return;
+    }
+}
+
+// Checks key order and separator bounds, that every leaf is at the same depth,
+// and that the leaves hold size keys. Only meaningful while no thread is writing.
+bool ConcurrentOrderedSet::is_valid() const {
+    std::size_t leaf_depth{0};
+    std::size_t keys{0};
+
+    return is_valid(root.load(std::memory_order_acquire), nullptr, nullptr, 1, leaf_depth, keys) && keys == get_size();
+}
+
+// Sets locked when a writer holds the node, in which case the caller restarts
+std::uint64_t ConcurrentOrderedSet::read_version(const Node* node, bool& locked) {
+    std::uint64_t version{node->version.load(std::memory_order_acquire)};
+    locked = (version & 1) != 0;
+
+    return version;
+}
+
+// True when nothing was written to the node since version was read
+bool ConcurrentOrderedSet::validate(const Node* node, std::uint64_t version) {
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    return node->version.load(std::memory_order_relaxed) == version;
+}
+
+// Locks the node only if it is still at version
+bool ConcurrentOrderedSet::try_lock(Node* node, std::uint64_t version) {
+    if (!node->version.compare_exchange_strong(version, version + 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+        return false;
+    }
+
+    std::atomic_thread_fence(std::memory_order_release);
+    return true;
+}
+
+void ConcurrentOrderedSet::unlock(Node* node) {
+    node->version.fetch_add(1, std::memory_order_release);
+}
+
+// Number of the first n keys that are < value, or <= value when inclusive
+std::uint32_t ConcurrentOrderedSet::count_below(const Node* node, std::uint32_t n, double value, bool inclusive) {
+    std::uint32_t count{0};
+
+    for (std::uint32_t i{0}; i < n; ++i) {
+        double key{node->keys[i].load(std::memory_order_relaxed)};
+        count += inclusive ? key <= value : key < value;
+    }
+
+    return count;
+}
+
+// Leaf that would hold value, with the version it was read at, or nullptr when
+// the caller has to restart. Each child's version is read before its parent is
+// revalidated, so a split that moved value out of the child is always noticed.
+ConcurrentOrderedSet::Node* ConcurrentOrderedSet::find_leaf(double value, std::uint64_t& version) const {
+    bool locked{false};
+    Node* node{root.load(std::memory_order_acquire)};
+    version = read_version(node, locked);
+
+    if (locked || node != root.load(std::memory_order_acquire)) {
+        return nullptr;
+    }
+
+    while (!node->leaf) {
+        Inner* inner{static_cast<Inner*>(node)};
+        std::uint32_t n{inner->count.load(std::memory_order_acquire)};
+        Node* child{inner->children[count_below(inner, n, value, true)].load(std::memory_order_acquire)};
+
+        if (child == nullptr) {
+            return nullptr;
+        }
+
+        std::uint64_t child_version{read_version(child, locked)};
+
+        if (locked || !validate(inner, version)) {
+            return nullptr;
+        }
+
+        node = child;
+        version = child_version;
+    }
+
+    return node;
+}
+
+// One attempt at an insert; false when it has to restart. Full nodes are split
+// on the way down, so the leaf always has room and a split never has to
+// propagate past a parent that is already locked.
+bool ConcurrentOrderedSet::try_insert(double value) {
+    bool locked{false};
+    Node* node{root.load(std::memory_order_acquire)};
+    std::uint64_t version{read_version(node, locked)};
+
+    if (locked || node != root.load(std::memory_order_acquire)) {
+        return false;
+    }
+
+    Inner* parent{nullptr};
+    std::uint64_t parent_version{0};
+
+    while (true) {
+        if (node->count.load(std::memory_order_relaxed) == capacity) {
+            split(parent, parent_version, node, version);
+            return false;
+        }
+
+        if (node->leaf) {
+            break;
+        }
+
+        Inner* inner{static_cast<Inner*>(node)};
+        std::uint32_t n{inner->count.load(std::memory_order_acquire)};
+        Node* child{inner->children[count_below(inner, n, value, true)].load(std::memory_order_acquire)};
+
+        if (child == nullptr) {
+            return false;
+        }
+
+        std::uint64_t child_version{read_version(child, locked)};
+
+        if (locked || !validate(inner, version)) {
+            return false;
+        }
+
+        parent = inner;
+        parent_version = version;
+        node = child;
+        version = child_version;
+    }
+
+    if (!try_lock(node, version)) {
+        return false;
+    }
+
+    std::uint32_t n{node->count.load(std::memory_order_relaxed)};
+    std::uint32_t pos{count_below(node, n, value, false)};
+
+    if (pos < n && node->keys[pos].load(std::memory_order_relaxed) == value) {
+        unlock(node);
+        return true;
+    }
+
+    for (std::uint32_t i{n}; i > pos; --i) {
+        node->keys[i].store(node->keys[i - 1].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+
+    node->keys[pos].store(value, std::memory_order_relaxed);
+    node->count.store(n + 1, std::memory_order_relaxed);
+    unlock(node);
+    size.fetch_add(1, std::memory_order_relaxed);
+
+    return true;
+}
+
+// Splits a full node in half under the locks of the node and its parent, or
+// grows a new root above it. Gives up silently if either lock cannot be taken
+// at the version the caller saw; the caller restarts either way. The parent
+// had room at that version, which the lock confirms.
+void ConcurrentOrderedSet::split(Inner* parent, std::uint64_t parent_version, Node* node, std::uint64_t version) {
+    if (parent != nullptr && !try_lock(parent, parent_version)) {
+        return;
+    }
+
+    if (!try_lock(node, version)) {
+        if (parent != nullptr) {
+            unlock(parent);
+        }
+
+        return;
+    }
+
+    if (parent == nullptr && node != root.load(std::memory_order_relaxed)) {
+        unlock(node);
+        return;
+    }
+
+    constexpr std::uint32_t half{capacity / 2};
+    Node* right{node->leaf ? new Node{true} : new Inner{}};
+    double separator{node->keys[half].load(std::memory_order_relaxed)};
+    std::uint32_t first{node->leaf ? half : half + 1}; // An inner node's middle key moves up instead of right
+
+    for (std::uint32_t i{first}; i < capacity; ++i) {
+        right->keys[i - first].store(node->keys[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+
+    if (!node->leaf) {
+        Inner* inner{static_cast<Inner*>(node)};
+        Inner* inner_right{static_cast<Inner*>(right)};
+
+        for (std::uint32_t i{first}; i <= capacity; ++i) {
+            inner_right->children[i - first].store(inner->children[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+    }
+
+    right->count.store(capacity - first, std::memory_order_relaxed);
+    node->count.store(half, std::memory_order_relaxed);
+
+    if (parent == nullptr) {
+        Inner* new_root{new Inner{}};
+        new_root->keys[0].store(separator, std::memory_order_relaxed);
+        new_root->children[0].store(node, std::memory_order_relaxed);
+        new_root->children[1].store(right, std::memory_order_relaxed);
+        new_root->count.store(1, std::memory_order_relaxed);
+        root.store(new_root, std::memory_order_release);
+    } else {
+        std::uint32_t n{parent->count.load(std::memory_order_relaxed)};
+        std::uint32_t pos{count_below(parent, n, separator, false)};
+
+        for (std::uint32_t i{n}; i > pos; --i) {
+            parent->keys[i].store(parent->keys[i - 1].load(std::memory_order_relaxed), std::memory_order_relaxed);
+            parent->children[i + 1].store(parent->children[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+
+        parent->keys[pos].store(separator, std::memory_order_relaxed);
+        parent->children[pos + 1].store(right, std::memory_order_release);
+        parent->count.store(n + 1, std::memory_order_release);
+    }
+
+    unlock(node);
+
+    if (parent != nullptr) {
+        unlock(parent);
+    }
+}
+
+// One attempt at finding the first key >= bound (any key when not bounded).
+// Returns Next with bound raised to the upper separator of an emptied leaf, or
+// Exhausted when that leaf was the rightmost.
+ConcurrentOrderedSet::Probe ConcurrentOrderedSet::first_from(bool bounded, double& bound, double& out) const {
+    bool locked{false};
+    const Node* node{root.load(std::memory_order_acquire)};
+    std::uint64_t version{read_version(node, locked)};
+    bool has_upper{false};
+    double upper{0.0};
+
+    if (locked || node != root.load(std::memory_order_acquire)) {
+        return Probe::Restart;
+    }
+
+    while (!node->leaf) {
+        const Inner* inner{static_cast<const Inner*>(node)};
+        std::uint32_t n{inner->count.load(std::memory_order_acquire)};
+        std::uint32_t i{bounded ? count_below(inner, n, bound, true) : 0};
+
+        if (i < n) {
+            has_upper = true;
+            upper = inner->keys[i].load(std::memory_order_relaxed);
+        }
+
+        const Node* child{inner->children[i].load(std::memory_order_acquire)};
+
+        if (child == nullptr) {
+            return Probe::Restart;
+        }
+
+        std::uint64_t child_version{read_version(child, locked)};
+
+        if (locked || !validate(inner, version)) {
+            return Probe::Restart;
+        }
+
+        node = child;
+        version = child_version;
+    }
+
+    std::uint32_t n{node->count.load(std::memory_order_relaxed)};
+    std::uint32_t pos{bounded ? count_below(node, n, bound, false) : 0};
+    Probe probe{pos < n ? Probe::Found : has_upper ? Probe::Next : Probe::Exhausted};
+    double key{pos < n ? node->keys[pos].load(std::memory_order_relaxed) : upper};
+
+    if (!validate(node, version)) {
+        return Probe::Restart;
+    }
+
+    (probe == Probe::Found ? out : bound) = key;
+    return probe;
+}
+
+// One attempt at finding the last key < bound (any key when not bounded).
+// Returns Next with bound lowered to the lower separator of an emptied leaf,
+// or Exhausted when that leaf was the leftmost.
+ConcurrentOrderedSet::Probe ConcurrentOrderedSet::last_before(bool bounded, double& bound, double& out) const {
+    bool locked{false};
+    const Node* node{root.load(std::memory_order_acquire)};
+    std::uint64_t version{read_version(node, locked)};
+    bool has_lower{false};
+    double lower{0.0};
+
+    if (locked || node != root.load(std::memory_order_acquire)) {
+        return Probe::Restart;
+    }
+
+    while (!node->leaf) {
+        const Inner* inner{static_cast<const Inner*>(node)};
+        std::uint32_t n{inner->count.load(std::memory_order_acquire)};
+        std::uint32_t i{bounded ? count_below(inner, n, bound, false) : n};
+
+        if (i > 0) {
+            has_lower = true;
+            lower = inner->keys[i - 1].load(std::memory_order_relaxed);
+        }
+
+        const Node* child{inner->children[i].load(std::memory_order_acquire)};
+
+        if (child == nullptr) {
+            return Probe::Restart;
+        }
+
+        std::uint64_t child_version{read_version(child, locked)};
+
+        if (locked || !validate(inner, version)) {
+            return Probe::Restart;
+        }
+
+        node = child;
+        version = child_version;
+    }
+
+    std::uint32_t n{node->count.load(std::memory_order_relaxed)};
+    std::uint32_t pos{bounded ? count_below(node, n, bound, false) : n};
+    Probe probe{pos > 0 ? Probe::Found : has_lower ? Probe::Next : Probe::Exhausted};
+    double key{pos > 0 ? node->keys[pos - 1].load(std::memory_order_relaxed) : lower};
+
+    if (!validate(node, version)) {
+        return Probe::Restart;
+    }
+
+    (probe == Probe::Found ? out : bound) = key;
+    return probe;
+}
+
+void ConcurrentOrderedSet::destroy(Node* node) {
+    if (node->leaf) {
+        delete node;
+        return;
+    }
+
+    Inner* inner{static_cast<Inner*>(node)};
+
+    for (std::uint32_t i{0}; i <= inner->count.load(std::memory_order_relaxed); ++i) {
+        destroy(inner->children[i].load(std::memory_order_relaxed));
+    }
+
+    delete inner;
+}
+
+bool ConcurrentOrderedSet::is_valid(const Node* node, const double* low, const double* high, std::size_t depth, std::size_t& leaf_depth, std::size_t& keys) const {
+    std::uint32_t n{node->count.load(std::memory_order_relaxed)};
+
+    if (n > capacity || (node->version.load(std::memory_order_relaxed) & 1) != 0) {
+        return false;
+    }
+
+    double prev{0.0};
+
+    for (std::uint32_t i{0}; i < n; ++i) {
+        double key{node->keys[i].load(std::memory_order_relaxed)};
+
+        if ((i > 0 && key <= prev) || (low != nullptr && key < *low) || (high != nullptr && key >= *high)) {
+            return false;
+        }
+
+        prev = key;
+    }
+
+    if (node->leaf) {
+        if (leaf_depth == 0) {
+            leaf_depth = depth;
+        }
+
+        keys += n;
+        return depth == leaf_depth;
+    }
+
+    const Inner* inner{static_cast<const Inner*>(node)};
+    double separators[capacity];
+
+    for (std::uint32_t i{0}; i < n; ++i) {
+        separators[i] = inner->keys[i].load(std::memory_order_relaxed);
+    }
+
+    for (std::uint32_t i{0}; i <= n; ++i) {
+        const double* child_low{i == 0 ? low : &separators[i - 1]};
+        const double* child_high{i == n ? high : &separators[i]};
+
+        if (!is_valid(inner->children[i].load(std::memory_order_relaxed), child_low, child_high, depth + 1, leaf_depth, keys)) {
+            return false;
+        }
+    }
+
+    return true;
+}
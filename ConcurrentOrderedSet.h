@@ -0,0 +1,68 @@
+#ifndef CONCURRENTORDEREDSET_H
+#define CONCURRENTORDEREDSET_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Ordered set of doubles for many threads, stored as a B+tree under optimistic
+// lock coupling. Every node carries a version that is odd while a writer holds
+// it. Readers take no locks: they note a node's version, read it, and check the
+// version is unchanged before trusting what they read, restarting from the root
+// otherwise. Writers descend the same way and lock only the leaf they change,
+// plus a full node and its parent while splitting it on the way down. Erase
+// never merges nodes, so no node is freed while the set is alive and readers
+// can follow any pointer they have loaded; emptied leaves stay in place.
+// min and max return NaN when the set is empty.
+class ConcurrentOrderedSet {
+    public:
+        ConcurrentOrderedSet();
+        ConcurrentOrderedSet(const ConcurrentOrderedSet& orig) = delete;
+        ConcurrentOrderedSet(ConcurrentOrderedSet&& orig) noexcept = delete;
+        ConcurrentOrderedSet& operator=(const ConcurrentOrderedSet& rhs) = delete;
+        ConcurrentOrderedSet& operator=(ConcurrentOrderedSet&& rhs) noexcept = delete;
+        ~ConcurrentOrderedSet();
+        std::size_t get_size() const;
+        bool empty() const;
+        void insert(double value);
+        bool contains(double value) const;
+        double min() const;
+        double max() const;
+        void erase(double value);
+        bool is_valid() const;
+
+    private:
+        static constexpr std::uint32_t capacity{16}; // Keys per node
+
+        struct alignas(64) Node {
+            std::atomic<std::uint64_t> version{0};
+            std::atomic<std::uint32_t> count{0};
+            const bool leaf;
+            std::atomic<double> keys[capacity]; // For inner nodes, keys in children[i + 1] are >= keys[i]
+            explicit Node(bool is_leaf): leaf{is_leaf}, keys{} {}
+        };
+
+        struct Inner : Node {
+            std::atomic<Node*> children[capacity + 1];
+            Inner(): Node{false}, children{} {}
+        };
+
+        enum class Probe { Restart, Found, Next, Exhausted };
+
+        std::atomic<Node*> root;
+        std::atomic<std::size_t> size;
+        static std::uint64_t read_version(const Node* node, bool& locked);
+        static bool validate(const Node* node, std::uint64_t version);
+        static bool try_lock(Node* node, std::uint64_t version);
+        static void unlock(Node* node);
+        static std::uint32_t count_below(const Node* node, std::uint32_t n, double value, bool inclusive);
+        Node* find_leaf(double value, std::uint64_t& version) const;
+        bool try_insert(double value);
+        void split(Inner* parent, std::uint64_t parent_version, Node* node, std::uint64_t version);
+        Probe first_from(bool bounded, double& bound, double& out) const;
+        Probe last_before(bool bounded, double& bound, double& out) const;
+        static void destroy(Node* node);
+        bool is_valid(const Node* node, const double* low, const double* high, std::size_t depth, std::size_t& leaf_depth, std::size_t& keys) const;
+};
+
+#endif
@@ -0,0 +1,10 @@
+#include "DenseHashMap.h"
+
+#include <cstdint>
+#include <string>
+
+// DenseHashMap is a class template defined in DenseHashMap.h; instantiating
+// the common maps here type-checks every member even when no caller uses it
+template class DenseHashMap<>;
+template class DenseHashMap<std::int64_t, std::int64_t>;
+template class DenseHashMap<std::string, int>;
@@ -0,0 +1,533 @@
+#ifndef DENSEHASHMAP_H
+#define DENSEHASHMAP_H
+
+#include "HashMap.h"
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <new>
+#include <utility>
+
+// HashMap with a dense layout: entries live back to back in one array, in
+// insertion order until a removal moves the last entry into the hole, and the
+// bucket table only holds indices into it. Chains are threaded through a
+// parallel array of links that also caches each entry's hash, so iteration,
+// copy and clear are linear sweeps, and growing the table never rehashes keys.
+template <typename K = int, typename V = int, typename Hash = MixHash, typename Eq = std::equal_to<>>
+class DenseHashMap {
+    private:
+        struct Entry {
+            K key;
+            V value;
+        };
+
+        struct Link {
+            std::uint64_t hash;
+            std::size_t next; // Next entry in the same bucket, or npos
+        };
+
+    public:
+        template <bool Const>
+        class Iterator;
+        using iterator = Iterator<false>;
+        using const_iterator = Iterator<true>;
+
+        DenseHashMap();
+        DenseHashMap(const DenseHashMap& orig);
+        DenseHashMap(DenseHashMap&& orig) noexcept;
+        DenseHashMap& operator=(const DenseHashMap& rhs);
+        DenseHashMap& operator=(DenseHashMap&& rhs) noexcept;
+        ~DenseHashMap();
+        std::size_t get_size() const;
+        std::size_t get_capacity() const;
+        double load_factor() const;
+        bool empty() const;
+        void clear();
+        void reserve(std::size_t n);
+        void insert(const K& key, const V& value);
+        template <typename... Args>
+        bool try_emplace(const K& key, Args&&... args);
+        template <typename M>
+        bool insert_or_assign(const K& key, M&& value);
+        bool contains(const K& key) const;
+        bool get(const K& key, V& out) const;
+        V* find(const K& key);
+        const V* find(const K& key) const;
+        void remove(const K& key);
+        iterator begin();
+        iterator end();
+        const_iterator begin() const;
+        const_iterator end() const;
+        template <typename F>
+        void for_each(F f);
+        template <typename F>
+        void for_each(F f) const;
+
+    private:
+        static_assert(alignof(Entry) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__, "Entry needs over-aligned storage");
+
+        static constexpr std::size_t npos{static_cast<std::size_t>(-1)};
+        static constexpr std::size_t initial_capacity{16}; // Must be a power of two
+
+        std::size_t size;
+        std::size_t entry_capacity; // Slots in entries and links
+        std::size_t capacity;       // Number of buckets, always a power of two
+        Entry* entries;             // Raw storage; only [0, size) is constructed
+        Link* links;
+        std::size_t* index;         // Bucket -> first entry index, or npos
+        Hash hasher;
+        Eq equal;
+        static Entry* allocate_entries(std::size_t n);
+        static std::size_t capacity_for(std::size_t n);
+        std::size_t find_index(const K& key, std::uint64_t h) const;
+        void grow_entries(std::size_t new_capacity);
+        void rebuild_index(std::size_t new_capacity);
+        template <typename... Args>
+        void append(std::uint64_t h, const K& key, Args&&... args);
+        void destroy_all();
+        void copy_from(const DenseHashMap& orig);
+};
+
+// Random-access position in the entry array, dereferencing to a (key, value)
+// pair of references. Any insert or remove invalidates it.
+template <typename K, typename V, typename Hash, typename Eq>
+template <bool Const>
+class DenseHashMap<K, V, Hash, Eq>::Iterator {
+    public:
+        using EntryPtr = std::conditional_t<Const, const Entry*, Entry*>;
+        using ValueRef = std::conditional_t<Const, const V&, V&>;
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::pair<const K, V>;
+        using difference_type = std::ptrdiff_t;
+        using reference = std::pair<const K&, ValueRef>;
+        using pointer = void;
+
+        Iterator(): curr{nullptr} {
+
+        }
+
+        // iterator converts to const_iterator
+        template <bool OtherConst, typename = std::enable_if_t<Const && !OtherConst>>
+        Iterator(const Iterator<OtherConst>& other): curr{other.curr} {
+
+        }
+
+        reference operator*() const {
+            return {curr->key, curr->value};
+        }
+
+        const K& key() const {
+            return curr->key;
+        }
+
+        ValueRef value() const {
+            return curr->value;
+        }
+
+        Iterator& operator++() {
+            ++curr;
+            return *this;
+        }
+
+        Iterator operator++(int) {
+            Iterator temp{*this};
+            ++curr;
+            return temp;
+        }
+
+        bool operator==(const Iterator& rhs) const {
+            return curr == rhs.curr;
+        }
+
+        bool operator!=(const Iterator& rhs) const {
+            return curr != rhs.curr;
+        }
+
+    private:
+        explicit Iterator(EntryPtr new_curr): curr{new_curr} {
+
+        }
+
+        EntryPtr curr;
+
+    template <bool>
+    friend class Iterator;
+
+    friend class DenseHashMap;
+};
+
+template <typename K, typename V, typename Hash, typename Eq>
+DenseHashMap<K, V, Hash, Eq>::DenseHashMap(): size{0}, entry_capacity{initial_capacity}, capacity{initial_capacity},
+                                               entries{allocate_entries(initial_capacity)}, links{new Link[initial_capacity]},
+                                               index{new std::size_t[initial_capacity]}, hasher{}, equal{} {
+    std::memset(index, 0xff, capacity * sizeof(std::size_t));
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+DenseHashMap<K, V, Hash, Eq>::DenseHashMap(const DenseHashMap& orig): size{0}, entry_capacity{orig.entry_capacity}, capacity{orig.capacity},
+                                                                      entries{allocate_entries(entry_capacity)}, links{new Link[entry_capacity]},
+                                                                      index{new std::size_t[capacity]}, hasher{orig.hasher}, equal{orig.equal} {
+    copy_from(orig);
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+DenseHashMap<K, V, Hash, Eq>::DenseHashMap(DenseHashMap&& orig) noexcept: size{orig.size}, entry_capacity{orig.entry_capacity}, capacity{orig.capacity},
+                                                                          entries{orig.entries}, links{orig.links}, index{orig.index},
+                                                                          hasher{orig.hasher}, equal{orig.equal} {
+    orig.size = 0;
+    orig.entry_capacity = 0;
+    orig.capacity = 0;
+    orig.entries = nullptr;
+    orig.links = nullptr;
+    orig.index = nullptr;
+    orig.rebuild_index(initial_capacity);
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+DenseHashMap<K, V, Hash, Eq>& DenseHashMap<K, V, Hash, Eq>::operator=(const DenseHashMap& rhs) {
+    if (this == &rhs) {
+        return *this;
+    }
+
+    destroy_all();
+    ::operator delete(entries);
+    delete[] links;
+    delete[] index;
+    entry_capacity = rhs.entry_capacity;
+    capacity = rhs.capacity;
+    entries = allocate_entries(entry_capacity);
+    links = new Link[entry_capacity];
+    index = new std::size_t[capacity];
+    hasher = rhs.hasher;
+    equal = rhs.equal;
+    copy_from(rhs);
+
+    return *this;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+DenseHashMap<K, V, Hash, Eq>& DenseHashMap<K, V, Hash, Eq>::operator=(DenseHashMap&& rhs) noexcept {
+    if (this == &rhs) {
+        return *this;
+    }
+
+    destroy_all();
+    ::operator delete(entries);
+    delete[] links;
+    delete[] index;
+    size = rhs.size;
+    entry_capacity = rhs.entry_capacity;
+    capacity = rhs.capacity;
+    entries = rhs.entries;
+    links = rhs.links;
+    index = rhs.index;
+    hasher = rhs.hasher;
+    equal = rhs.equal;
+    rhs.size = 0;
+    rhs.entry_capacity = 0;
+    rhs.capacity = 0;
+    rhs.entries = nullptr;
+    rhs.links = nullptr;
+    rhs.index = nullptr;
+    rhs.rebuild_index(initial_capacity);
+
+    return *this;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+DenseHashMap<K, V, Hash, Eq>::~DenseHashMap() {
+    destroy_all();
+    ::operator delete(entries);
+    delete[] links;
+    delete[] index;
+    entries = nullptr;
+    links = nullptr;
+    index = nullptr;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+std::size_t DenseHashMap<K, V, Hash, Eq>::get_size() const {
+    return size;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+std::size_t DenseHashMap<K, V, Hash, Eq>::get_capacity() const {
+    return capacity;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+double DenseHashMap<K, V, Hash, Eq>::load_factor() const {
+    return 1.0 * size / capacity;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+bool DenseHashMap<K, V, Hash, Eq>::empty() const {
+    return size == 0;
+}
+
+// Destroys the entries front to back and resets the bucket table with one memset
+template <typename K, typename V, typename Hash, typename Eq>
+void DenseHashMap<K, V, Hash, Eq>::clear() {
+    destroy_all();
+    std::memset(index, 0xff, capacity * sizeof(std::size_t));
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+void DenseHashMap<K, V, Hash, Eq>::reserve(std::size_t n) {
+    if (n > entry_capacity) {
+        grow_entries(n);
+    }
+
+    std::size_t new_capacity{capacity_for(n)};
+
+    if (new_capacity > capacity) {
+        rebuild_index(new_capacity);
+    }
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+void DenseHashMap<K, V, Hash, Eq>::insert(const K& key, const V& value) {
+    insert_or_assign(key, value);
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+template <typename... Args>
+bool DenseHashMap<K, V, Hash, Eq>::try_emplace(const K& key, Args&&... args) {
+    std::uint64_t h{hasher(key)};
+
+    if (find_index(key, h) != npos) {
+        return false;
+    }
+
+    append(h, key, std::forward<Args>(args)...);
+    return true;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+template <typename M>
+bool DenseHashMap<K, V, Hash, Eq>::insert_or_assign(const K& key, M&& value) {
+    std::uint64_t h{hasher(key)};
+    std::size_t i{find_index(key, h)};
+
+    if (i != npos) {
+        entries[i].value = std::forward<M>(value);
+        return false;
+    }
+
+    append(h, key, std::forward<M>(value));
+    return true;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+bool DenseHashMap<K, V, Hash, Eq>::contains(const K& key) const {
+    return find_index(key, hasher(key)) != npos;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+bool DenseHashMap<K, V, Hash, Eq>::get(const K& key, V& out) const {
+    std::size_t i{find_index(key, hasher(key))};
+
+    if (i == npos) {
+        return false;
+    }
+
+    out = entries[i].value;
+    return true;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+V* DenseHashMap<K, V, Hash, Eq>::find(const K& key) {
+    std::size_t i{find_index(key, hasher(key))};
+    return i == npos ? nullptr : &entries[i].value;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+const V* DenseHashMap<K, V, Hash, Eq>::find(const K& key) const {
+    std::size_t i{find_index(key, hasher(key))};
+    return i == npos ? nullptr : &entries[i].value;
+}
+
+// Unlinks the entry, then moves the last entry into its slot and repoints the
+// one link that referred to the last entry, so the array stays gap-free
+template <typename K, typename V, typename Hash, typename Eq>
+void DenseHashMap<K, V, Hash, Eq>::remove(const K& key) {
+    std::uint64_t h{hasher(key)};
+    std::size_t* link{&index[h & (capacity - 1)]};
+
+    while (*link != npos && !(links[*link].hash == h && equal(entries[*link].key, key))) {
+        link = &links[*link].next;
+    }
+
+    if (*link == npos) {
+        return;
+    }
+
+    std::size_t i{*link};
+    *link = links[i].next;
+    std::size_t last{size - 1};
+
+    if (i != last) {
+        std::size_t* to_last{&index[links[last].hash & (capacity - 1)]};
+
+        while (*to_last != last) {
+            to_last = &links[*to_last].next;
+        }
+
+        *to_last = i;
+        entries[i].key = std::move(entries[last].key);
+        entries[i].value = std::move(entries[last].value);
+        links[i] = links[last];
+    }
+
+    entries[last].~Entry();
+    --size;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+typename DenseHashMap<K, V, Hash, Eq>::iterator DenseHashMap<K, V, Hash, Eq>::begin() {
+    return iterator{entries};
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+typename DenseHashMap<K, V, Hash, Eq>::iterator DenseHashMap<K, V, Hash, Eq>::end() {
+    return iterator{entries + size};
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+typename DenseHashMap<K, V, Hash, Eq>::const_iterator DenseHashMap<K, V, Hash, Eq>::begin() const {
+    return const_iterator{entries};
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+typename DenseHashMap<K, V, Hash, Eq>::const_iterator DenseHashMap<K, V, Hash, Eq>::end() const {
+    return const_iterator{entries + size};
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+template <typename F>
+void DenseHashMap<K, V, Hash, Eq>::for_each(F f) {
+    for (std::size_t i{0}; i < size; ++i) {
+        f(static_cast<const K&>(entries[i].key), entries[i].value);
+    }
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+template <typename F>
+void DenseHashMap<K, V, Hash, Eq>::for_each(F f) const {
+    for (std::size_t i{0}; i < size; ++i) {
+        f(entries[i].key, entries[i].value);
+    }
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+typename DenseHashMap<K, V, Hash, Eq>::Entry* DenseHashMap<K, V, Hash, Eq>::allocate_entries(std::size_t n) {
+    return static_cast<Entry*>(::operator new(n * sizeof(Entry)));
+}
+
+// Smallest power-of-two bucket count that keeps n entries at or under the 0.7 load factor
+template <typename K, typename V, typename Hash, typename Eq>
+std::size_t DenseHashMap<K, V, Hash, Eq>::capacity_for(std::size_t n) {
+    std::size_t result{initial_capacity};
+
+    while (n * 10 > result * 7) {
+        result *= 2;
+    }
+
+    return result;
+}
+
+// The cached hash is compared first, so most chain steps never touch the entry array
+template <typename K, typename V, typename Hash, typename Eq>
+std::size_t DenseHashMap<K, V, Hash, Eq>::find_index(const K& key, std::uint64_t h) const {
+    for (std::size_t i{index[h & (capacity - 1)]}; i != npos; i = links[i].next) {
+        if (links[i].hash == h && equal(entries[i].key, key)) {
+            return i;
+        }
+    }
+
+    return npos;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+void DenseHashMap<K, V, Hash, Eq>::grow_entries(std::size_t new_capacity) {
+    Entry* new_entries{allocate_entries(new_capacity)};
+    Link* new_links{new Link[new_capacity]};
+
+    for (std::size_t i{0}; i < size; ++i) {
+        new (&new_entries[i]) Entry{std::move(entries[i].key), std::move(entries[i].value)};
+        entries[i].~Entry();
+    }
+
+    std::memcpy(new_links, links, size * sizeof(Link));
+    ::operator delete(entries);
+    delete[] links;
+    entries = new_entries;
+    links = new_links;
+    entry_capacity = new_capacity;
+}
+
+// Rethreads every chain from the cached hashes in one pass over the links
+template <typename K, typename V, typename Hash, typename Eq>
+void DenseHashMap<K, V, Hash, Eq>::rebuild_index(std::size_t new_capacity) {
+    if (entries == nullptr) {
+        entries = allocate_entries(new_capacity);
+        links = new Link[new_capacity];
+        entry_capacity = new_capacity;
+    }
+
+    delete[] index;
+    index = new std::size_t[new_capacity];
+    capacity = new_capacity;
+    std::memset(index, 0xff, capacity * sizeof(std::size_t));
+
+    for (std::size_t i{0}; i < size; ++i) {
+        std::size_t& head{index[links[i].hash & (capacity - 1)]};
+        links[i].next = head;
+        head = i;
+    }
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+template <typename... Args>
+void DenseHashMap<K, V, Hash, Eq>::append(std::uint64_t h, const K& key, Args&&... args) {
+    if (size == entry_capacity) {
+        grow_entries(entry_capacity * 2);
+    }
+
+    new (&entries[size]) Entry{key, V(std::forward<Args>(args)...)};
+    std::size_t& head{index[h & (capacity - 1)]};
+    links[size] = Link{h, head};
+    head = size;
+    ++size;
+
+    if (size * 10 > capacity * 7) {
+        rebuild_index(capacity * 2);
+    }
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+void DenseHashMap<K, V, Hash, Eq>::destroy_all() {
+    for (std::size_t i{0}; i < size; ++i) {
+        entries[i].~Entry();
+    }
+
+    size = 0;
+}
+
+// Assumes this map is empty with storage sized like orig's
+template <typename K, typename V, typename Hash, typename Eq>
+void DenseHashMap<K, V, Hash, Eq>::copy_from(const DenseHashMap& orig) {
+    for (std::size_t i{0}; i < orig.size; ++i) {
+        new (&entries[i]) Entry{orig.entries[i].key, orig.entries[i].value};
+    }
+
+    std::memcpy(links, orig.links, orig.size * sizeof(Link));
+    std::memcpy(index, orig.index, capacity * sizeof(std::size_t));
+    size = orig.size;
+}
+
+#endif
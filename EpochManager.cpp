@@ -0,0 +1,127 @@
+#include "EpochManager.h"
+
+#include <functional>
+#include <thread>
+
+class RetiredNode {
+    private:
+        RetiredNode(void* new_ptr, void (*new_deleter)(void*), std::uint64_t new_epoch):
+            ptr{new_ptr}, deleter{new_deleter}, epoch{new_epoch}, next{nullptr} {
+
+        }
+
+        void* ptr;
+        void (*deleter)(void*);
+        std::uint64_t epoch;
+        RetiredNode* next;
+
+    friend class EpochManager;
+};
+
+// Retired pointers collected before try_reclaim runs on its own
+static constexpr std::size_t reclaim_threshold{64};
+
+EpochManager::EpochManager(): global_epoch{1}, head{nullptr}, tail{nullptr}, pending{0} {
+
+}
+
+// No reader may be pinned once the manager is destroyed, so everything can go
+EpochManager::~EpochManager() {
+    while (head != nullptr) {
+        RetiredNode* temp{head};
+        head = head->next;
+        temp->deleter(temp->ptr);
+        delete temp;
+    }
+
+    tail = nullptr;
+    pending = 0;
+}
+
+// Claims a free slot, starting from the one this thread used last, and records
+// the current epoch in it. Returns the slot for unpin.
+std::size_t EpochManager::pin() {
+    static thread_local std::size_t hint{std::hash<std::thread::id>{}(std::this_thread::get_id())};
+    std::uint64_t epoch{global_epoch.load()};
+
+    for (std::size_t k{0}; ; ++k) {
+        std::size_t i{(hint + k) % max_readers};
+        std::uint64_t expected{0};
+
+        if (slots[i].epoch.load(std::memory_order_relaxed) == 0 && slots[i].epoch.compare_exchange_strong(expected, epoch)) {
+            hint = i;
+            return i;
+        }
+    }
+}
+
+void EpochManager::unpin(std::size_t slot) {
+    slots[slot].epoch.store(0, std::memory_order_release);
+}
+
+// ptr must already be unreachable for readers that pin after this call
+void EpochManager::retire(void* ptr, void (*deleter)(void*)) {
+    bool reclaim{false};
+
+    {
+        std::lock_guard<std::mutex> guard{retire_lock};
+        RetiredNode* node{new RetiredNode{ptr, deleter, global_epoch.load()}};
+
+        if (tail == nullptr) {
+            head = node;
+        } else {
+            tail->next = node;
+        }
+
+        tail = node;
+        ++pending;
+        reclaim = pending >= reclaim_threshold;
+    }
+
+    if (reclaim) {
+        try_reclaim();
+    }
+}
+
+// Advances the global epoch if every pinned reader has seen the current one,
+// then frees whatever was retired at least two epochs ago
+void EpochManager::try_reclaim() {
+    std::uint64_t epoch{global_epoch.load()};
+    bool can_advance{true};
+
+    for (std::size_t i{0}; i < max_readers; ++i) {
+        std::uint64_t pinned{slots[i].epoch.load()};
+
+        if (pinned != 0 && pinned != epoch) {
+            can_advance = false;
+            break;
+        }
+    }
+
+    if (can_advance && global_epoch.compare_exchange_strong(epoch, epoch + 1)) {
+        ++epoch;
+    }
+
+    std::lock_guard<std::mutex> guard{retire_lock};
+    free_retired(epoch);
+}
+
+std::size_t EpochManager::get_pending() const {
+    std::lock_guard<std::mutex> guard{retire_lock};
+    return pending;
+}
+
+// Retired nodes are appended in epoch order, so only a prefix can be freed
+void EpochManager::free_retired(std::uint64_t epoch) {
+    while (head != nullptr && head->epoch + 2 <= epoch) {
+        RetiredNode* temp{head};
+        head = head->next;
+        temp->deleter(temp->ptr);
+        delete temp;
+        --pending;
+    }
+
+    if (head == nullptr) {
+        tail = nullptr;
+    }
+}
@@ -0,0 +1,67 @@
+#ifndef EPOCHMANAGER_H
+#define EPOCHMANAGER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+class RetiredNode;
+
+// Epoch-based reclamation. Readers pin the current epoch for the duration of a
+// lock-free traversal; memory unlinked by a writer is retired with the epoch it
+// was retired in and freed only once the global epoch has advanced twice past
+// it, at which point no pinned reader can still hold a reference.
+class EpochManager {
+    public:
+        static constexpr std::size_t max_readers{128}; // Threads that can be pinned at the same time
+
+        EpochManager();
+        EpochManager(const EpochManager& orig) = delete;
+        EpochManager(EpochManager&& orig) noexcept = delete;
+        EpochManager& operator=(const EpochManager& rhs) = delete;
+        EpochManager& operator=(EpochManager&& rhs) noexcept = delete;
+        ~EpochManager();
+        std::size_t pin();
+        void unpin(std::size_t slot);
+        void retire(void* ptr, void (*deleter)(void*));
+        void try_reclaim();
+        std::size_t get_pending() const;
+
+    private:
+        // Epoch the occupying reader pinned, or 0 when the slot is free
+        struct alignas(64) Slot {
+            std::atomic<std::uint64_t> epoch{0};
+        };
+
+        std::atomic<std::uint64_t> global_epoch;
+        Slot slots[max_readers];
+        mutable std::mutex retire_lock;
+        RetiredNode* head;
+        RetiredNode* tail;
+        std::size_t pending;
+        void free_retired(std::uint64_t epoch);
+};
+
+// Pins the epoch for the lifetime of the guard
+class EpochGuard {
+    public:
+        explicit EpochGuard(EpochManager& new_manager): manager{new_manager}, slot{manager.pin()} {
+
+        }
+
+        EpochGuard(const EpochGuard& orig) = delete;
+        EpochGuard(EpochGuard&& orig) noexcept = delete;
+        EpochGuard& operator=(const EpochGuard& rhs) = delete;
+        EpochGuard& operator=(EpochGuard&& rhs) noexcept = delete;
+
+        ~EpochGuard() {
+            manager.unpin(slot);
+        }
+
+    private:
+        EpochManager& manager;
+        std::size_t slot;
+};
+
+#endif
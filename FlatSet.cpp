@@ -0,0 +1,426 @@
+#include "FlatSet.h"
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+#include <vector>
+
+static constexpr std::size_t npos{static_cast<std::size_t>(-1)};
+
+// Index of the first key >= value, or the key count. The loop runs a fixed
+// log2(n) times and moves base by multiplying with the comparison, so there is
+// no branch for the predictor to miss.
+static std::size_t lower_index(const DynamicArray& keys, double value) {
+    std::size_t n{keys.get_size()};
+
+    if (n == 0) {
+        return 0;
+    }
+
+    const double* first{&keys[0]};
+    const double* base{first};
+
+    while (n > 1) {
+        std::size_t half{n / 2};
+        base += static_cast<std::size_t>(base[half] < value) * half;
+        n -= half;
+    }
+
+    return static_cast<std::size_t>(base - first) + (*base < value);
+}
+
+static std::size_t find_pending(const DynamicArray& pending, double value) {
+    for (std::size_t i{0}; i < pending.get_size(); ++i) {
+        if (pending[i] == value) {
+            return i;
+        }
+    }
+
+    return npos;
+}
+
+// Grows keys by at least half, so repeated merges do not copy it every time
+static void reserve_for(DynamicArray& keys, std::size_t needed) {
+    if (needed > keys.get_capacity()) {
+        keys.reserve(std::max(needed, keys.get_capacity() + keys.get_capacity() / 2));
+    }
+}
+
+// Sorts extra, whose keys keys lacks, and merges it into keys from the back, in place
+static void merge_into(DynamicArray& keys, DynamicArray& extra) {
+    std::size_t n{keys.get_size()};
+    std::size_t m{extra.get_size()};
+
+    if (m == 0) {
+        return;
+    }
+
+    std::sort(&extra[0], &extra[0] + m);
+    reserve_for(keys, n + m);
+    keys.resize(n + m);
+    double* out{&keys[0]};
+    const double* add{&extra[0]};
+
+    for (std::size_t k{n + m}; m > 0; --k) {
+        if (n > 0 && out[n - 1] > add[m - 1]) {
+            out[k - 1] = out[--n];
+        } else {
+            out[k - 1] = add[--m];
+        }
+    }
+}
+
+FlatSet::FlatSet(): keys{}, pending{} {
+
+}
+
+// Sorts and deduplicates a copy of values
+FlatSet::FlatSet(const double* values, std::size_t n): keys{n}, pending{} {
+    std::vector<double> sorted(values, values + n);
+    std::sort(sorted.begin(), sorted.end());
+    sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+
+    for (double value : sorted) {
+        keys.push_back(value);
+    }
+}
+
+FlatSet::FlatSet(const FlatSet& orig): keys{orig.keys}, pending{orig.pending} {
+
+}
+
+FlatSet::FlatSet(FlatSet&& orig) noexcept: keys{std::move(orig.keys)}, pending{std::move(orig.pending)} {
+
+}
+
+FlatSet& FlatSet::operator=(const FlatSet& rhs) {
+    if (this == &rhs) {
+        return *this;
+    }
+
+    keys = rhs.keys;
+    pending = rhs.pending;
+
+    return *this;
+}
+
+FlatSet& FlatSet::operator=(FlatSet&& rhs) noexcept {
+    if (this == &rhs) {
+        return *this;
+    }
+
+    keys = std::move(rhs.keys);
+    pending = std::move(rhs.pending);
+
+    return *this;
+}
+
+FlatSet::~FlatSet() {
+
+}
+
+void FlatSet::clear() {
+    keys.clear();
+    pending.clear();
+}
+
+std::size_t FlatSet::get_size() const {
+    return keys.get_size() + pending.get_size();
+}
+
+bool FlatSet::empty() const {
+    return get_size() == 0;
+}
+
+void FlatSet::insert(double value) {
+    if (contains(value)) {
+        return;
+    }
+
+    pending.push_back(value);
+
+    if (pending.get_size() >= batch_limit) {
+        flush();
+    }
+}
+
+// Sorts the new values once and merges them in a single pass
+void FlatSet::insert(const double* values, std::size_t n) {
+    flush();
+    std::vector<double> sorted(values, values + n);
+    std::sort(sorted.begin(), sorted.end());
+    sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+    DynamicArray added{sorted.size()};
+    std::size_t i{0};
+
+    for (double value : sorted) {
+        while (i < keys.get_size() && keys[i] < value) {
+            ++i;
+        }
+
+        if (i == keys.get_size() || keys[i] != value) {
+            added.push_back(value);
+        }
+    }
+
+    merge_into(keys, added);
+}
+
+bool FlatSet::contains(double value) const {
+    std::size_t i{lower_index(keys, value)};
+
+    return (i < keys.get_size() && keys[i] == value) || find_pending(pending, value) != npos;
+}
+
+double FlatSet::min() const {
+    assert(!empty());
+    double result{keys.empty() ? pending[0] : keys.front()};
+
+    for (std::size_t i{0}; i < pending.get_size(); ++i) {
+        result = std::min(result, pending[i]);
+    }
+
+    return result;
+}
+
+double FlatSet::max() const {
+    assert(!empty());
+    double result{keys.empty() ? pending[0] : keys.back()};
+
+    for (std::size_t i{0}; i < pending.get_size(); ++i) {
+        result = std::max(result, pending[i]);
+    }
+
+    return result;
+}
+
+void FlatSet::erase(double value) {
+    std::size_t p{find_pending(pending, value)};
+
+    if (p != npos) {
+        pending[p] = pending.back();
+        pending.pop_back();
+        return;
+    }
+
+    std::size_t i{lower_index(keys, value)};
+
+    if (i < keys.get_size() && keys[i] == value) {
+        keys.erase(i);
+    }
+}
+
+// Merges the pending inserts into the sorted array now rather than at the next full batch
+void FlatSet::flush() {
+    merge_into(keys, pending);
+    pending.clear();
+}
+
+// Copies the keys into out in ascending order
+void FlatSet::to_array(DynamicArray& out) {
+    flush();
+    out = keys;
+}
+
+FlatMap::FlatMap(): keys{}, values{}, pending_keys{}, pending_values{} {
+
+}
+
+// A key repeated in new_keys keeps its last value
+FlatMap::FlatMap(const double* new_keys, const double* new_values, std::size_t n): keys{n}, values{n}, pending_keys{}, pending_values{} {
+    std::vector<std::pair<double, double>> entries(n);
+
+    for (std::size_t i{0}; i < n; ++i) {
+        entries[i] = {new_keys[i], new_values[i]};
+    }
+
+    std::stable_sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    for (std::size_t i{0}; i < n; ++i) {
+        if (i + 1 < n && entries[i + 1].first == entries[i].first) {
+            continue;
+        }
+
+        keys.push_back(entries[i].first);
+        values.push_back(entries[i].second);
+    }
+}
+
+FlatMap::FlatMap(const FlatMap& orig): keys{orig.keys}, values{orig.values}, pending_keys{orig.pending_keys}, pending_values{orig.pending_values} {
+
+}
+
+FlatMap::FlatMap(FlatMap&& orig) noexcept: keys{std::move(orig.keys)}, values{std::move(orig.values)},
+                                          pending_keys{std::move(orig.pending_keys)}, pending_values{std::move(orig.pending_values)} {
+
+}
+
+FlatMap& FlatMap::operator=(const FlatMap& rhs) {
+    if (this == &rhs) {
+        return *this;
+    }
+
+    keys = rhs.keys;
+    values = rhs.values;
+    pending_keys = rhs.pending_keys;
+    pending_values = rhs.pending_values;
+
+    return *this;
+}
+
+FlatMap& FlatMap::operator=(FlatMap&& rhs) noexcept {
+    if (this == &rhs) {
+        return *this;
+    }
+
+    keys = std::move(rhs.keys);
+    values = std::move(rhs.values);
+    pending_keys = std::move(rhs.pending_keys);
+    pending_values = std::move(rhs.pending_values);
+
+    return *this;
+}
+
+FlatMap::~FlatMap() {
+
+}
+
+void FlatMap::clear() {
+    keys.clear();
+    values.clear();
+    pending_keys.clear();
+    pending_values.clear();
+}
+
+std::size_t FlatMap::get_size() const {
+    return keys.get_size() + pending_keys.get_size();
+}
+
+bool FlatMap::empty() const {
+    return get_size() == 0;
+}
+
+void FlatMap::insert(double key, double value) {
+    std::size_t i{lower_index(keys, key)};
+
+    if (i < keys.get_size() && keys[i] == key) {
+        values[i] = value;
+        return;
+    }
+
+    std::size_t p{find_pending(pending_keys, key)};
+
+    if (p != npos) {
+        pending_values[p] = value;
+        return;
+    }
+
+    pending_keys.push_back(key);
+    pending_values.push_back(value);
+
+    if (pending_keys.get_size() >= batch_limit) {
+        flush();
+    }
+}
+
+bool FlatMap::contains(double key) const {
+    std::size_t i{lower_index(keys, key)};
+
+    return (i < keys.get_size() && keys[i] == key) || find_pending(pending_keys, key) != npos;
+}
+
+bool FlatMap::get(double key, double& out) const {
+    std::size_t i{lower_index(keys, key)};
+
+    if (i < keys.get_size() && keys[i] == key) {
+        out = values[i];
+        return true;
+    }
+
+    std::size_t p{find_pending(pending_keys, key)};
+
+    if (p == npos) {
+        return false;
+    }
+
+    out = pending_values[p];
+    return true;
+}
+
+double FlatMap::min() const {
+    assert(!empty());
+    double result{keys.empty() ? pending_keys[0] : keys.front()};
+
+    for (std::size_t i{0}; i < pending_keys.get_size(); ++i) {
+        result = std::min(result, pending_keys[i]);
+    }
+
+    return result;
+}
+
+double FlatMap::max() const {
+    assert(!empty());
+    double result{keys.empty() ? pending_keys[0] : keys.back()};
+
+    for (std::size_t i{0}; i < pending_keys.get_size(); ++i) {
+        result = std::max(result, pending_keys[i]);
+    }
+
+    return result;
+}
+
+void FlatMap::erase(double key) {
+    std::size_t p{find_pending(pending_keys, key)};
+
+    if (p != npos) {
+        pending_keys[p] = pending_keys.back();
+        pending_values[p] = pending_values.back();
+        pending_keys.pop_back();
+        pending_values.pop_back();
+        return;
+    }
+
+    std::size_t i{lower_index(keys, key)};
+
+    if (i < keys.get_size() && keys[i] == key) {
+        keys.erase(i);
+        values.erase(i);
+    }
+}
+
+// Sorts the pending entries by key and merges both arrays from the back, in place
+void FlatMap::flush() {
+    std::size_t n{keys.get_size()};
+    std::size_t m{pending_keys.get_size()};
+
+    if (m == 0) {
+        return;
+    }
+
+    std::vector<std::pair<double, double>> added(m);
+
+    for (std::size_t i{0}; i < m; ++i) {
+        added[i] = {pending_keys[i], pending_values[i]};
+    }
+
+    std::sort(added.begin(), added.end());
+    reserve_for(keys, n + m);
+    reserve_for(values, n + m);
+    keys.resize(n + m);
+    values.resize(n + m);
+
+    for (std::size_t k{n + m}; m > 0; --k) {
+        if (n > 0 && keys[n - 1] > added[m - 1].first) {
+            --n;
+            keys[k - 1] = keys[n];
+            values[k - 1] = values[n];
+        } else {
+            --m;
+            keys[k - 1] = added[m].first;
+            values[k - 1] = added[m].second;
+        }
+    }
+
+    pending_keys.clear();
+    pending_values.clear();
+}
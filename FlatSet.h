@@ -0,0 +1,119 @@
+#ifndef FLATSET_H
+#define FLATSET_H
+
+#include "DynamicArray.h"
+
+#include <cstddef>
+
+// Ordered set of doubles kept as one sorted DynamicArray, with the
+// BinarySearchTree API. A lookup is a branchless binary search over contiguous
+// keys, with no pointers to chase and no per-key allocation, which beats any
+// node-based tree for small and medium read-heavy sets. Inserts of new keys go
+// to a small unsorted buffer that lookups also scan; when it fills it is
+// sorted and merged into the array in one pass, so a run of inserts costs one
+// O(n) merge per batch instead of one O(n) shift per key. Erase shifts the
+// array, so a bulk removal is better done with erase_if.
+class FlatSet {
+    public:
+        FlatSet();
+        FlatSet(const double* values, std::size_t n);
+        FlatSet(const FlatSet& orig);
+        FlatSet(FlatSet&& orig) noexcept;
+        FlatSet& operator=(const FlatSet& rhs);
+        FlatSet& operator=(FlatSet&& rhs) noexcept;
+        ~FlatSet();
+        void clear();
+        std::size_t get_size() const;
+        bool empty() const;
+        void insert(double value);
+        void insert(const double* values, std::size_t n);
+        bool contains(double value) const;
+        double min() const;
+        double max() const;
+        void erase(double value);
+        void flush();
+        void to_array(DynamicArray& out);
+
+        // Erases every key for which pred(key) is true in one pass; returns how many
+        template <typename F>
+        std::size_t erase_if(F pred) {
+            flush();
+            std::size_t n{keys.get_size()};
+            std::size_t kept{0};
+
+            for (std::size_t i{0}; i < n; ++i) {
+                double key{keys[i]};
+
+                if (!pred(key)) {
+                    keys[kept++] = key;
+                }
+            }
+
+            keys.resize(kept);
+            return n - kept;
+        }
+
+    private:
+        static constexpr std::size_t batch_limit{128}; // Pending inserts that every lookup scans before a merge
+
+        DynamicArray keys;    // Sorted and unique
+        DynamicArray pending; // New keys not in keys yet, unsorted
+};
+
+// Map from double keys to double values as two parallel sorted DynamicArrays,
+// batched and searched like FlatSet. Keeping the keys apart from the values
+// packs more of them into each cache line the search touches. insert assigns
+// over an existing key's value.
+class FlatMap {
+    public:
+        FlatMap();
+        FlatMap(const double* new_keys, const double* new_values, std::size_t n);
+        FlatMap(const FlatMap& orig);
+        FlatMap(FlatMap&& orig) noexcept;
+        FlatMap& operator=(const FlatMap& rhs);
+        FlatMap& operator=(FlatMap&& rhs) noexcept;
+        ~FlatMap();
+        void clear();
+        std::size_t get_size() const;
+        bool empty() const;
+        void insert(double key, double value);
+        bool contains(double key) const;
+        bool get(double key, double& out) const;
+        double min() const;
+        double max() const;
+        void erase(double key);
+        void flush();
+
+        // Erases every entry for which pred(key, value) is true in one pass; returns how many
+        template <typename F>
+        std::size_t erase_if(F pred) {
+            flush();
+            std::size_t n{keys.get_size()};
+            std::size_t kept{0};
+
+            for (std::size_t i{0}; i < n; ++i) {
+                double key{keys[i]};
+                double value{values[i]};
+
+                if (!pred(key, value)) {
+                    keys[kept] = key;
+                    values[kept] = value;
+                    ++kept;
+                }
+            }
+
+            keys.resize(kept);
+            values.resize(kept);
+            return n - kept;
+        }
+
+    private:
+        static constexpr std::size_t batch_limit{128};
+
+        DynamicArray keys;
+        DynamicArray values;
+        DynamicArray pending_keys;
+        DynamicArray pending_values;
+};
+
+#endif
@@ -0,0 +1,9 @@
+#include "FrozenHashMap.h"
+
+#include <cstdint>
+
+// FrozenHashMap is a class template defined in FrozenHashMap.h; instantiating
+// the common maps here type-checks every member. save and load need trivially
+// copyable keys and values, so only such maps are instantiated explicitly.
+template class FrozenHashMap<>;
+template class FrozenHashMap<std::int64_t, std::int64_t>;
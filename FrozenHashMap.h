@@ -0,0 +1,561 @@
+#ifndef FROZENHASHMAP_H
+#define FROZENHASHMAP_H
+
+#include "HashMap.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Read-only map over a minimal perfect hash, in the style of PTHash. Keys are
+// split into skewed buckets, and each bucket stores a 16-bit pilot chosen at
+// build time so that every key in it lands on its own slot. Slots past the
+// key count are remapped into the holes below it, so the entry array has no
+// gaps. A lookup is one pilot read, at most one remap read and one entry read,
+// with no probing or chains. The hash overhead is about 3.5 bits per key.
+template <typename K = int, typename V = int, typename Hash = MixHash, typename Eq = std::equal_to<>>
+class FrozenHashMap {
+    public:
+        FrozenHashMap();
+        FrozenHashMap(const FrozenHashMap& orig);
+        FrozenHashMap(FrozenHashMap&& orig) noexcept;
+        FrozenHashMap& operator=(const FrozenHashMap& rhs);
+        FrozenHashMap& operator=(FrozenHashMap&& rhs) noexcept;
+        ~FrozenHashMap();
+        static FrozenHashMap build(const HashMap<K, V, Hash, Eq>& source);
+        std::size_t get_size() const;
+        bool empty() const;
+        bool contains(const K& key) const;
+        bool get(const K& key, V& out) const;
+        const V* find(const K& key) const;
+        double bits_per_key() const;
+        std::size_t image_bytes() const;
+        bool save(const std::string& path) const;
+        bool load(const std::string& path);
+
+    private:
+        struct Entry {
+            K key;
+            V value;
+        };
+
+        // Leads every saved image; the sizes reject images built for other types
+        struct ImageHeader {
+            std::uint64_t magic;
+            std::uint64_t key_bytes;
+            std::uint64_t value_bytes;
+            std::uint64_t size;
+            std::uint64_t bucket_count;
+            std::uint64_t dense_buckets;
+            std::uint64_t table_size;
+            std::uint64_t seed;
+        };
+
+        static constexpr std::uint64_t image_magic{0x32504d48505a5246}; // "FRZPHMP2"
+        static constexpr std::uint32_t dense_threshold{2576980378u};    // 60% of keys go to the dense buckets
+        static constexpr unsigned max_seeds{64};
+
+        std::size_t size;
+        std::size_t bucket_count;
+        std::size_t dense_buckets; // The first 30% of buckets, which take 60% of the keys
+        std::size_t table_size;    // Slots the pilots address; slightly above size
+        std::uint64_t seed;
+        std::uint16_t* pilots;
+        std::uint32_t* remap;      // Slot table_size - size + i maps to remap[i]
+        Entry* entries;
+        Hash hasher;
+        Eq equal;
+        static std::size_t bucket_count_for(std::size_t n);
+        static std::size_t table_size_for(std::size_t n);
+        static std::uint32_t fastrange(std::uint32_t x, std::size_t n);
+        std::uint64_t bucket_hash(const K& key) const;
+        std::size_t bucket_of(std::uint64_t hb) const;
+        static std::uint32_t slot_hash(std::uint64_t hb);
+        std::size_t slot_of(std::uint32_t hs, std::uint16_t pilot) const;
+        const Entry* find_entry(const K& key) const;
+        void allocate(std::size_t new_size, std::size_t new_bucket_count, std::size_t new_table_size);
+        void release();
+        void copy_from(const FrozenHashMap& orig);
+        bool place(const std::vector<std::uint64_t>& hashes);
+};
+
+template <typename K, typename V, typename Hash, typename Eq>
+FrozenHashMap<K, V, Hash, Eq>::FrozenHashMap(): size{0}, bucket_count{0}, dense_buckets{0}, table_size{0}, seed{0},
+                                                 pilots{nullptr}, remap{nullptr}, entries{nullptr}, hasher{}, equal{} {
+
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+FrozenHashMap<K, V, Hash, Eq>::FrozenHashMap(const FrozenHashMap& orig): FrozenHashMap() {
+    copy_from(orig);
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+FrozenHashMap<K, V, Hash, Eq>::FrozenHashMap(FrozenHashMap&& orig) noexcept:
+    size{orig.size}, bucket_count{orig.bucket_count}, dense_buckets{orig.dense_buckets}, table_size{orig.table_size}, seed{orig.seed},
+    pilots{orig.pilots}, remap{orig.remap}, entries{orig.entries}, hasher{orig.hasher}, equal{orig.equal} {
+    orig.pilots = nullptr;
+    orig.remap = nullptr;
+    orig.entries = nullptr;
+    orig.release();
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+FrozenHashMap<K, V, Hash, Eq>& FrozenHashMap<K, V, Hash, Eq>::operator=(const FrozenHashMap& rhs) {
+    if (this == &rhs) {
+        return *this;
+    }
+
+    release();
+    copy_from(rhs);
+
+    return *this;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+FrozenHashMap<K, V, Hash, Eq>& FrozenHashMap<K, V, Hash, Eq>::operator=(FrozenHashMap&& rhs) noexcept {
+    if (this == &rhs) {
+        return *this;
+    }
+
+    release();
+    size = rhs.size;
+    bucket_count = rhs.bucket_count;
+    dense_buckets = rhs.dense_buckets;
+    table_size = rhs.table_size;
+    seed = rhs.seed;
+    pilots = rhs.pilots;
+    remap = rhs.remap;
+    entries = rhs.entries;
+    hasher = rhs.hasher;
+    equal = rhs.equal;
+    rhs.pilots = nullptr;
+    rhs.remap = nullptr;
+    rhs.entries = nullptr;
+    rhs.release();
+
+    return *this;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+FrozenHashMap<K, V, Hash, Eq>::~FrozenHashMap() {
+    release();
+}
+
+// Snapshots source into a new map. Throws std::runtime_error if no seed separates
+// the keys, which only happens when distinct keys share a full 64-bit hash.
+template <typename K, typename V, typename Hash, typename Eq>
+FrozenHashMap<K, V, Hash, Eq> FrozenHashMap<K, V, Hash, Eq>::build(const HashMap<K, V, Hash, Eq>& source) {
+    FrozenHashMap result;
+    std::size_t n{source.get_size()};
+    assert(n < (std::size_t{1} << 32));
+
+    if (n == 0) {
+        return result;
+    }
+
+    result.allocate(n, bucket_count_for(n), table_size_for(n));
+    std::vector<const K*> keys;
+    std::vector<const V*> values;
+    std::vector<std::uint64_t> hashes;
+    keys.reserve(n);
+    values.reserve(n);
+    hashes.reserve(n);
+    source.for_each([&](const K& key, const V& value) {
+        keys.push_back(&key);
+        values.push_back(&value);
+    });
+
+    for (unsigned attempt{0}; ; ++attempt) {
+        if (attempt == max_seeds) {
+            throw std::runtime_error{"FrozenHashMap: distinct keys share a hash"};
+        }
+
+        result.seed = mix64(attempt + 0x9E3779B97F4A7C15ULL);
+        hashes.clear();
+
+        for (const K* key : keys) {
+            hashes.push_back(result.bucket_hash(*key));
+        }
+
+        if (result.place(hashes)) {
+            break;
+        }
+    }
+
+    for (std::size_t i{0}; i < n; ++i) {
+        std::uint64_t hb{hashes[i]};
+        std::size_t slot{result.slot_of(slot_hash(hb), result.pilots[result.bucket_of(hb)])};
+
+        if (slot >= n) {
+            slot = result.remap[slot - n];
+        }
+
+        result.entries[slot].key = *keys[i];
+        result.entries[slot].value = *values[i];
+    }
+
+    return result;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+std::size_t FrozenHashMap<K, V, Hash, Eq>::get_size() const {
+    return size;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+bool FrozenHashMap<K, V, Hash, Eq>::empty() const {
+    return size == 0;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+bool FrozenHashMap<K, V, Hash, Eq>::contains(const K& key) const {
+    return find_entry(key) != nullptr;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+bool FrozenHashMap<K, V, Hash, Eq>::get(const K& key, V& out) const {
+    const Entry* entry{find_entry(key)};
+
+    if (entry == nullptr) {
+        return false;
+    }
+
+    out = entry->value;
+    return true;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+const V* FrozenHashMap<K, V, Hash, Eq>::find(const K& key) const {
+    const Entry* entry{find_entry(key)};
+    return entry == nullptr ? nullptr : &entry->value;
+}
+
+// Pilots and remap slots per key, excluding the entries themselves
+template <typename K, typename V, typename Hash, typename Eq>
+double FrozenHashMap<K, V, Hash, Eq>::bits_per_key() const {
+    if (size == 0) {
+        return 0.0;
+    }
+
+    return 8.0 * (bucket_count * sizeof(std::uint16_t) + (table_size - size) * sizeof(std::uint32_t)) / size;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+std::size_t FrozenHashMap<K, V, Hash, Eq>::image_bytes() const {
+    return sizeof(ImageHeader) + bucket_count * sizeof(std::uint16_t) + (table_size - size) * sizeof(std::uint32_t) + size * sizeof(Entry);
+}
+
+// Writes the header, pilots, remap table and entries back to back in native
+// byte order. Only maps whose keys and values are trivially copyable can be saved.
+template <typename K, typename V, typename Hash, typename Eq>
+bool FrozenHashMap<K, V, Hash, Eq>::save(const std::string& path) const {
+    static_assert(std::is_trivially_copyable_v<K> && std::is_trivially_copyable_v<V>, "save needs trivially copyable keys and values");
+    std::ofstream file{path, std::ios::binary | std::ios::trunc};
+    ImageHeader header{image_magic, sizeof(K), sizeof(V), size, bucket_count, dense_buckets, table_size, seed};
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    if (size > 0) {
+        file.write(reinterpret_cast<const char*>(pilots), bucket_count * sizeof(std::uint16_t));
+        file.write(reinterpret_cast<const char*>(remap), (table_size - size) * sizeof(std::uint32_t));
+        file.write(reinterpret_cast<const char*>(entries), size * sizeof(Entry));
+    }
+
+    return static_cast<bool>(file);
+}
+
+// Replaces the contents with a saved image. Returns false, leaving the map
+// unchanged, if the file is missing, truncated, longer than its header says,
+// was saved for other types, or its tables do not lead every stored key back
+// to its own entry. That last check costs one lookup per key.
+template <typename K, typename V, typename Hash, typename Eq>
+bool FrozenHashMap<K, V, Hash, Eq>::load(const std::string& path) {
+    static_assert(std::is_trivially_copyable_v<K> && std::is_trivially_copyable_v<V>, "load needs trivially copyable keys and values");
+    std::ifstream file{path, std::ios::binary | std::ios::ate};
+
+    if (!file) {
+        return false;
+    }
+
+    std::streamoff file_bytes{file.tellg()};
+    ImageHeader header{};
+    file.seekg(0);
+
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.magic != image_magic
+        || header.key_bytes != sizeof(K) || header.value_bytes != sizeof(V) || header.size >= (std::uint64_t{1} << 32)) {
+        return false;
+    }
+
+    // The layout is a function of the key count, so anything else is corrupt
+    std::size_t n{static_cast<std::size_t>(header.size)};
+    std::size_t buckets{n == 0 ? 0 : bucket_count_for(n)};
+    std::size_t slots{n == 0 ? 0 : table_size_for(n)};
+    std::size_t dense{buckets * 3 / 10 == 0 ? 1 : buckets * 3 / 10};
+
+    if (header.bucket_count != buckets || header.table_size != slots || header.dense_buckets != (n == 0 ? 0 : dense)
+        || static_cast<std::uint64_t>(file_bytes) != sizeof(ImageHeader) + buckets * sizeof(std::uint16_t)
+                                                     + (slots - n) * sizeof(std::uint32_t) + n * sizeof(Entry)) {
+        return false;
+    }
+
+    FrozenHashMap loaded;
+
+    if (n > 0) {
+        loaded.allocate(n, buckets, slots);
+        loaded.seed = header.seed;
+        file.read(reinterpret_cast<char*>(loaded.pilots), loaded.bucket_count * sizeof(std::uint16_t));
+        file.read(reinterpret_cast<char*>(loaded.remap), (loaded.table_size - loaded.size) * sizeof(std::uint32_t));
+        file.read(reinterpret_cast<char*>(loaded.entries), loaded.size * sizeof(Entry));
+
+        if (!file) {
+            return false;
+        }
+
+        for (std::size_t i{0}; i < loaded.table_size - loaded.size; ++i) {
+            if (loaded.remap[i] >= loaded.size) {
+                return false;
+            }
+        }
+
+        for (std::size_t i{0}; i < loaded.size; ++i) {
+            if (loaded.find_entry(loaded.entries[i].key) != &loaded.entries[i]) {
+                return false;
+            }
+        }
+    }
+
+    *this = std::move(loaded);
+    return true;
+}
+
+// Five keys per bucket average 3.2 bits of pilot per key; smaller buckets
+// build faster but cost more bits, larger ones the opposite
+template <typename K, typename V, typename Hash, typename Eq>
+std::size_t FrozenHashMap<K, V, Hash, Eq>::bucket_count_for(std::size_t n) {
+    std::size_t buckets{(n + 4) / 5};
+    return buckets < 2 ? 2 : buckets;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+std::size_t FrozenHashMap<K, V, Hash, Eq>::table_size_for(std::size_t n) {
+    return n + n / 99 + 1;
+}
+
+// Multiply-shift range reduction; cheaper than a modulo
+template <typename K, typename V, typename Hash, typename Eq>
+std::uint32_t FrozenHashMap<K, V, Hash, Eq>::fastrange(std::uint32_t x, std::size_t n) {
+    return static_cast<std::uint32_t>((static_cast<std::uint64_t>(x) * n) >> 32);
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+std::uint64_t FrozenHashMap<K, V, Hash, Eq>::bucket_hash(const K& key) const {
+    return mix64(hasher(key) ^ seed);
+}
+
+// The high half of the hash picks dense or sparse buckets and the low half the bucket within them
+template <typename K, typename V, typename Hash, typename Eq>
+std::size_t FrozenHashMap<K, V, Hash, Eq>::bucket_of(std::uint64_t hb) const {
+    std::uint32_t low{static_cast<std::uint32_t>(hb)};
+
+    if (static_cast<std::uint32_t>(hb >> 32) < dense_threshold) {
+        return fastrange(low, dense_buckets);
+    }
+
+    return dense_buckets + fastrange(low, bucket_count - dense_buckets);
+}
+
+// A multiplicative rehash decorrelates the slot from the bucket bits
+template <typename K, typename V, typename Hash, typename Eq>
+std::uint32_t FrozenHashMap<K, V, Hash, Eq>::slot_hash(std::uint64_t hb) {
+    return static_cast<std::uint32_t>((hb * 0x9E3779B97F4A7C15ULL) >> 32);
+}
+
+// The multiply after the XOR matters: without it, each pilot only shifts the
+// bucket's whole slot pattern, which for some table sizes can miss the last
+// few free slots whatever the pilot.
+template <typename K, typename V, typename Hash, typename Eq>
+std::size_t FrozenHashMap<K, V, Hash, Eq>::slot_of(std::uint32_t hs, std::uint16_t pilot) const {
+    return fastrange((hs ^ static_cast<std::uint32_t>(mix64(pilot))) * 0x9E3779B1u, table_size);
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+const typename FrozenHashMap<K, V, Hash, Eq>::Entry* FrozenHashMap<K, V, Hash, Eq>::find_entry(const K& key) const {
+    if (size == 0) {
+        return nullptr;
+    }
+
+    std::uint64_t hb{bucket_hash(key)};
+    std::size_t slot{slot_of(slot_hash(hb), pilots[bucket_of(hb)])};
+
+    if (slot >= size) {
+        slot = remap[slot - size];
+    }
+
+    return equal(entries[slot].key, key) ? &entries[slot] : nullptr;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+void FrozenHashMap<K, V, Hash, Eq>::allocate(std::size_t new_size, std::size_t new_bucket_count, std::size_t new_table_size) {
+    size = new_size;
+    bucket_count = new_bucket_count;
+    dense_buckets = bucket_count * 3 / 10 == 0 ? 1 : bucket_count * 3 / 10;
+    table_size = new_table_size;
+    pilots = new std::uint16_t[bucket_count]{};
+    remap = new std::uint32_t[table_size - size]{};
+    entries = new Entry[size];
+
+    // Zeroes the padding between key and value too, so saved images are
+    // reproducible and carry no stale heap bytes
+    if constexpr (std::is_trivially_copyable_v<Entry>) {
+        std::memset(static_cast<void*>(entries), 0, size * sizeof(Entry));
+    }
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+void FrozenHashMap<K, V, Hash, Eq>::release() {
+    delete[] pilots;
+    delete[] remap;
+    delete[] entries;
+    pilots = nullptr;
+    remap = nullptr;
+    entries = nullptr;
+    size = 0;
+    bucket_count = 0;
+    dense_buckets = 0;
+    table_size = 0;
+    seed = 0;
+}
+
+// Assumes this map is empty
+template <typename K, typename V, typename Hash, typename Eq>
+void FrozenHashMap<K, V, Hash, Eq>::copy_from(const FrozenHashMap& orig) {
+    hasher = orig.hasher;
+    equal = orig.equal;
+
+    if (orig.size == 0) {
+        return;
+    }
+
+    allocate(orig.size, orig.bucket_count, orig.table_size);
+    dense_buckets = orig.dense_buckets;
+    seed = orig.seed;
+    std::copy(orig.pilots, orig.pilots + bucket_count, pilots);
+    std::copy(orig.remap, orig.remap + (table_size - size), remap);
+    std::copy(orig.entries, orig.entries + size, entries);
+}
+
+// Searches a pilot for each bucket, largest buckets first while the table is
+// still empty, then fills remap. Returns false if some bucket needs more than
+// 16 bits of pilot, in which case the caller retries with another seed.
+template <typename K, typename V, typename Hash, typename Eq>
+bool FrozenHashMap<K, V, Hash, Eq>::place(const std::vector<std::uint64_t>& hashes) {
+    // Group the hashes by bucket, counting-sort style
+    std::vector<std::size_t> start(bucket_count + 1, 0);
+    std::size_t largest{0};
+
+    for (std::uint64_t hb : hashes) {
+        ++start[bucket_of(hb) + 1];
+    }
+
+    for (std::size_t b{0}; b < bucket_count; ++b) {
+        largest = start[b + 1] > largest ? start[b + 1] : largest;
+        start[b + 1] += start[b];
+    }
+
+    std::vector<std::uint32_t> grouped(hashes.size());
+    std::vector<std::size_t> fill(start.begin(), start.end() - 1);
+
+    for (std::uint64_t hb : hashes) {
+        grouped[fill[bucket_of(hb)]++] = slot_hash(hb);
+    }
+
+    // Order the buckets by decreasing size
+    std::vector<std::size_t> by_size_start(largest + 2, 0);
+    std::vector<std::size_t> order(bucket_count);
+
+    for (std::size_t b{0}; b < bucket_count; ++b) {
+        ++by_size_start[largest - (start[b + 1] - start[b]) + 1];
+    }
+
+    for (std::size_t s{0}; s <= largest; ++s) {
+        by_size_start[s + 1] += by_size_start[s];
+    }
+
+    for (std::size_t b{0}; b < bucket_count; ++b) {
+        order[by_size_start[largest - (start[b + 1] - start[b])]++] = b;
+    }
+
+    // One bit per slot; most pilot trials fail on the first key, so this stays hot
+    std::vector<std::uint64_t> taken((table_size + 63) / 64, 0);
+    auto is_taken{[&taken](std::size_t slot) {
+        return (taken[slot / 64] >> (slot % 64)) & 1;
+    }};
+    std::vector<std::size_t> slots(largest);
+
+    for (std::size_t b : order) {
+        std::size_t count{start[b + 1] - start[b]};
+
+        if (count == 0) {
+            break;
+        }
+
+        std::uint32_t pilot{0};
+
+        for (; pilot <= UINT16_MAX; ++pilot) {
+            std::uint32_t ph{static_cast<std::uint32_t>(mix64(pilot))};
+            std::size_t k{0};
+
+            // slot_of with the pilot's hash hoisted out of the loop
+            for (; k < count; ++k) {
+                std::size_t slot{fastrange((grouped[start[b] + k] ^ ph) * 0x9E3779B1u, table_size)};
+
+                if (is_taken(slot) || std::find(slots.begin(), slots.begin() + k, slot) != slots.begin() + k) {
+                    break;
+                }
+
+                slots[k] = slot;
+            }
+
+            if (k == count) {
+                break;
+            }
+        }
+
+        if (pilot > UINT16_MAX) {
+            std::fill(pilots, pilots + bucket_count, 0);
+            return false;
+        }
+
+        pilots[b] = static_cast<std::uint16_t>(pilot);
+
+        for (std::size_t k{0}; k < count; ++k) {
+            taken[slots[k] / 64] |= std::uint64_t{1} << (slots[k] % 64);
+        }
+    }
+
+    // Each taken slot at or past size takes the next free slot below size
+    std::size_t hole{0};
+
+    for (std::size_t slot{size}; slot < table_size; ++slot) {
+        if (is_taken(slot)) {
+            while (is_taken(hole)) {
+                ++hole;
+            }
+
+            remap[slot - size] = static_cast<std::uint32_t>(hole++);
+        }
+    }
+
+    return true;
+}
+
+#endif
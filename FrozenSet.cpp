@@ -0,0 +1,174 @@
+#include "FrozenSet.h"
+#include "HashMap.h"
+
+#include <algorithm>
+#include <cassert>
+#include <new>
+#include <utility>
+#include <vector>
+
+static constexpr std::size_t line_keys{64 / sizeof(double)}; // Keys per cache line
+
+FrozenSet::FrozenSet(): size{0}, keys{allocate_keys(0)}, ranks{new std::size_t[1]{}} {
+
+}
+
+FrozenSet::FrozenSet(std::size_t new_size): size{new_size}, keys{allocate_keys(new_size)}, ranks{new std::size_t[new_size + 1]{}} {
+
+}
+
+FrozenSet::FrozenSet(const FrozenSet& orig): size{orig.size}, keys{allocate_keys(orig.size)}, ranks{new std::size_t[orig.size + 1]} {
+    std::copy(orig.keys, orig.keys + size + 1, keys);
+    std::copy(orig.ranks, orig.ranks + size + 1, ranks);
+}
+
+// Leaves orig as an empty set so it stays usable
+FrozenSet::FrozenSet(FrozenSet&& orig) noexcept: size{orig.size}, keys{orig.keys}, ranks{orig.ranks} {
+    orig.size = 0;
+    orig.keys = allocate_keys(0);
+    orig.ranks = new std::size_t[1]{};
+}
+
+FrozenSet& FrozenSet::operator=(const FrozenSet& rhs) {
+    if (this == &rhs) {
+        return *this;
+    }
+
+    FrozenSet copy{rhs};
+    *this = std::move(copy);
+
+    return *this;
+}
+
+FrozenSet& FrozenSet::operator=(FrozenSet&& rhs) noexcept {
+    if (this == &rhs) {
+        return *this;
+    }
+
+    ::operator delete(keys, std::align_val_t{64});
+    delete[] ranks;
+    size = rhs.size;
+    keys = rhs.keys;
+    ranks = rhs.ranks;
+    rhs.size = 0;
+    rhs.keys = allocate_keys(0);
+    rhs.ranks = new std::size_t[1]{};
+
+    return *this;
+}
+
+FrozenSet::~FrozenSet() {
+    ::operator delete(keys, std::align_val_t{64});
+    delete[] ranks;
+    keys = nullptr;
+    ranks = nullptr;
+}
+
+FrozenSet FrozenSet::build(const BinarySearchTree& source) {
+    std::vector<double> sorted(source.get_size());
+    double* out{sorted.data()};
+    source.inorder_copy(source.root, out);
+    FrozenSet result{sorted.size()};
+    result.fill(sorted.data(), 0, 1);
+
+    return result;
+}
+
+std::size_t FrozenSet::get_size() const {
+    return size;
+}
+
+bool FrozenSet::empty() const {
+    return size == 0;
+}
+
+bool FrozenSet::contains(double value) const {
+    std::size_t k{search(value)};
+
+    return k != 0 && keys[k] == value;
+}
+
+// Smallest key >= value; false when every key is smaller
+bool FrozenSet::lower_bound(double value, double& out) const {
+    std::size_t k{search(value)};
+
+    if (k == 0) {
+        return false;
+    }
+
+    out = keys[k];
+    return true;
+}
+
+// Number of keys < value
+std::size_t FrozenSet::rank(double value) const {
+    std::size_t k{search(value)};
+
+    return k == 0 ? size : ranks[k];
+}
+
+double FrozenSet::min() const {
+    assert(!empty());
+    std::size_t k{1};
+
+    while (2 * k <= size) {
+        k = 2 * k;
+    }
+
+    return keys[k];
+}
+
+double FrozenSet::max() const {
+    assert(!empty());
+    std::size_t k{1};
+
+    while (2 * k + 1 <= size) {
+        k = 2 * k + 1;
+    }
+
+    return keys[k];
+}
+
+// Eytzinger index of the first key >= value, or 0 if there is none. The descent
+// records each comparison as the next bit of k; the last time it went left is
+// the answer, found by stripping the trailing right turns (ones) and that left turn.
+std::size_t FrozenSet::search(double value) const {
+    std::size_t k{1};
+
+    while (k <= size) {
+        prefetch_read(keys + k * line_keys);
+        k = 2 * k + (keys[k] < value);
+    }
+
+#if defined(__GNUC__) || defined(__clang__)
+    return k >> __builtin_ffsll(static_cast<long long>(~k));
+#else
+    while ((k & 1) != 0) {
+        k >>= 1;
+    }
+
+    return k >> 1;
+#endif
+}
+
+// Writes sorted[i..] into the subtree rooted at k in order; returns the next unused i
+std::size_t FrozenSet::fill(const double* sorted, std::size_t i, std::size_t k) {
+    if (k > size) {
+        return i;
+    }
+
+    i = fill(sorted, i, 2 * k);
+    keys[k] = sorted[i];
+    ranks[k] = i;
+    i = fill(sorted, i + 1, 2 * k + 1);
+
+    return i;
+}
+
+// Aligned so that the eight great-grandchildren of a node share one cache line
+double* FrozenSet::allocate_keys(std::size_t n) {
+    double* p{static_cast<double*>(::operator new((n + 1) * sizeof(double), std::align_val_t{64}))};
+    p[0] = 0.0;
+
+    return p;
+}
@@ -0,0 +1,41 @@
+#ifndef FROZENSET_H
+#define FROZENSET_H
+
+#include "BinarySearchTree.h"
+
+#include <cstddef>
+
+// Read-only ordered set of doubles frozen from a BinarySearchTree. The sorted
+// keys are stored in Eytzinger (breadth-first) order, so node k's children sit
+// at 2k and 2k + 1 and the top levels of every search share the same few
+// cache lines. A search descends with a branchless compare per level and
+// prefetches the cache line holding the node's eight great-grandchildren, so
+// the memory latency of three levels overlaps.
+class FrozenSet {
+    public:
+        FrozenSet();
+        FrozenSet(const FrozenSet& orig);
+        FrozenSet(FrozenSet&& orig) noexcept;
+        FrozenSet& operator=(const FrozenSet& rhs);
+        FrozenSet& operator=(FrozenSet&& rhs) noexcept;
+        ~FrozenSet();
+        static FrozenSet build(const BinarySearchTree& source);
+        std::size_t get_size() const;
+        bool empty() const;
+        bool contains(double value) const;
+        bool lower_bound(double value, double& out) const;
+        std::size_t rank(double value) const;
+        double min() const;
+        double max() const;
+
+    private:
+        std::size_t size;
+        double* keys;       // keys[1..size] in Eytzinger order; keys[0] is unused
+        std::size_t* ranks; // ranks[k] is the sorted position of keys[k]
+        explicit FrozenSet(std::size_t new_size);
+        std::size_t search(double value) const;
+        std::size_t fill(const double* sorted, std::size_t i, std::size_t k);
+        static double* allocate_keys(std::size_t n);
+};
+
+#endif
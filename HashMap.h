@@ -1,33 +1,1290 @@
 #ifndef HASHMAP_H
 #define HASHMAP_H
 
-class Node;
+#include <cassert>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <new>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
+#ifdef HASHMAP_STATS
+#include <atomic>
+#include <chrono>
+#include <string>
+#endif
+
+// Hint that p will be read soon; a no-op where the builtin is unavailable
+inline void prefetch_read(const void* p) {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(p, 0, 3);
+#else
+    (void)p;
+#endif
+}
+
+// murmur3 fmix64 finalizer
+inline std::uint64_t mix64(std::uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+
+    return x;
+}
+
+// Reads 8 bytes at a time and mixes each word into the running hash
+inline std::uint64_t hash_bytes(const char* p, std::size_t n) {
+    std::uint64_t h{0x9e3779b97f4a7c15ULL ^ n};
+
+    while (n >= 8) {
+        std::uint64_t word;
+        std::memcpy(&word, p, 8);
+        h = mix64(h ^ word);
+        p += 8;
+        n -= 8;
+    }
+
+    std::uint64_t tail{0};
+
+    // An empty std::string_view may carry a null data pointer
+    if (n > 0) {
+        std::memcpy(&tail, p, n);
+    }
+
+    return mix64(h ^ tail);
+}
+
+// Default hasher. Integers are mixed so sequential and strided keys spread over
+// the low bits used by the power-of-two bucket mask. Anything convertible to
+// std::string_view hashes by content, so std::string, std::string_view and
+// string literals agree and can be used for heterogeneous lookup.
+struct MixHash {
+    using is_transparent = void;
+
+    template <typename T>
+    std::uint64_t operator()(const T& key) const {
+        if constexpr (std::is_integral_v<T> || std::is_enum_v<T>) {
+            return mix64(static_cast<std::uint64_t>(key));
+        } else if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+            std::string_view s{key};
+            return hash_bytes(s.data(), s.size());
+        } else {
+            return mix64(static_cast<std::uint64_t>(std::hash<T>{}(key)));
+        }
+    }
+};
+
+template <typename K, typename V, typename Hash, typename Eq>
+class HashMap;
+
+template <typename K, typename V, typename Hash, typename Eq>
+class ConcurrentHashMap;
+
+#ifdef HASHMAP_STATS
+// Telemetry for one HashMap, compiled in only when HASHMAP_STATS is defined for
+// the whole program, since it changes HashMap's layout. Counters accumulate from
+// construction or reset_stats(); occupancy and the size fields are a snapshot
+// taken by get_stats(). The live counters are relaxed atomics, so const lookups
+// from several threads at once (as under ConcurrentHashMap's shared lock) stay
+// race free; get_stats() reads each one separately, so a snapshot taken during
+// concurrent lookups may be off by the operations still in flight.
+struct HashMapStats {
+    static constexpr std::size_t histogram_size{17}; // The last slot counts everything longer
+
+    std::uint64_t operations{0};                   // Lookups, inserts and removes
+    std::uint64_t probe_lengths[histogram_size]{}; // Operations by number of nodes compared
+    std::uint64_t collisions{0};                   // Node comparisons that did not match
+    std::uint64_t occupancy[histogram_size]{};     // Buckets by number of nodes held
+    std::uint64_t rehashes{0};                     // Incremental rehashes started and one-shot resizes
+    std::uint64_t rehash_ns{0};                    // Time spent moving nodes between tables
+    std::uint64_t bytes_allocated{0};              // Bucket arrays and nodes, cumulative
+    std::uint64_t bytes_in_use{0};
+    std::size_t size{0};
+    std::size_t capacity{0};
+    double load_factor{0.0};
+
+    double collisions_per_operation() const {
+        return operations == 0 ? 0.0 : 1.0 * collisions / operations;
+    }
+
+    std::string to_json() const {
+        auto array{[](const std::uint64_t (&counts)[histogram_size]) {
+            std::string result{"["};
+
+            for (std::size_t i{0}; i < histogram_size; ++i) {
+                result += (i == 0 ? "" : ",") + std::to_string(counts[i]);
+            }
+
+            return result + "]";
+        }};
+
+        return "{\"size\":" + std::to_string(size) + ",\"capacity\":" + std::to_string(capacity)
+            + ",\"load_factor\":" + std::to_string(load_factor) + ",\"operations\":" + std::to_string(operations)
+            + ",\"collisions\":" + std::to_string(collisions)
+            + ",\"collisions_per_operation\":" + std::to_string(collisions_per_operation())
+            + ",\"probe_lengths\":" + array(probe_lengths) + ",\"occupancy\":" + array(occupancy)
+            + ",\"rehashes\":" + std::to_string(rehashes) + ",\"rehash_ns\":" + std::to_string(rehash_ns)
+            + ",\"bytes_allocated\":" + std::to_string(bytes_allocated) + ",\"bytes_in_use\":" + std::to_string(bytes_in_use) + "}";
+    }
+};
+#endif
+
+template <typename K, typename V>
+class HashNode {
+    private:
+        template <typename KK, typename... Args>
+        HashNode(HashNode* new_next, KK&& k, Args&&... args): key(std::forward<KK>(k)), value(std::forward<Args>(args)...), next{new_next} {
+
+        }
+
+        K key;
+        V value;
+        HashNode* next;
+
+    template <typename, typename, typename, typename>
+    friend class HashMap;
+};
+
+template <typename K = int, typename V = int, typename Hash = MixHash, typename Eq = std::equal_to<>>
 class HashMap {
+    private:
+        // Names T through Q, so a functor without is_transparent only fails
+        // substitution of the overload being considered, not the whole class
+        template <typename T, typename Q>
+        struct dependent {
+            using type = T;
+        };
+
+        // Heterogeneous overloads exist only when both functors opt in. Arithmetic
+        // keys convert to K instead, so hashing never depends on the argument type.
+        template <typename Q>
+        using enable_transparent = std::enable_if_t<!std::is_same_v<std::decay_t<Q>, K> && !std::is_arithmetic_v<std::decay_t<Q>>,
+                                                    std::void_t<typename dependent<Hash, Q>::type::is_transparent,
+                                                                typename dependent<Eq, Q>::type::is_transparent>>;
+
     public:
+        template <bool Const>
+        class Iterator;
+        using iterator = Iterator<false>;
+        using const_iterator = Iterator<true>;
+
         HashMap();
+        HashMap(const K* keys, const V* values, std::size_t n, unsigned hash_threads = 1);
         HashMap(const HashMap& orig);
         HashMap(HashMap&& orig) noexcept;
         HashMap& operator=(const HashMap& rhs);
         HashMap& operator=(HashMap&& rhs) noexcept;
         ~HashMap();
-        int get_size() const;
-        int get_capacity() const;
+        std::size_t get_size() const;
+        std::size_t get_capacity() const;
         double load_factor() const;
         bool empty() const;
+        bool is_rehashing() const;
         void clear();
-        void insert(int key, int value);
-        bool contains(int key) const;
-        bool get(int key, int& out) const;
-        void remove(int key);
+        void reserve(std::size_t n);
+        void shrink_to_fit();
+        void insert(const K& key, const V& value);
+        template <typename... Args>
+        bool try_emplace(const K& key, Args&&... args);
+        template <typename... Args>
+        bool try_emplace(K&& key, Args&&... args);
+        template <typename M>
+        bool insert_or_assign(const K& key, M&& value);
+        template <typename M>
+        bool insert_or_assign(K&& key, M&& value);
+        bool contains(const K& key) const;
+        template <typename Q, typename = enable_transparent<Q>>
+        bool contains(const Q& key) const;
+        bool get(const K& key, V& out) const;
+        template <typename Q, typename = enable_transparent<Q>>
+        bool get(const Q& key, V& out) const;
+        V* find(const K& key);
+        const V* find(const K& key) const;
+        template <typename Q, typename = enable_transparent<Q>>
+        V* find(const Q& key);
+        template <typename Q, typename = enable_transparent<Q>>
+        const V* find(const Q& key) const;
+        void remove(const K& key);
+        template <typename Q, typename = enable_transparent<Q>>
+        void remove(const Q& key);
+        std::size_t get_many(const K* keys, std::size_t n, V* out, bool* found) const;
+        void insert_many(const K* keys, const V* values, std::size_t n);
+        iterator begin();
+        iterator end();
+        const_iterator begin() const;
+        const_iterator end() const;
+        template <typename F>
+        void for_each(F f);
+        template <typename F>
+        void for_each(F f) const;
+#ifdef HASHMAP_STATS
+        HashMapStats get_stats() const;
+        void reset_stats();
+#endif
 
     private:
-        int size;
-        int capacity; // Number of buckets
+        using Node = HashNode<K, V>;
+
+        static constexpr std::size_t initial_capacity{16}; // Must be a power of two
+        static constexpr std::size_t rehash_buckets_per_op{4}; // Old buckets migrated by each insert or remove
+        static constexpr std::size_t batch_size{16}; // Keys whose bucket loads overlap in get_many and insert_many
+        static constexpr std::size_t bulk_slice{1 << 16}; // Keys hashed per pass of the bulk constructor
+
+        std::size_t size;
+        std::size_t capacity; // Number of buckets, always a power of two
         Node** buckets;
-        void insert_no_rehash(int key, int value);
-        int hash(int key) const;
-        void rehash();
+        // While rehashing, old buckets at index >= rehash_pos have not moved to buckets yet
+        std::size_t old_capacity;
+        Node** old_buckets;
+        std::size_t rehash_pos;
+        Hash hasher;
+        Eq equal;
+#ifdef HASHMAP_STATS
+        // The counters of HashMapStats, bumped by const lookups
+        struct StatsCounters {
+            std::atomic<std::uint64_t> operations{0};
+            std::atomic<std::uint64_t> probe_lengths[HashMapStats::histogram_size]{};
+            std::atomic<std::uint64_t> collisions{0};
+            std::atomic<std::uint64_t> rehashes{0};
+            std::atomic<std::uint64_t> rehash_ns{0};
+            std::atomic<std::uint64_t> bytes_allocated{0};
+        };
+
+        mutable StatsCounters stats;
+#endif
+        // The record_* hooks compile to nothing unless HASHMAP_STATS is defined
+        void record_probe(std::size_t compared, bool matched) const;
+        void record_allocation(std::size_t bytes);
+        void record_rehash_start();
+        void record_rehash_time(std::uint64_t started_ns);
+        static std::uint64_t stats_clock_ns();
+        static Node** allocate_buckets(std::size_t n);
+        static std::size_t capacity_for(std::size_t n);
+        void resize_buckets(std::size_t new_capacity);
+        template <typename F>
+        void for_each_node(F f) const;
+        std::size_t bucket_span() const;
+        Node* bucket_head(std::size_t i) const;
+        Node*& bucket_at(std::uint64_t h) const;
+        template <typename Q>
+        Node* find_node(const Q& key) const;
+        template <typename Q>
+        Node* find_node(const Q& key, std::uint64_t h) const;
+        template <typename Q>
+        void remove_node(const Q& key, std::uint64_t h);
+        template <typename KK, typename... Args>
+        bool emplace_no_rehash(std::uint64_t h, KK&& key, Args&&... args);
+        template <typename KK, typename M>
+        bool assign_no_rehash(std::uint64_t h, KK&& key, M&& value);
+        void bulk_load(const K* keys, const V* values, std::size_t n, unsigned hash_threads);
+        // Public operations with the key's hash already computed, for
+        // ConcurrentHashMap, which needs the same hash to pick the shard
+        template <typename... Args>
+        bool try_emplace_hashed(std::uint64_t h, const K& key, Args&&... args);
+        template <typename M>
+        bool insert_or_assign_hashed(std::uint64_t h, const K& key, M&& value);
+        void remove_hashed(std::uint64_t h, const K& key);
+        const V* find_hashed(std::uint64_t h, const K& key) const;
+
+    template <typename, typename, typename, typename>
+    friend class ConcurrentHashMap;
+        void grow_if_needed();
+        void rehash_step(std::size_t max_buckets);
+};
+
+// Forward iterator over every entry, dereferencing to a (key, value) pair of
+// references. Unmigrated old buckets are visited before the current table.
+// Any insert or remove invalidates it, since either may move nodes.
+template <typename K, typename V, typename Hash, typename Eq>
+template <bool Const>
+class HashMap<K, V, Hash, Eq>::Iterator {
+    public:
+        using MapPtr = std::conditional_t<Const, const HashMap*, HashMap*>;
+        using ValueRef = std::conditional_t<Const, const V&, V&>;
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::pair<const K, V>;
+        using difference_type = std::ptrdiff_t;
+        using reference = std::pair<const K&, ValueRef>;
+        using pointer = void;
+
+        Iterator(): map{nullptr}, bucket{0}, node{nullptr} {
+
+        }
+
+        // iterator converts to const_iterator
+        template <bool OtherConst, typename = std::enable_if_t<Const && !OtherConst>>
+        Iterator(const Iterator<OtherConst>& other): map{other.map}, bucket{other.bucket}, node{other.node} {
+
+        }
+
+        reference operator*() const {
+            return {node->key, node->value};
+        }
+
+        const K& key() const {
+            return node->key;
+        }
+
+        ValueRef value() const {
+            return node->value;
+        }
+
+        Iterator& operator++() {
+            node = node->next;
+
+            while (node == nullptr && ++bucket < map->bucket_span()) {
+                node = map->bucket_head(bucket);
+            }
+
+            return *this;
+        }
+
+        Iterator operator++(int) {
+            Iterator temp{*this};
+            ++*this;
+            return temp;
+        }
+
+        bool operator==(const Iterator& rhs) const {
+            return node == rhs.node;
+        }
+
+        bool operator!=(const Iterator& rhs) const {
+            return node != rhs.node;
+        }
+
+    private:
+        Iterator(MapPtr new_map, std::size_t new_bucket): map{new_map}, bucket{new_bucket}, node{nullptr} {
+            for (; bucket < map->bucket_span(); ++bucket) {
+                node = map->bucket_head(bucket);
+
+                if (node != nullptr) {
+                    break;
+                }
+            }
+        }
+
+        MapPtr map;
+        std::size_t bucket; // Position in the bucket_span() sequence
+        Node* node;
+
+    template <bool>
+    friend class Iterator;
+
+    friend class HashMap;
 };
 
+template <typename K, typename V, typename Hash, typename Eq>
+HashMap<K, V, Hash, Eq>::HashMap(): size{0}, capacity{initial_capacity}, buckets{allocate_buckets(initial_capacity)},
+                                     old_capacity{0}, old_buckets{nullptr}, rehash_pos{0}, hasher{}, equal{} {
+    record_allocation(capacity * sizeof(Node*));
+}
+
+// Builds the map from n key/value pairs in one pass at its final capacity. A
+// repeated key keeps its last value. If a key or value copy throws, the nodes
+// built so far are freed before the exception leaves.
+template <typename K, typename V, typename Hash, typename Eq>
+HashMap<K, V, Hash, Eq>::HashMap(const K* keys, const V* values, std::size_t n, unsigned hash_threads):
+    size{0}, capacity{capacity_for(n)}, buckets{allocate_buckets(capacity)}, old_capacity{0}, old_buckets{nullptr}, rehash_pos{0}, hasher{}, equal{} {
+    record_allocation(capacity * sizeof(Node*));
+
+    try {
+        bulk_load(keys, values, n, hash_threads);
+    } catch (...) {
+        clear();
+        std::free(buckets);
+        throw;
+    }
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+HashMap<K, V, Hash, Eq>::HashMap(const HashMap& orig): size{0}, capacity{orig.capacity}, buckets{allocate_buckets(capacity)},
+                                                       old_capacity{0}, old_buckets{nullptr}, rehash_pos{0}, hasher{orig.hasher}, equal{orig.equal} {
+    record_allocation(capacity * sizeof(Node*));
+    orig.for_each_node([this](const Node* curr) {
+        emplace_no_rehash(hasher(curr->key), curr->key, curr->value);
+    });
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+HashMap<K, V, Hash, Eq>::HashMap(HashMap&& orig) noexcept: size{orig.size}, capacity{orig.capacity}, buckets{orig.buckets},
+                                                           old_capacity{orig.old_capacity}, old_buckets{orig.old_buckets}, rehash_pos{orig.rehash_pos},
+                                                           hasher{orig.hasher}, equal{orig.equal} {
+    orig.size = 0;
+    orig.capacity = initial_capacity;
+    orig.buckets = allocate_buckets(initial_capacity);
+    orig.record_allocation(initial_capacity * sizeof(Node*));
+    orig.old_capacity = 0;
+    orig.old_buckets = nullptr;
+    orig.rehash_pos = 0;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+HashMap<K, V, Hash, Eq>& HashMap<K, V, Hash, Eq>::operator=(const HashMap& rhs) {
+    if (this == &rhs) {
+        return *this;
+    }
+
+    clear();
+    std::free(buckets);
+    size = 0;
+    capacity = rhs.capacity;
+    buckets = allocate_buckets(capacity);
+    record_allocation(capacity * sizeof(Node*));
+    hasher = rhs.hasher;
+    equal = rhs.equal;
+
+    rhs.for_each_node([this](const Node* curr) {
+        emplace_no_rehash(hasher(curr->key), curr->key, curr->value);
+    });
+
+    return *this;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+HashMap<K, V, Hash, Eq>& HashMap<K, V, Hash, Eq>::operator=(HashMap&& rhs) noexcept {
+    if (this == &rhs) {
+        return *this;
+    }
+
+    clear();
+    std::free(buckets);
+    size = rhs.size;
+    capacity = rhs.capacity;
+    buckets = rhs.buckets;
+    old_capacity = rhs.old_capacity;
+    old_buckets = rhs.old_buckets;
+    rehash_pos = rhs.rehash_pos;
+    hasher = rhs.hasher;
+    equal = rhs.equal;
+    rhs.size = 0;
+    rhs.capacity = initial_capacity;
+    rhs.buckets = allocate_buckets(initial_capacity);
+    rhs.record_allocation(initial_capacity * sizeof(Node*));
+    rhs.old_capacity = 0;
+    rhs.old_buckets = nullptr;
+    rhs.rehash_pos = 0;
+
+    return *this;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+HashMap<K, V, Hash, Eq>::~HashMap() {
+    clear();
+    std::free(buckets);
+    buckets = nullptr;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+std::size_t HashMap<K, V, Hash, Eq>::get_size() const {
+    return size;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+std::size_t HashMap<K, V, Hash, Eq>::get_capacity() const {
+    return capacity;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+double HashMap<K, V, Hash, Eq>::load_factor() const {
+    return 1.0 * size / capacity;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+bool HashMap<K, V, Hash, Eq>::empty() const {
+    return size == 0;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+bool HashMap<K, V, Hash, Eq>::is_rehashing() const {
+    return old_buckets != nullptr;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+void HashMap<K, V, Hash, Eq>::clear() {
+    for (std::size_t k{rehash_pos}; k < old_capacity; ++k) {
+        Node* curr{old_buckets[k]};
+
+        while (curr != nullptr) {
+            Node* temp{curr};
+            curr = curr->next;
+            delete temp;
+        }
+    }
+
+    std::free(old_buckets);
+    old_buckets = nullptr;
+    old_capacity = 0;
+    rehash_pos = 0;
+
+    for (std::size_t k{0}; k < capacity; ++k) {
+        Node* curr{buckets[k]};
+
+        while (curr != nullptr) {
+            Node* temp{curr};
+            curr = curr->next;
+            delete temp;
+        }
+
+        buckets[k] = nullptr;
+    }
+
+    size = 0;
+}
+
+// Grows the table once so that n entries fit without any further rehash
+template <typename K, typename V, typename Hash, typename Eq>
+void HashMap<K, V, Hash, Eq>::reserve(std::size_t n) {
+    std::size_t new_capacity{capacity_for(n)};
+
+    if (new_capacity > capacity) {
+        resize_buckets(new_capacity);
+    }
+}
+
+// Shrinks the table to the smallest capacity that holds the current entries
+template <typename K, typename V, typename Hash, typename Eq>
+void HashMap<K, V, Hash, Eq>::shrink_to_fit() {
+    std::size_t new_capacity{capacity_for(size)};
+
+    if (new_capacity < capacity) {
+        resize_buckets(new_capacity);
+    }
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+void HashMap<K, V, Hash, Eq>::insert(const K& key, const V& value) {
+    insert_or_assign(key, value);
+}
+
+// Constructs the value from args only when key is absent; returns whether it inserted
+template <typename K, typename V, typename Hash, typename Eq>
+template <typename... Args>
+bool HashMap<K, V, Hash, Eq>::try_emplace(const K& key, Args&&... args) {
+    return try_emplace_hashed(hasher(key), key, std::forward<Args>(args)...);
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+template <typename... Args>
+bool HashMap<K, V, Hash, Eq>::try_emplace(K&& key, Args&&... args) {
+    rehash_step(rehash_buckets_per_op);
+    bool inserted{emplace_no_rehash(hasher(key), std::move(key), std::forward<Args>(args)...)};
+    grow_if_needed();
+
+    return inserted;
+}
+
+// Assigns over an existing value instead of building a new node; returns whether it inserted
+template <typename K, typename V, typename Hash, typename Eq>
+template <typename M>
+bool HashMap<K, V, Hash, Eq>::insert_or_assign(const K& key, M&& value) {
+    return insert_or_assign_hashed(hasher(key), key, std::forward<M>(value));
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+template <typename M>
+bool HashMap<K, V, Hash, Eq>::insert_or_assign(K&& key, M&& value) {
+    rehash_step(rehash_buckets_per_op);
+    bool inserted{assign_no_rehash(hasher(key), std::move(key), std::forward<M>(value))};
+    grow_if_needed();
+
+    return inserted;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+bool HashMap<K, V, Hash, Eq>::contains(const K& key) const {
+    return find_node(key) != nullptr;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+template <typename Q, typename>
+bool HashMap<K, V, Hash, Eq>::contains(const Q& key) const {
+    return find_node(key) != nullptr;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+bool HashMap<K, V, Hash, Eq>::get(const K& key, V& out) const {
+    const Node* node{find_node(key)};
+
+    if (node == nullptr) {
+        return false;
+    }
+
+    out = node->value;
+    return true;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+template <typename Q, typename>
+bool HashMap<K, V, Hash, Eq>::get(const Q& key, V& out) const {
+    const Node* node{find_node(key)};
+
+    if (node == nullptr) {
+        return false;
+    }
+
+    out = node->value;
+    return true;
+}
+
+// Returns a pointer to the stored value, or nullptr; valid until the next insert or remove
+template <typename K, typename V, typename Hash, typename Eq>
+V* HashMap<K, V, Hash, Eq>::find(const K& key) {
+    Node* node{find_node(key)};
+    return node == nullptr ? nullptr : &node->value;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+const V* HashMap<K, V, Hash, Eq>::find(const K& key) const {
+    const Node* node{find_node(key)};
+    return node == nullptr ? nullptr : &node->value;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+template <typename Q, typename>
+V* HashMap<K, V, Hash, Eq>::find(const Q& key) {
+    Node* node{find_node(key)};
+    return node == nullptr ? nullptr : &node->value;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+template <typename Q, typename>
+const V* HashMap<K, V, Hash, Eq>::find(const Q& key) const {
+    const Node* node{find_node(key)};
+    return node == nullptr ? nullptr : &node->value;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+void HashMap<K, V, Hash, Eq>::remove(const K& key) {
+    remove_hashed(hasher(key), key);
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+template <typename Q, typename>
+void HashMap<K, V, Hash, Eq>::remove(const Q& key) {
+    rehash_step(rehash_buckets_per_op);
+    remove_node(key, hasher(key));
+}
+
+// Looks up n keys, writing found[i] and, on a hit, out[i]; returns the number of
+// hits. Keys are handled batch_size at a time: all hashes are computed and their
+// bucket slots prefetched, then the chain heads are prefetched, and only then are
+// the chains walked, so the cache misses of a batch overlap instead of queueing.
+template <typename K, typename V, typename Hash, typename Eq>
+std::size_t HashMap<K, V, Hash, Eq>::get_many(const K* keys, std::size_t n, V* out, bool* found) const {
+    std::uint64_t hashes[batch_size];
+    Node* heads[batch_size];
+    std::size_t hits{0};
+
+    for (std::size_t base{0}; base < n; base += batch_size) {
+        std::size_t count{n - base < batch_size ? n - base : batch_size};
+
+        for (std::size_t i{0}; i < count; ++i) {
+            hashes[i] = hasher(keys[base + i]);
+            prefetch_read(&bucket_at(hashes[i]));
+        }
+
+        for (std::size_t i{0}; i < count; ++i) {
+            heads[i] = bucket_at(hashes[i]);
+
+            if (heads[i] != nullptr) {
+                prefetch_read(heads[i]);
+            }
+        }
+
+        for (std::size_t i{0}; i < count; ++i) {
+            std::size_t compared{0};
+            found[base + i] = false;
+
+            for (const Node* curr{heads[i]}; curr != nullptr; curr = curr->next) {
+                ++compared;
+
+                if (equal(curr->key, keys[base + i])) {
+                    out[base + i] = curr->value;
+                    found[base + i] = true;
+                    ++hits;
+                    break;
+                }
+            }
+
+            record_probe(compared, found[base + i]);
+        }
+    }
+
+    return hits;
+}
+
+// Same as insert_or_assign on each pair in order, with the bucket loads of each
+// batch prefetched up front. Prefetches are only hints, so a rehash started
+// partway through a batch just costs the remaining keys their head start.
+template <typename K, typename V, typename Hash, typename Eq>
+void HashMap<K, V, Hash, Eq>::insert_many(const K* keys, const V* values, std::size_t n) {
+    std::uint64_t hashes[batch_size];
+
+    for (std::size_t base{0}; base < n; base += batch_size) {
+        std::size_t count{n - base < batch_size ? n - base : batch_size};
+        rehash_step(rehash_buckets_per_op * count);
+
+        for (std::size_t i{0}; i < count; ++i) {
+            hashes[i] = hasher(keys[base + i]);
+            prefetch_read(&bucket_at(hashes[i]));
+        }
+
+        for (std::size_t i{0}; i < count; ++i) {
+            const Node* head{bucket_at(hashes[i])};
+
+            if (head != nullptr) {
+                prefetch_read(head);
+            }
+        }
+
+        for (std::size_t i{0}; i < count; ++i) {
+            assign_no_rehash(hashes[i], keys[base + i], values[base + i]);
+            grow_if_needed();
+        }
+    }
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+typename HashMap<K, V, Hash, Eq>::iterator HashMap<K, V, Hash, Eq>::begin() {
+    return iterator{this, 0};
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+typename HashMap<K, V, Hash, Eq>::iterator HashMap<K, V, Hash, Eq>::end() {
+    return iterator{this, bucket_span()};
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+typename HashMap<K, V, Hash, Eq>::const_iterator HashMap<K, V, Hash, Eq>::begin() const {
+    return const_iterator{this, 0};
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+typename HashMap<K, V, Hash, Eq>::const_iterator HashMap<K, V, Hash, Eq>::end() const {
+    return const_iterator{this, bucket_span()};
+}
+
+// Calls f(key, value) on every entry; cheaper than iterators since it keeps no cursor state
+template <typename K, typename V, typename Hash, typename Eq>
+template <typename F>
+void HashMap<K, V, Hash, Eq>::for_each(F f) {
+    for_each_node([&f](Node* curr) {
+        f(static_cast<const K&>(curr->key), curr->value);
+    });
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+template <typename F>
+void HashMap<K, V, Hash, Eq>::for_each(F f) const {
+    for_each_node([&f](const Node* curr) {
+        f(curr->key, curr->value);
+    });
+}
+
+// calloc lets large bucket arrays come straight from zeroed pages instead of
+// being cleared element by element as new Node*[n]{} would
+template <typename K, typename V, typename Hash, typename Eq>
+HashNode<K, V>** HashMap<K, V, Hash, Eq>::allocate_buckets(std::size_t n) {
+    Node** result{static_cast<Node**>(std::calloc(n, sizeof(Node*)))};
+
+    if (result == nullptr) {
+        throw std::bad_alloc{};
+    }
+
+    return result;
+}
+
+// Smallest power-of-two capacity that keeps n entries at or under the 0.7 load factor
+template <typename K, typename V, typename Hash, typename Eq>
+std::size_t HashMap<K, V, Hash, Eq>::capacity_for(std::size_t n) {
+    std::size_t result{initial_capacity};
+
+    while (n * 10 > result * 7) {
+        result *= 2;
+    }
+
+    return result;
+}
+
+// Relinks every node into a table of new_capacity buckets in one pass. Only
+// reserve and shrink_to_fit use it, where the caller asks for the pause.
+template <typename K, typename V, typename Hash, typename Eq>
+void HashMap<K, V, Hash, Eq>::resize_buckets(std::size_t new_capacity) {
+    rehash_step(old_capacity);
+    std::uint64_t started{stats_clock_ns()};
+    Node** new_buckets{allocate_buckets(new_capacity)};
+    record_allocation(new_capacity * sizeof(Node*));
+    record_rehash_start();
+
+    for (std::size_t k{0}; k < capacity; ++k) {
+        Node* curr{buckets[k]};
+
+        while (curr != nullptr) {
+            Node* next{curr->next};
+            Node*& head{new_buckets[static_cast<std::size_t>(hasher(curr->key) & (new_capacity - 1))]};
+            curr->next = head;
+            head = curr;
+            curr = next;
+        }
+    }
+
+    std::free(buckets);
+    buckets = new_buckets;
+    capacity = new_capacity;
+    record_rehash_time(started);
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+template <typename F>
+void HashMap<K, V, Hash, Eq>::for_each_node(F f) const {
+    for (std::size_t k{rehash_pos}; k < old_capacity; ++k) {
+        for (Node* curr{old_buckets[k]}; curr != nullptr; curr = curr->next) {
+            f(curr);
+        }
+    }
+
+    for (std::size_t k{0}; k < capacity; ++k) {
+        for (Node* curr{buckets[k]}; curr != nullptr; curr = curr->next) {
+            f(curr);
+        }
+    }
+}
+
+// Buckets in iteration order: old buckets not yet migrated, then the current table
+template <typename K, typename V, typename Hash, typename Eq>
+std::size_t HashMap<K, V, Hash, Eq>::bucket_span() const {
+    return old_capacity - rehash_pos + capacity;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+HashNode<K, V>* HashMap<K, V, Hash, Eq>::bucket_head(std::size_t i) const {
+    std::size_t old_span{old_capacity - rehash_pos};
+
+    return i < old_span ? old_buckets[rehash_pos + i] : buckets[i - old_span];
+}
+
+// A hash maps to a single bucket: its old bucket if that has not been migrated
+// yet, otherwise its bucket in the current table. Both capacities are powers of
+// two, so the mask keeps the low bits of the mixed hash.
+template <typename K, typename V, typename Hash, typename Eq>
+HashNode<K, V>*& HashMap<K, V, Hash, Eq>::bucket_at(std::uint64_t h) const {
+    if (old_buckets != nullptr) {
+        std::size_t j{static_cast<std::size_t>(h & (old_capacity - 1))};
+
+        if (j >= rehash_pos) {
+            return old_buckets[j];
+        }
+    }
+
+    return buckets[static_cast<std::size_t>(h & (capacity - 1))];
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+template <typename Q>
+HashNode<K, V>* HashMap<K, V, Hash, Eq>::find_node(const Q& key) const {
+    return find_node(key, hasher(key));
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+template <typename Q>
+HashNode<K, V>* HashMap<K, V, Hash, Eq>::find_node(const Q& key, std::uint64_t h) const {
+    std::size_t compared{0};
+
+    for (Node* curr{bucket_at(h)}; curr != nullptr; curr = curr->next) {
+        ++compared;
+
+        if (equal(curr->key, key)) {
+            record_probe(compared, true);
+            return curr;
+        }
+    }
+
+    record_probe(compared, false);
+    return nullptr;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+template <typename Q>
+void HashMap<K, V, Hash, Eq>::remove_node(const Q& key, std::uint64_t h) {
+    Node*& head{bucket_at(h)};
+
+    if (head == nullptr) {
+        record_probe(0, false);
+        return;
+    }
+
+    // At this point, head cannot be nullptr
+    if (equal(head->key, key)) {
+        Node* temp{head};
+        head = head->next;
+        delete temp;
+        --size;
+        record_probe(1, true);
+        return;
+    }
+
+    std::size_t compared{1};
+
+    for (Node* curr{head}; curr->next != nullptr; curr = curr->next) {
+        ++compared;
+
+        if (equal(curr->next->key, key)) {
+            Node* temp{curr->next};
+            curr->next = curr->next->next;
+            delete temp;
+            --size;
+            record_probe(compared, true);
+            return;
+        }
+    }
+
+    record_probe(compared, false);
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+template <typename KK, typename... Args>
+bool HashMap<K, V, Hash, Eq>::emplace_no_rehash(std::uint64_t h, KK&& key, Args&&... args) {
+    Node*& head{bucket_at(h)};
+    std::size_t compared{0};
+
+    for (Node* curr{head}; curr != nullptr; curr = curr->next) {
+        ++compared;
+
+        if (equal(curr->key, key)) {
+            record_probe(compared, true);
+            return false;
+        }
+    }
+
+    record_probe(compared, false);
+    head = new Node{head, std::forward<KK>(key), std::forward<Args>(args)...};
+    record_allocation(sizeof(Node));
+    ++size;
+
+    return true;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+template <typename KK, typename M>
+bool HashMap<K, V, Hash, Eq>::assign_no_rehash(std::uint64_t h, KK&& key, M&& value) {
+    Node*& head{bucket_at(h)};
+    std::size_t compared{0};
+
+    for (Node* curr{head}; curr != nullptr; curr = curr->next) {
+        ++compared;
+
+        if (equal(curr->key, key)) {
+            curr->value = std::forward<M>(value);
+            record_probe(compared, true);
+            return false;
+        }
+    }
+
+    record_probe(compared, false);
+    head = new Node{head, std::forward<KK>(key), std::forward<M>(value)};
+    record_allocation(sizeof(Node));
+    ++size;
+
+    return true;
+}
+
+// h must be hasher(key)
+template <typename K, typename V, typename Hash, typename Eq>
+template <typename... Args>
+bool HashMap<K, V, Hash, Eq>::try_emplace_hashed(std::uint64_t h, const K& key, Args&&... args) {
+    rehash_step(rehash_buckets_per_op);
+    bool inserted{emplace_no_rehash(h, key, std::forward<Args>(args)...)};
+    grow_if_needed();
+
+    return inserted;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+template <typename M>
+bool HashMap<K, V, Hash, Eq>::insert_or_assign_hashed(std::uint64_t h, const K& key, M&& value) {
+    rehash_step(rehash_buckets_per_op);
+    bool inserted{assign_no_rehash(h, key, std::forward<M>(value))};
+    grow_if_needed();
+
+    return inserted;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+void HashMap<K, V, Hash, Eq>::remove_hashed(std::uint64_t h, const K& key) {
+    rehash_step(rehash_buckets_per_op);
+    remove_node(key, h);
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+const V* HashMap<K, V, Hash, Eq>::find_hashed(std::uint64_t h, const K& key) const {
+    const Node* node{find_node(key, h)};
+    return node == nullptr ? nullptr : &node->value;
+}
+
+// Hashes the keys a slice at a time into a bounded buffer, then links the
+// slice's nodes in sequentially. The hash_threads - 1 helpers are started once
+// and each hashes its share of every slice while this thread hashes the last.
+template <typename K, typename V, typename Hash, typename Eq>
+void HashMap<K, V, Hash, Eq>::bulk_load(const K* keys, const V* values, std::size_t n, unsigned hash_threads) {
+    const std::size_t slice{n < bulk_slice ? n : bulk_slice};
+    const unsigned helpers{hash_threads > 1 && slice >= 2 * std::size_t{hash_threads} ? hash_threads - 1 : 0};
+    std::vector<std::uint64_t> hashes(slice);
+    std::mutex lock;
+    std::condition_variable wake;
+    std::condition_variable done;
+    std::size_t round{0}; // Slices handed to the helpers so far
+    std::size_t base{0};
+    std::size_t count{0};
+    unsigned busy{0};     // Helpers still hashing the current slice
+    bool stop{false};
+    std::vector<std::thread> workers;
+
+    auto hash_share{[&](unsigned t, std::size_t first, std::size_t keys_in_slice) {
+        std::size_t chunk{keys_in_slice / (helpers + 1)};
+        std::size_t hi{t == helpers ? keys_in_slice : (t + 1) * chunk};
+
+        for (std::size_t i{t * chunk}; i < hi; ++i) {
+            hashes[i] = hasher(keys[first + i]);
+        }
+    }};
+    auto helper{[&](unsigned t) {
+        std::unique_lock<std::mutex> guard{lock};
+
+        for (std::size_t seen{0}; ; seen = round) {
+            wake.wait(guard, [&] { return stop || round != seen; });
+
+            if (stop) {
+                return;
+            }
+
+            std::size_t first{base};
+            std::size_t keys_in_slice{count};
+            guard.unlock();
+            hash_share(t, first, keys_in_slice);
+            guard.lock();
+
+            if (--busy == 0) {
+                done.notify_one();
+            }
+        }
+    }};
+    auto stop_workers{[&] {
+        {
+            std::lock_guard<std::mutex> guard{lock};
+            stop = true;
+        }
+
+        wake.notify_all();
+
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    }};
+
+    try {
+        workers.reserve(helpers);
+
+        for (unsigned t{0}; t < helpers; ++t) {
+            workers.emplace_back(helper, t);
+        }
+
+        for (std::size_t first{0}; first < n; first += slice) {
+            std::size_t keys_in_slice{n - first < slice ? n - first : slice};
+
+            if (helpers > 0) {
+                std::lock_guard<std::mutex> guard{lock};
+                base = first;
+                count = keys_in_slice;
+                busy = helpers;
+                ++round;
+            }
+
+            wake.notify_all();
+            hash_share(helpers, first, keys_in_slice);
+
+            if (helpers > 0) {
+                std::unique_lock<std::mutex> guard{lock};
+                done.wait(guard, [&] { return busy == 0; });
+            }
+
+            for (std::size_t i{0}; i < keys_in_slice; ++i) {
+                assign_no_rehash(hashes[i], keys[first + i], values[first + i]);
+            }
+        }
+    } catch (...) {
+        stop_workers();
+        throw;
+    }
+
+    stop_workers();
+}
+
+// Starts an incremental rehash into a table twice as large. A rehash still in
+// progress is finished first, which only happens if inserts outpace migration.
+template <typename K, typename V, typename Hash, typename Eq>
+void HashMap<K, V, Hash, Eq>::grow_if_needed() {
+    if (size * 10 <= capacity * 7) {
+        return;
+    }
+
+    if (old_buckets != nullptr) {
+        rehash_step(old_capacity);
+    }
+
+    old_capacity = capacity;
+    old_buckets = buckets;
+    rehash_pos = 0;
+    capacity *= 2;
+    buckets = allocate_buckets(capacity);
+    record_allocation(capacity * sizeof(Node*));
+    record_rehash_start();
+}
+
+// Moves up to max_buckets old buckets into the current table by relinking their
+// nodes, then frees the old table once every bucket has moved
+template <typename K, typename V, typename Hash, typename Eq>
+void HashMap<K, V, Hash, Eq>::rehash_step(std::size_t max_buckets) {
+    if (old_buckets == nullptr) {
+        return;
+    }
+
+    std::uint64_t started{stats_clock_ns()};
+    std::size_t end{old_capacity - rehash_pos <= max_buckets ? old_capacity : rehash_pos + max_buckets};
+
+    for (; rehash_pos < end; ++rehash_pos) {
+        Node* curr{old_buckets[rehash_pos]};
+
+        while (curr != nullptr) {
+            Node* next{curr->next};
+            Node*& head{buckets[static_cast<std::size_t>(hasher(curr->key) & (capacity - 1))]};
+            curr->next = head;
+            head = curr;
+            curr = next;
+        }
+
+        old_buckets[rehash_pos] = nullptr;
+    }
+
+    if (rehash_pos == old_capacity) {
+        std::free(old_buckets);
+        old_buckets = nullptr;
+        old_capacity = 0;
+        rehash_pos = 0;
+    }
+
+    record_rehash_time(started);
+}
+
+#ifdef HASHMAP_STATS
+// Snapshots the occupancy histogram and memory in use alongside the counters
+template <typename K, typename V, typename Hash, typename Eq>
+HashMapStats HashMap<K, V, Hash, Eq>::get_stats() const {
+    HashMapStats result;
+    result.operations = stats.operations.load(std::memory_order_relaxed);
+    result.collisions = stats.collisions.load(std::memory_order_relaxed);
+    result.rehashes = stats.rehashes.load(std::memory_order_relaxed);
+    result.rehash_ns = stats.rehash_ns.load(std::memory_order_relaxed);
+    result.bytes_allocated = stats.bytes_allocated.load(std::memory_order_relaxed);
+
+    for (std::size_t i{0}; i < HashMapStats::histogram_size; ++i) {
+        result.probe_lengths[i] = stats.probe_lengths[i].load(std::memory_order_relaxed);
+    }
+
+    result.size = size;
+    result.capacity = capacity;
+    result.load_factor = load_factor();
+    result.bytes_in_use = (capacity + old_capacity) * sizeof(Node*) + size * sizeof(Node);
+
+    for (std::size_t i{0}; i < bucket_span(); ++i) {
+        std::size_t length{0};
+
+        for (const Node* curr{bucket_head(i)}; curr != nullptr; curr = curr->next) {
+            ++length;
+        }
+
+        ++result.occupancy[length < HashMapStats::histogram_size ? length : HashMapStats::histogram_size - 1];
+    }
+
+    return result;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+void HashMap<K, V, Hash, Eq>::reset_stats() {
+    stats.operations.store(0, std::memory_order_relaxed);
+    stats.collisions.store(0, std::memory_order_relaxed);
+    stats.rehashes.store(0, std::memory_order_relaxed);
+    stats.rehash_ns.store(0, std::memory_order_relaxed);
+    stats.bytes_allocated.store(0, std::memory_order_relaxed);
+
+    for (auto& count : stats.probe_lengths) {
+        count.store(0, std::memory_order_relaxed);
+    }
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+void HashMap<K, V, Hash, Eq>::record_probe(std::size_t compared, bool matched) const {
+    stats.operations.fetch_add(1, std::memory_order_relaxed);
+    stats.probe_lengths[compared < HashMapStats::histogram_size ? compared : HashMapStats::histogram_size - 1].fetch_add(1, std::memory_order_relaxed);
+    stats.collisions.fetch_add(matched ? compared - 1 : compared, std::memory_order_relaxed);
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+void HashMap<K, V, Hash, Eq>::record_allocation(std::size_t bytes) {
+    stats.bytes_allocated.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+void HashMap<K, V, Hash, Eq>::record_rehash_start() {
+    stats.rehashes.fetch_add(1, std::memory_order_relaxed);
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+void HashMap<K, V, Hash, Eq>::record_rehash_time(std::uint64_t started_ns) {
+    stats.rehash_ns.fetch_add(stats_clock_ns() - started_ns, std::memory_order_relaxed);
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+std::uint64_t HashMap<K, V, Hash, Eq>::stats_clock_ns() {
+    auto now{std::chrono::steady_clock::now().time_since_epoch()};
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count());
+}
+#else
+template <typename K, typename V, typename Hash, typename Eq>
+void HashMap<K, V, Hash, Eq>::record_probe(std::size_t, bool) const {
+
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+void HashMap<K, V, Hash, Eq>::record_allocation(std::size_t) {
+
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+void HashMap<K, V, Hash, Eq>::record_rehash_start() {
+
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+void HashMap<K, V, Hash, Eq>::record_rehash_time(std::uint64_t) {
+
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+std::uint64_t HashMap<K, V, Hash, Eq>::stats_clock_ns() {
+    return 0;
+}
+#endif
+
 #endif
@@ -0,0 +1,5 @@
+#include "LockFreeHashMap.h"
+
+// LockFreeHashMap is a class template defined in LockFreeHashMap.h;
+// instantiating the default map here type-checks every member
+template class LockFreeHashMap<>;
@@ -0,0 +1,374 @@
+#ifndef LOCKFREEHASHMAP_H
+#define LOCKFREEHASHMAP_H
+
+#include "HashMap.h"
+#include "EpochManager.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <utility>
+
+template <typename K, typename V, typename Hash, typename Eq>
+class LockFreeHashMap;
+
+template <typename K, typename V>
+class LockFreeHashNode {
+    private:
+        template <typename KK, typename VV>
+        LockFreeHashNode(KK&& k, VV&& v, LockFreeHashNode* new_next): key(std::forward<KK>(k)), value(std::forward<VV>(v)), next{new_next} {
+
+        }
+
+        // Immutable once published; an update replaces the whole node
+        const K key;
+        const V value;
+        std::atomic<LockFreeHashNode*> next;
+
+    template <typename, typename, typename, typename>
+    friend class LockFreeHashMap;
+};
+
+// A chained hash map for read-dominated workloads. get and contains take no
+// locks: they pin an epoch and follow acquire loads, finishing after one chain
+// walk plus at most a hop per table still being migrated. Writers serialize on
+// a mutex, publish every change with a single release store, and never modify a
+// node a reader can see, so unlinked nodes and tables are retired through the
+// epoch manager instead of freed. Growth is incremental: each write migrates a
+// few buckets by copying their chains into the next table and marking the old
+// bucket as moved, which sends readers on to the next table.
+template <typename K = int, typename V = int, typename Hash = MixHash, typename Eq = std::equal_to<>>
+class LockFreeHashMap {
+    public:
+        LockFreeHashMap();
+        LockFreeHashMap(const LockFreeHashMap& orig) = delete;
+        LockFreeHashMap(LockFreeHashMap&& orig) noexcept = delete;
+        LockFreeHashMap& operator=(const LockFreeHashMap& rhs) = delete;
+        LockFreeHashMap& operator=(LockFreeHashMap&& rhs) noexcept = delete;
+        ~LockFreeHashMap();
+        std::size_t get_size() const;
+        std::size_t get_capacity() const;
+        bool empty() const;
+        bool is_rehashing() const;
+        void clear();
+        void insert(const K& key, const V& value);
+        bool insert_or_assign(const K& key, const V& value);
+        bool contains(const K& key) const;
+        bool get(const K& key, V& out) const;
+        void remove(const K& key);
+
+    private:
+        using Node = LockFreeHashNode<K, V>;
+
+        struct Table {
+            explicit Table(std::size_t new_capacity): capacity{new_capacity}, buckets{new std::atomic<Node*>[new_capacity]}, next{nullptr} {
+                for (std::size_t k{0}; k < capacity; ++k) {
+                    buckets[k].store(nullptr, std::memory_order_relaxed);
+                }
+            }
+
+            ~Table() {
+                delete[] buckets;
+            }
+
+            std::size_t capacity; // Always a power of two
+            std::atomic<Node*>* buckets;
+            std::atomic<Table*> next; // Table this one is migrating into, if any
+        };
+
+        static constexpr std::size_t initial_capacity{16}; // Must be a power of two
+        static constexpr std::size_t rehash_buckets_per_op{4}; // Old buckets migrated by each insert or remove
+
+        std::atomic<Table*> table; // Oldest live table, where readers start
+        Table* newest;             // Table writers insert into; equals table unless rehashing
+        std::size_t rehash_pos;    // Next bucket of table to migrate into newest
+        std::atomic<std::size_t> size;
+        mutable std::mutex write_lock;
+        mutable EpochManager epochs;
+        Hash hasher;
+        Eq equal;
+        static Node* moved_marker();
+        static void free_node(void* node);
+        static void free_table(void* t);
+        std::atomic<Node*>& writer_bucket(std::uint64_t h);
+        void migrate_bucket(std::size_t j);
+        void rehash_step(std::size_t max_buckets);
+        void grow_if_needed();
+};
+
+template <typename K, typename V, typename Hash, typename Eq>
+LockFreeHashMap<K, V, Hash, Eq>::LockFreeHashMap(): table{new Table{initial_capacity}}, newest{table.load()}, rehash_pos{0}, size{0}, hasher{}, equal{} {
+
+}
+
+// No reader may be running, so chains and tables are freed directly
+template <typename K, typename V, typename Hash, typename Eq>
+LockFreeHashMap<K, V, Hash, Eq>::~LockFreeHashMap() {
+    Table* oldest{table.load()};
+    Table* tables[]{oldest, oldest == newest ? nullptr : newest};
+
+    for (Table* t : tables) {
+        if (t == nullptr) {
+            continue;
+        }
+
+        for (std::size_t k{0}; k < t->capacity; ++k) {
+            Node* curr{t->buckets[k].load()};
+
+            if (curr == moved_marker()) {
+                continue;
+            }
+
+            while (curr != nullptr) {
+                Node* temp{curr};
+                curr = curr->next.load();
+                delete temp;
+            }
+        }
+
+        delete t;
+    }
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+std::size_t LockFreeHashMap<K, V, Hash, Eq>::get_size() const {
+    return size.load(std::memory_order_relaxed);
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+std::size_t LockFreeHashMap<K, V, Hash, Eq>::get_capacity() const {
+    std::lock_guard<std::mutex> guard{write_lock};
+    return newest->capacity;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+bool LockFreeHashMap<K, V, Hash, Eq>::empty() const {
+    return get_size() == 0;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+bool LockFreeHashMap<K, V, Hash, Eq>::is_rehashing() const {
+    std::lock_guard<std::mutex> guard{write_lock};
+    return table.load(std::memory_order_relaxed) != newest;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+void LockFreeHashMap<K, V, Hash, Eq>::clear() {
+    std::lock_guard<std::mutex> guard{write_lock};
+    Table* oldest{table.load(std::memory_order_relaxed)};
+
+    if (oldest != newest) {
+        rehash_step(oldest->capacity);
+    }
+
+    for (std::size_t k{0}; k < newest->capacity; ++k) {
+        Node* curr{newest->buckets[k].load(std::memory_order_relaxed)};
+        newest->buckets[k].store(nullptr, std::memory_order_release);
+
+        while (curr != nullptr) {
+            Node* temp{curr};
+            curr = curr->next.load(std::memory_order_relaxed);
+            epochs.retire(temp, free_node);
+        }
+    }
+
+    size.store(0, std::memory_order_relaxed);
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+void LockFreeHashMap<K, V, Hash, Eq>::insert(const K& key, const V& value) {
+    insert_or_assign(key, value);
+}
+
+// An existing key gets a fresh node swapped in, so readers see the old or the new value, never a torn one
+template <typename K, typename V, typename Hash, typename Eq>
+bool LockFreeHashMap<K, V, Hash, Eq>::insert_or_assign(const K& key, const V& value) {
+    std::lock_guard<std::mutex> guard{write_lock};
+    rehash_step(rehash_buckets_per_op);
+    std::atomic<Node*>& bucket{writer_bucket(hasher(key))};
+    std::atomic<Node*>* link{&bucket};
+
+    for (Node* curr{bucket.load(std::memory_order_relaxed)}; curr != nullptr; curr = curr->next.load(std::memory_order_relaxed)) {
+        if (equal(curr->key, key)) {
+            link->store(new Node{curr->key, value, curr->next.load(std::memory_order_relaxed)}, std::memory_order_release);
+            epochs.retire(curr, free_node);
+            return false;
+        }
+
+        link = &curr->next;
+    }
+
+    bucket.store(new Node{key, value, bucket.load(std::memory_order_relaxed)}, std::memory_order_release);
+    size.fetch_add(1, std::memory_order_relaxed);
+    grow_if_needed();
+
+    return true;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+bool LockFreeHashMap<K, V, Hash, Eq>::contains(const K& key) const {
+    EpochGuard guard{epochs};
+    std::uint64_t h{hasher(key)};
+    const Table* t{table.load(std::memory_order_acquire)};
+
+    while (true) {
+        const Node* curr{t->buckets[h & (t->capacity - 1)].load(std::memory_order_acquire)};
+
+        if (curr == moved_marker()) {
+            t = t->next.load(std::memory_order_acquire);
+            continue;
+        }
+
+        for (; curr != nullptr; curr = curr->next.load(std::memory_order_acquire)) {
+            if (equal(curr->key, key)) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+bool LockFreeHashMap<K, V, Hash, Eq>::get(const K& key, V& out) const {
+    EpochGuard guard{epochs};
+    std::uint64_t h{hasher(key)};
+    const Table* t{table.load(std::memory_order_acquire)};
+
+    while (true) {
+        const Node* curr{t->buckets[h & (t->capacity - 1)].load(std::memory_order_acquire)};
+
+        if (curr == moved_marker()) {
+            t = t->next.load(std::memory_order_acquire);
+            continue;
+        }
+
+        for (; curr != nullptr; curr = curr->next.load(std::memory_order_acquire)) {
+            if (equal(curr->key, key)) {
+                out = curr->value;
+                return true;
+            }
+        }
+
+        return false;
+    }
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+void LockFreeHashMap<K, V, Hash, Eq>::remove(const K& key) {
+    std::lock_guard<std::mutex> guard{write_lock};
+    rehash_step(rehash_buckets_per_op);
+    std::atomic<Node*>* link{&writer_bucket(hasher(key))};
+
+    for (Node* curr{link->load(std::memory_order_relaxed)}; curr != nullptr; curr = curr->next.load(std::memory_order_relaxed)) {
+        if (equal(curr->key, key)) {
+            link->store(curr->next.load(std::memory_order_relaxed), std::memory_order_release);
+            epochs.retire(curr, free_node);
+            size.fetch_sub(1, std::memory_order_relaxed);
+            return;
+        }
+
+        link = &curr->next;
+    }
+}
+
+// Marks a migrated bucket; never a real node, which is always at least 2-aligned
+template <typename K, typename V, typename Hash, typename Eq>
+LockFreeHashNode<K, V>* LockFreeHashMap<K, V, Hash, Eq>::moved_marker() {
+    return reinterpret_cast<Node*>(std::uintptr_t{1});
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+void LockFreeHashMap<K, V, Hash, Eq>::free_node(void* node) {
+    delete static_cast<Node*>(node);
+}
+
+// Only called once every bucket of t has moved, so no chains are left to free
+template <typename K, typename V, typename Hash, typename Eq>
+void LockFreeHashMap<K, V, Hash, Eq>::free_table(void* t) {
+    delete static_cast<Table*>(t);
+}
+
+// Writers only touch newest, so a key's old bucket is migrated before its new one is written
+template <typename K, typename V, typename Hash, typename Eq>
+std::atomic<LockFreeHashNode<K, V>*>& LockFreeHashMap<K, V, Hash, Eq>::writer_bucket(std::uint64_t h) {
+    Table* oldest{table.load(std::memory_order_relaxed)};
+
+    if (oldest != newest) {
+        migrate_bucket(static_cast<std::size_t>(h & (oldest->capacity - 1)));
+    }
+
+    return newest->buckets[h & (newest->capacity - 1)];
+}
+
+// Copies bucket j's chain into newest and then marks it moved. The new buckets
+// it fills receive keys from bucket j only, so readers cannot reach them until
+// the release store of the marker, and readers already inside the old chain
+// finish walking nodes that stay intact until their epoch ends.
+template <typename K, typename V, typename Hash, typename Eq>
+void LockFreeHashMap<K, V, Hash, Eq>::migrate_bucket(std::size_t j) {
+    Table* oldest{table.load(std::memory_order_relaxed)};
+    Node* head{oldest->buckets[j].load(std::memory_order_relaxed)};
+
+    if (head == moved_marker()) {
+        return;
+    }
+
+    for (Node* curr{head}; curr != nullptr; curr = curr->next.load(std::memory_order_relaxed)) {
+        std::atomic<Node*>& dest{newest->buckets[hasher(curr->key) & (newest->capacity - 1)]};
+        dest.store(new Node{curr->key, curr->value, dest.load(std::memory_order_relaxed)}, std::memory_order_relaxed);
+    }
+
+    oldest->buckets[j].store(moved_marker(), std::memory_order_release);
+
+    while (head != nullptr) {
+        Node* temp{head};
+        head = head->next.load(std::memory_order_relaxed);
+        epochs.retire(temp, free_node);
+    }
+}
+
+// Migrates up to max_buckets buckets, then publishes newest to readers and
+// retires the old table once every bucket has moved
+template <typename K, typename V, typename Hash, typename Eq>
+void LockFreeHashMap<K, V, Hash, Eq>::rehash_step(std::size_t max_buckets) {
+    Table* oldest{table.load(std::memory_order_relaxed)};
+
+    if (oldest == newest) {
+        return;
+    }
+
+    for (std::size_t moved{0}; moved < max_buckets && rehash_pos < oldest->capacity; ++moved) {
+        migrate_bucket(rehash_pos);
+        ++rehash_pos;
+    }
+
+    if (rehash_pos == oldest->capacity) {
+        table.store(newest, std::memory_order_release);
+        epochs.retire(oldest, free_table);
+        rehash_pos = 0;
+    }
+}
+
+// Links a table twice as large behind newest. A migration still in progress is
+// finished first, so at most two tables are ever live.
+template <typename K, typename V, typename Hash, typename Eq>
+void LockFreeHashMap<K, V, Hash, Eq>::grow_if_needed() {
+    if (size.load(std::memory_order_relaxed) * 10 <= newest->capacity * 7) {
+        return;
+    }
+
+    Table* oldest{table.load(std::memory_order_relaxed)};
+
+    if (oldest != newest) {
+        rehash_step(oldest->capacity);
+    }
+
+    Table* bigger{new Table{newest->capacity * 2}};
+    newest->next.store(bigger, std::memory_order_release);
+    newest = bigger;
+}
+
+#endif
@@ -0,0 +1,8 @@
+#include "LruCache.h"
+
+#include <string>
+
+// LruCache is a class template defined in LruCache.h; instantiating the
+// common caches here type-checks every member even when no caller uses it
+template class LruCache<>;
+template class LruCache<std::string, std::string>;
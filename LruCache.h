@@ -0,0 +1,379 @@
+#ifndef LRUCACHE_H
+#define LRUCACHE_H
+
+#include "HashMap.h"
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+
+enum class EvictionPolicy {
+    Lru,   // Evict the least recently used entry; every hit relinks
+    Clock  // Second chance: a hit only sets a flag, and the hand skips flagged entries once
+};
+
+// Bounded cache over a HashMap from key to slot in a fixed node pool. Under
+// Lru the slots form an intrusive doubly-linked list by index, most recent at
+// the head, so get, put and evict are O(1) with no allocation after
+// construction. Under Clock the slots are a ring swept by a hand instead.
+// get counts hits and misses.
+template <typename K = int, typename V = int, typename Hash = MixHash, typename Eq = std::equal_to<>>
+class LruCache {
+    public:
+        explicit LruCache(std::size_t new_capacity, EvictionPolicy new_policy = EvictionPolicy::Lru);
+        LruCache(const LruCache& orig);
+        LruCache(LruCache&& orig) noexcept;
+        LruCache& operator=(const LruCache& rhs);
+        LruCache& operator=(LruCache&& rhs) noexcept;
+        ~LruCache();
+        std::size_t get_size() const;
+        std::size_t get_capacity() const;
+        EvictionPolicy get_policy() const;
+        bool empty() const;
+        void clear();
+        bool get(const K& key, V& out);
+        V* find(const K& key);
+        void put(const K& key, const V& value);
+        bool contains(const K& key) const;
+        void remove(const K& key);
+        std::size_t get_hits() const;
+        std::size_t get_misses() const;
+        double hit_ratio() const;
+        void reset_stats();
+
+    private:
+        static constexpr std::uint32_t npos{UINT32_MAX};
+
+        struct Slot {
+            K key;
+            V value;
+            std::uint32_t prev;
+            std::uint32_t next;
+            bool referenced;
+        };
+
+        std::size_t capacity;
+        std::size_t size;
+        EvictionPolicy policy;
+        Slot* slots;
+        HashMap<K, std::uint32_t, Hash, Eq> index;
+        std::uint32_t head;      // Lru: most recently used; npos when empty
+        std::uint32_t tail;      // Lru: least recently used
+        std::uint32_t free_head; // Slots freed by remove, chained through next
+        std::uint32_t hand;      // Clock: next slot to consider for eviction
+        std::size_t hits;
+        std::size_t misses;
+        void touch(std::uint32_t i);
+        void unlink(std::uint32_t i);
+        void push_front(std::uint32_t i);
+        std::uint32_t take_slot();
+        std::uint32_t evict();
+        void copy_from(const LruCache& orig);
+};
+
+template <typename K, typename V, typename Hash, typename Eq>
+LruCache<K, V, Hash, Eq>::LruCache(std::size_t new_capacity, EvictionPolicy new_policy):
+    capacity{new_capacity == 0 ? 1 : new_capacity}, size{0}, policy{new_policy}, slots{new Slot[capacity]}, index{},
+    head{npos}, tail{npos}, free_head{npos}, hand{0}, hits{0}, misses{0} {
+    assert(capacity < npos);
+    index.reserve(capacity);
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+LruCache<K, V, Hash, Eq>::LruCache(const LruCache& orig): capacity{orig.capacity}, size{0}, policy{orig.policy}, slots{new Slot[capacity]},
+                                                          index{}, head{npos}, tail{npos}, free_head{npos}, hand{0}, hits{0}, misses{0} {
+    copy_from(orig);
+}
+
+// Leaves orig empty with a one-slot pool, so it stays usable
+template <typename K, typename V, typename Hash, typename Eq>
+LruCache<K, V, Hash, Eq>::LruCache(LruCache&& orig) noexcept: capacity{orig.capacity}, size{orig.size}, policy{orig.policy}, slots{orig.slots},
+                                                              index{std::move(orig.index)}, head{orig.head}, tail{orig.tail}, free_head{orig.free_head},
+                                                              hand{orig.hand}, hits{orig.hits}, misses{orig.misses} {
+    orig.capacity = 1;
+    orig.slots = new Slot[1];
+    orig.size = 0;
+    orig.head = npos;
+    orig.tail = npos;
+    orig.free_head = npos;
+    orig.hand = 0;
+    orig.hits = 0;
+    orig.misses = 0;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+LruCache<K, V, Hash, Eq>& LruCache<K, V, Hash, Eq>::operator=(const LruCache& rhs) {
+    if (this == &rhs) {
+        return *this;
+    }
+
+    delete[] slots;
+    capacity = rhs.capacity;
+    policy = rhs.policy;
+    slots = new Slot[capacity];
+    index.clear();
+    copy_from(rhs);
+
+    return *this;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+LruCache<K, V, Hash, Eq>& LruCache<K, V, Hash, Eq>::operator=(LruCache&& rhs) noexcept {
+    if (this == &rhs) {
+        return *this;
+    }
+
+    delete[] slots;
+    capacity = rhs.capacity;
+    size = rhs.size;
+    policy = rhs.policy;
+    slots = rhs.slots;
+    index = std::move(rhs.index);
+    head = rhs.head;
+    tail = rhs.tail;
+    free_head = rhs.free_head;
+    hand = rhs.hand;
+    hits = rhs.hits;
+    misses = rhs.misses;
+    rhs.capacity = 1;
+    rhs.slots = new Slot[1];
+    rhs.size = 0;
+    rhs.head = npos;
+    rhs.tail = npos;
+    rhs.free_head = npos;
+    rhs.hand = 0;
+    rhs.hits = 0;
+    rhs.misses = 0;
+
+    return *this;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+LruCache<K, V, Hash, Eq>::~LruCache() {
+    delete[] slots;
+    slots = nullptr;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+std::size_t LruCache<K, V, Hash, Eq>::get_size() const {
+    return size;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+std::size_t LruCache<K, V, Hash, Eq>::get_capacity() const {
+    return capacity;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+EvictionPolicy LruCache<K, V, Hash, Eq>::get_policy() const {
+    return policy;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+bool LruCache<K, V, Hash, Eq>::empty() const {
+    return size == 0;
+}
+
+// Keeps the hit and miss counters
+template <typename K, typename V, typename Hash, typename Eq>
+void LruCache<K, V, Hash, Eq>::clear() {
+    index.clear();
+    size = 0;
+    head = npos;
+    tail = npos;
+    free_head = npos;
+    hand = 0;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+bool LruCache<K, V, Hash, Eq>::get(const K& key, V& out) {
+    V* value{find(key)};
+
+    if (value == nullptr) {
+        return false;
+    }
+
+    out = *value;
+    return true;
+}
+
+// Like get, but returns a pointer valid until the next put or remove
+template <typename K, typename V, typename Hash, typename Eq>
+V* LruCache<K, V, Hash, Eq>::find(const K& key) {
+    std::uint32_t* i{index.find(key)};
+
+    if (i == nullptr) {
+        ++misses;
+        return nullptr;
+    }
+
+    ++hits;
+    touch(*i);
+    return &slots[*i].value;
+}
+
+// Inserts or overwrites key, evicting one entry if the cache is full. An
+// overwrite counts as a use but not as a hit.
+template <typename K, typename V, typename Hash, typename Eq>
+void LruCache<K, V, Hash, Eq>::put(const K& key, const V& value) {
+    std::uint32_t* existing{index.find(key)};
+
+    if (existing != nullptr) {
+        slots[*existing].value = value;
+        touch(*existing);
+        return;
+    }
+
+    std::uint32_t i{size < capacity ? take_slot() : evict()};
+    slots[i].key = key;
+    slots[i].value = value;
+    slots[i].referenced = false;
+    index.insert(key, i);
+    ++size;
+
+    if (policy == EvictionPolicy::Lru) {
+        push_front(i);
+    }
+}
+
+// Does not count as a use, a hit or a miss
+template <typename K, typename V, typename Hash, typename Eq>
+bool LruCache<K, V, Hash, Eq>::contains(const K& key) const {
+    return index.contains(key);
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+void LruCache<K, V, Hash, Eq>::remove(const K& key) {
+    std::uint32_t* found{index.find(key)};
+
+    if (found == nullptr) {
+        return;
+    }
+
+    std::uint32_t i{*found};
+    index.remove(key);
+    --size;
+
+    if (policy == EvictionPolicy::Lru) {
+        unlink(i);
+    }
+
+    slots[i].next = free_head;
+    free_head = i;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+std::size_t LruCache<K, V, Hash, Eq>::get_hits() const {
+    return hits;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+std::size_t LruCache<K, V, Hash, Eq>::get_misses() const {
+    return misses;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+double LruCache<K, V, Hash, Eq>::hit_ratio() const {
+    return hits + misses == 0 ? 0.0 : 1.0 * hits / (hits + misses);
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+void LruCache<K, V, Hash, Eq>::reset_stats() {
+    hits = 0;
+    misses = 0;
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+void LruCache<K, V, Hash, Eq>::touch(std::uint32_t i) {
+    if (policy == EvictionPolicy::Clock) {
+        slots[i].referenced = true;
+    } else if (i != head) {
+        unlink(i);
+        push_front(i);
+    }
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+void LruCache<K, V, Hash, Eq>::unlink(std::uint32_t i) {
+    if (slots[i].prev == npos) {
+        head = slots[i].next;
+    } else {
+        slots[slots[i].prev].next = slots[i].next;
+    }
+
+    if (slots[i].next == npos) {
+        tail = slots[i].prev;
+    } else {
+        slots[slots[i].next].prev = slots[i].prev;
+    }
+}
+
+template <typename K, typename V, typename Hash, typename Eq>
+void LruCache<K, V, Hash, Eq>::push_front(std::uint32_t i) {
+    slots[i].prev = npos;
+    slots[i].next = head;
+
+    if (head == npos) {
+        tail = i;
+    } else {
+        slots[head].prev = i;
+    }
+
+    head = i;
+}
+
+// A slot freed by remove if there is one, else the first never-used slot
+template <typename K, typename V, typename Hash, typename Eq>
+std::uint32_t LruCache<K, V, Hash, Eq>::take_slot() {
+    if (free_head == npos) {
+        return static_cast<std::uint32_t>(size);
+    }
+
+    std::uint32_t i{free_head};
+    free_head = slots[i].next;
+    return i;
+}
+
+// Frees one slot and returns it. The entry is dropped from the index here;
+// the caller reuses the slot and counts it back in.
+template <typename K, typename V, typename Hash, typename Eq>
+std::uint32_t LruCache<K, V, Hash, Eq>::evict() {
+    std::uint32_t victim{tail};
+
+    if (policy == EvictionPolicy::Clock) {
+        while (slots[hand].referenced) {
+            slots[hand].referenced = false;
+            hand = hand + 1 == capacity ? 0 : hand + 1;
+        }
+
+        victim = hand;
+        hand = hand + 1 == capacity ? 0 : hand + 1;
+    } else {
+        unlink(victim);
+    }
+
+    index.remove(slots[victim].key);
+    --size;
+    return victim;
+}
+
+// Assumes this cache is empty with a pool sized like orig's
+template <typename K, typename V, typename Hash, typename Eq>
+void LruCache<K, V, Hash, Eq>::copy_from(const LruCache& orig) {
+    for (std::size_t i{0}; i < capacity; ++i) {
+        slots[i] = orig.slots[i];
+    }
+
+    index = orig.index;
+    size = orig.size;
+    head = orig.head;
+    tail = orig.tail;
+    free_head = orig.free_head;
+    hand = orig.hand;
+    hits = orig.hits;
+    misses = orig.misses;
+}
+
+#endif
@@ -0,0 +1,293 @@
+#include "PersistentBinarySearchTree.h"
+
+#include <iostream>
+#include <algorithm>
+#include <cassert>
+#include <utility>
+#include <vector>
+
+PersistentBinarySearchTree::PersistentBinarySearchTree(): root{nullptr}, size{0} {
+
+}
+
+// Builds a balanced tree from source's keys in O(n)
+PersistentBinarySearchTree::PersistentBinarySearchTree(const BinarySearchTree& source): root{nullptr}, size{source.get_size()} {
+    std::vector<double> sorted;
+    sorted.reserve(size);
+    source.for_each_inorder([&sorted](double value) { sorted.push_back(value); });
+    root = build(sorted.data(), sorted.size());
+}
+
+// O(1): the copy shares every node with orig
+PersistentBinarySearchTree::PersistentBinarySearchTree(const PersistentBinarySearchTree& orig): root{acquire(orig.root)}, size{orig.size} {
+
+}
+
+PersistentBinarySearchTree::PersistentBinarySearchTree(PersistentBinarySearchTree&& orig) noexcept: root{orig.root}, size{orig.size} {
+    orig.root = nullptr;
+    orig.size = 0;
+}
+
+PersistentBinarySearchTree& PersistentBinarySearchTree::operator=(const PersistentBinarySearchTree& rhs) {
+    if (this == &rhs) {
+        return *this;
+    }
+
+    Node* old_root{root};
+    root = acquire(rhs.root);
+    size = rhs.size;
+    release(old_root);
+
+    return *this;
+}
+
+PersistentBinarySearchTree& PersistentBinarySearchTree::operator=(PersistentBinarySearchTree&& rhs) noexcept {
+    if (this == &rhs) {
+        return *this;
+    }
+
+    release(root);
+    root = rhs.root;
+    size = rhs.size;
+    rhs.root = nullptr;
+    rhs.size = 0;
+
+    return *this;
+}
+
+PersistentBinarySearchTree::~PersistentBinarySearchTree() {
+    release(root);
+    root = nullptr;
+}
+
+PersistentBinarySearchTree PersistentBinarySearchTree::snapshot() const {
+    return *this;
+}
+
+// Frees only the nodes no other version shares
+void PersistentBinarySearchTree::clear() {
+    release(root);
+    root = nullptr;
+    size = 0;
+}
+
+std::size_t PersistentBinarySearchTree::get_size() const {
+    return size;
+}
+
+bool PersistentBinarySearchTree::empty() const {
+    return size == 0;
+}
+
+void PersistentBinarySearchTree::insert(double value) {
+    if (contains(value)) {
+        return;
+    }
+
+    Node** link{&root};
+
+    while (*link != nullptr) {
+        Node* curr{own(*link)};
+        link = value < curr->data ? &curr->left : &curr->right;
+    }
+
+    *link = new Node{value, nullptr, nullptr};
+    ++size;
+}
+
+bool PersistentBinarySearchTree::contains(double value) const {
+    const Node* curr{root};
+
+    while (curr != nullptr && curr->data != value) {
+        curr = value < curr->data ? curr->left : curr->right;
+    }
+
+    return curr != nullptr;
+}
+
+double PersistentBinarySearchTree::min() const {
+    assert(!empty());
+    const Node* curr{root};
+
+    while (curr->left != nullptr) {
+        curr = curr->left;
+    }
+
+    return curr->data;
+}
+
+double PersistentBinarySearchTree::max() const {
+    assert(!empty());
+    const Node* curr{root};
+
+    while (curr->right != nullptr) {
+        curr = curr->right;
+    }
+
+    return curr->data;
+}
+
+std::size_t PersistentBinarySearchTree::height() const {
+    std::vector<std::pair<const Node*, std::size_t>> pending;
+    std::size_t deepest{0};
+
+    if (root != nullptr) {
+        pending.emplace_back(root, 1);
+    }
+
+    while (!pending.empty()) {
+        auto [curr, depth] = pending.back();
+        pending.pop_back();
+        deepest = std::max(deepest, depth);
+
+        if (curr->left != nullptr) {
+            pending.emplace_back(curr->left, depth + 1);
+        }
+
+        if (curr->right != nullptr) {
+            pending.emplace_back(curr->right, depth + 1);
+        }
+    }
+
+    return deepest;
+}
+
+void PersistentBinarySearchTree::inorder_print() const {
+    walk_inorder([](double value) { std::cout << value << " "; });
+    std::cout << "\n";
+}
+
+void PersistentBinarySearchTree::erase(double value) {
+    if (!contains(value)) {
+        return;
+    }
+
+    Node** link{&root};
+    Node* target{own(*link)};
+
+    while (target->data != value) {
+        link = value < target->data ? &target->left : &target->right;
+        target = own(*link);
+    }
+
+    Node** unlink{link};
+    Node* removed{target};
+
+    if (target->left != nullptr && target->right != nullptr) {
+        // Move the successor's key up and unlink the successor instead
+        unlink = &target->right;
+
+        while ((*unlink)->left != nullptr) {
+            unlink = &own(*unlink)->left;
+        }
+
+        removed = *unlink;
+        target->data = removed->data;
+    }
+
+    Node* child{removed->left != nullptr ? removed->left : removed->right};
+    *unlink = acquire(child);
+    release(removed);
+    --size;
+}
+
+// Valid exactly when the in-order walk is strictly increasing and has size keys
+bool PersistentBinarySearchTree::is_valid_bst() const {
+    bool valid{true};
+    bool first{true};
+    double prev{0.0};
+    std::size_t keys{0};
+
+    walk_inorder([&](double value) {
+        valid = valid && (first || prev < value);
+        first = false;
+        prev = value;
+        ++keys;
+    });
+
+    return valid && keys == size;
+}
+
+// True when both versions start from the same node, as after a copy with no writes since
+bool PersistentBinarySearchTree::shares_root_with(const PersistentBinarySearchTree& other) const {
+    return root == other.root;
+}
+
+PersistentBinarySearchTree::Node* PersistentBinarySearchTree::acquire(Node* node) {
+    if (node != nullptr) {
+        node->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    return node;
+}
+
+// Drops one reference, then frees whatever is no longer reachable from any
+// version without recursing, so a degenerate tree cannot overflow the stack
+void PersistentBinarySearchTree::release(Node* node) {
+    std::vector<Node*> pending;
+
+    while (node != nullptr) {
+        if (node->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            if (node->right != nullptr) {
+                pending.push_back(node->right);
+            }
+
+            Node* left{node->left};
+            delete node;
+            node = left;
+        } else {
+            node = nullptr;
+        }
+
+        if (node == nullptr && !pending.empty()) {
+            node = pending.back();
+            pending.pop_back();
+        }
+    }
+}
+
+// Makes the node behind link safe to change: a node only this version can
+// reach is returned as is, a shared one is replaced by a private copy that
+// shares its children. The caller must already own the node holding link.
+PersistentBinarySearchTree::Node* PersistentBinarySearchTree::own(Node*& link) {
+    Node* curr{link};
+
+    if (curr->refs.load(std::memory_order_acquire) == 1) {
+        return curr;
+    }
+
+    link = new Node{curr->data, acquire(curr->left), acquire(curr->right)};
+    release(curr);
+
+    return link;
+}
+
+PersistentBinarySearchTree::Node* PersistentBinarySearchTree::build(const double* sorted, std::size_t n) {
+    if (n == 0) {
+        return nullptr;
+    }
+
+    std::size_t mid{n / 2};
+    Node* left{build(sorted, mid)};
+    Node* right{build(sorted + mid + 1, n - mid - 1)};
+
+    return new Node{sorted[mid], left, right};
+}
+
+template <typename F>
+void PersistentBinarySearchTree::walk_inorder(F&& visit) const {
+    std::vector<const Node*> pending;
+    const Node* curr{root};
+
+    while (curr != nullptr || !pending.empty()) {
+        while (curr != nullptr) {
+            pending.push_back(curr);
+            curr = curr->left;
+        }
+
+        curr = pending.back();
+        pending.pop_back();
+        visit(curr->data);
+        curr = curr->right;
+    }
+}
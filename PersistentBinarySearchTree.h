@@ -0,0 +1,58 @@
+#ifndef PERSISTENTBINARYSEARCHTREE_H
+#define PERSISTENTBINARYSEARCHTREE_H
+
+#include "BinarySearchTree.h"
+
+#include <atomic>
+#include <cstddef>
+
+// Unbalanced binary search tree whose versions share structure. Nodes are
+// reference counted and never changed once a second version can reach them,
+// so copying the tree (or calling snapshot()) is O(1), and insert and erase
+// copy only the nodes on the path to the key, O(log n) on random keys. Nodes
+// reachable from this version alone are updated in place, so a tree with no
+// live snapshots pays only the uniqueness checks. Different versions may be
+// read, written and destroyed on different threads at the same time; a single
+// version follows the usual rule of one writer or any number of readers.
+class PersistentBinarySearchTree {
+    public:
+        PersistentBinarySearchTree();
+        explicit PersistentBinarySearchTree(const BinarySearchTree& source);
+        PersistentBinarySearchTree(const PersistentBinarySearchTree& orig);
+        PersistentBinarySearchTree(PersistentBinarySearchTree&& orig) noexcept;
+        PersistentBinarySearchTree& operator=(const PersistentBinarySearchTree& rhs);
+        PersistentBinarySearchTree& operator=(PersistentBinarySearchTree&& rhs) noexcept;
+        ~PersistentBinarySearchTree();
+        PersistentBinarySearchTree snapshot() const;
+        void clear();
+        std::size_t get_size() const;
+        bool empty() const;
+        void insert(double value);
+        bool contains(double value) const;
+        double min() const;
+        double max() const;
+        std::size_t height() const;
+        void inorder_print() const;
+        void erase(double value);
+        bool is_valid_bst() const;
+        bool shares_root_with(const PersistentBinarySearchTree& other) const;
+
+    private:
+        struct Node {
+            double data;
+            Node* left;
+            Node* right;
+            std::atomic<std::size_t> refs; // Links from parents in any version, plus a tree's root link
+            Node(double value, Node* new_left, Node* new_right): data{value}, left{new_left}, right{new_right}, refs{1} {}
+        };
+
+        Node* root;
+        std::size_t size;
+        static Node* acquire(Node* node);
+        static void release(Node* node);
+        static Node* own(Node*& link);
+        static Node* build(const double* sorted, std::size_t n);
+        template <typename F> void walk_inorder(F&& visit) const;
+};
+
+#endif
@@ -1,17 +1,39 @@
 // Performance tests for data structures libary
-// clang++ -std=c++17 -O2 -Wall -Wextra -Wpedantic bench.cpp DynamicArray.cpp \
-// Stack.cpp LinkedList.cpp Queue.cpp HashMap.cpp BinarySearchTree.cpp -o bench && ./bench
+// clang++ -std=c++17 -O2 -Wall -Wextra -Wpedantic -pthread bench.cpp DynamicArray.cpp \
+// Stack.cpp LinkedList.cpp Queue.cpp HashMap.cpp DenseHashMap.cpp FrozenHashMap.cpp \
+// ConcurrentHashMap.cpp EpochManager.cpp LockFreeHashMap.cpp BloomFilter.cpp \
+// LruCache.cpp BinarySearchTree.cpp AVLTree.cpp BPlusTree.cpp FrozenSet.cpp \
+// CompactBinarySearchTree.cpp ConcurrentOrderedSet.cpp PersistentBinarySearchTree.cpp \
+// FlatSet.cpp -o bench && ./bench
+// Add -DHASHMAP_STATS to also print HashMap statistics (this slows every HashMap down)
 
 #include "DynamicArray.h"
 #include "LinkedList.h"
 #include "Stack.h"
 #include "Queue.h"
 #include "HashMap.h"
+#include "DenseHashMap.h"
+#include "FrozenHashMap.h"
+#include "ConcurrentHashMap.h"
+#include "LockFreeHashMap.h"
+#include "BloomFilter.h"
+#include "LruCache.h"
 #include "BinarySearchTree.h"
+#include "AVLTree.h"
+#include "BPlusTree.h"
+#include "FrozenSet.h"
+#include "CompactBinarySearchTree.h"
+#include "ConcurrentOrderedSet.h"
+#include "PersistentBinarySearchTree.h"
+#include "FlatSet.h"
 
 #include <iostream>
+#include <algorithm>
 #include <cstddef>
+#include <cstdint>
+#include <cmath>
 #include <chrono>
+#include <iterator>
 #include <random>
 #include <vector>
 #include <list>
@@ -19,6 +41,17 @@
 #include <stack>
 #include <unordered_map>
 #include <set>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <sys/resource.h>
+#if __has_include(<flat_set>)
+#include <flat_set>
+#endif
 
 using Clock = std::chrono::steady_clock;
 
@@ -34,6 +67,45 @@ long long time_ms(F&& f) {
     return std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
 }
 
+// Peak resident set size of this process in KiB. On Linux, ru_maxrss survives
+// exec and would include the parent's pages, so read the per-image VmHWM instead.
+static long long self_peak_rss_kib() {
+#ifdef __linux__
+    std::ifstream status{"/proc/self/status"};
+    std::string line;
+
+    while (std::getline(status, line)) {
+        if (line.rfind("VmHWM:", 0) == 0) {
+            return std::stoll(line.substr(6));
+        }
+    }
+
+    return -1;
+#else
+    struct rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss / 1024; // Bytes on macOS
+#endif
+}
+
+// Runs "self --peak mode" in a fresh process and returns the peak it reports, so
+// memory the parent's heap has freed but kept cannot hide the allocation
+static long long peak_rss_kib(const char* self, const char* mode) {
+    std::string command{std::string{"\""} + self + "\" --peak " + mode};
+    FILE* child{popen(command.c_str(), "r")};
+    long long kib{-1};
+
+    if (child != nullptr) {
+        if (std::fscanf(child, "%lld", &kib) != 1) {
+            kib = -1;
+        }
+
+        pclose(child);
+    }
+
+    return kib;
+}
+
 static std::vector<int> make_random_ints(std::size_t n, int lo, int hi, unsigned seed = 12345) {
     std::mt19937 rng(seed);
     std::uniform_int_distribution<int> dist(lo, hi);
@@ -60,8 +132,147 @@ static std::vector<double> make_random_doubles(std::size_t n, double lo, double
     return v;
 }
 
-int main() {
+static std::vector<int> make_sequential_ints(std::size_t n, int start = 0) {
+    std::vector<int> v;
+    v.reserve(n);
+
+    for (std::size_t i{0}; i < n; ++i) {
+        v.push_back(start + (int)i);
+    }
+
+    return v;
+}
+
+// Multiples of stride, the pattern that collides under key % capacity
+static std::vector<int> make_strided_ints(std::size_t n, int stride) {
+    std::vector<int> v;
+    v.reserve(n);
+
+    for (std::size_t i{0}; i < n; ++i) {
+        v.push_back((int)i * stride);
+    }
+
+    return v;
+}
+
+// Zipf-distributed ranks in [0, universe) with exponent skew, scattered over
+// the int range so that popular keys are not also neighbouring keys
+static std::vector<int> make_zipf_ints(std::size_t n, std::size_t universe, double skew, unsigned seed = 12345) {
+    std::vector<double> cdf(universe);
+    double total{0.0};
+
+    for (std::size_t r{0}; r < universe; ++r) {
+        total += 1.0 / std::pow((double)(r + 1), skew);
+        cdf[r] = total;
+    }
+
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> dist(0.0, total);
+    std::vector<int> v;
+    v.reserve(n);
+
+    for (std::size_t i{0}; i < n; ++i) {
+        std::size_t rank{(std::size_t)(std::lower_bound(cdf.begin(), cdf.end(), dist(rng)) - cdf.begin())};
+        v.push_back((int)(std::min(rank, universe - 1) * 2654435761u));
+    }
+
+    return v;
+}
+
+#ifdef HASHMAP_STATS
+// Hashes an int to itself, so the bucket is key % capacity
+struct IdentityHash {
+    std::uint64_t operator()(int key) const {
+        return static_cast<std::uint64_t>(static_cast<unsigned>(key));
+    }
+};
+#endif
+
+// HashMap load strategies shared by the timing runs and the --peak child runs
+static void load_hashmap(const std::vector<int>& keys, const std::vector<int>& values, std::string_view mode) {
+    HashMap m;
+
+    if (mode == "reserve") {
+        m.reserve(keys.size());
+    }
+
+    if (mode == "bulk") {
+        m = HashMap(keys.data(), values.data(), keys.size(), std::max(1u, std::thread::hardware_concurrency()));
+    } else if (mode != "none") {
+        for (std::size_t i{0}; i < keys.size(); ++i) {
+            m.insert(keys[i], values[i]);
+        }
+    }
+
+    sink_int = (int)m.get_size();
+}
+
+// Lookup tables for the --peak child runs. "frozen" maps the image the parent
+// saved to frozen_image, so it measures a loaded table without its build. The
+// ordered sets ("bst", "compactbst", "stlset") ignore the values.
+static const char* frozen_image{"bench_frozen.bin"};
+
+static void load_lookup_table(const std::vector<int>& keys, const std::vector<int>& values, std::string_view mode) {
+    if (mode == "dense") {
+        DenseHashMap<> m;
+
+        for (std::size_t i{0}; i < keys.size(); ++i) {
+            m.insert(keys[i], values[i]);
+        }
+
+        sink_int = (int)m.get_size();
+    } else if (mode == "frozen") {
+        FrozenHashMap<> m;
+        m.load(frozen_image);
+        sink_int = (int)m.get_size();
+    } else if (mode == "bst" || mode == "compactbst" || mode == "stlset") {
+        BinarySearchTree bst;
+        CompactBinarySearchTree compact;
+        std::set<double> s;
+
+        for (int key : keys) {
+            if (mode == "bst") {
+                bst.insert(key);
+            } else if (mode == "compactbst") {
+                compact.insert(key);
+            } else {
+                s.insert(key);
+            }
+        }
+
+        sink_int = (int)(bst.get_size() + compact.get_size() + s.size());
+    } else if (mode == "stl") {
+        std::unordered_map<int, int> m;
+
+        for (std::size_t i{0}; i < keys.size(); ++i) {
+            m[keys[i]] = values[i];
+        }
+
+        sink_int = (int)m.size();
+    } else {
+        load_hashmap(keys, values, mode);
+    }
+}
+
+static std::vector<int> make_index_values(std::size_t n) {
+    std::vector<int> v(n);
+
+    for (std::size_t i{0}; i < n; ++i) {
+        v[i] = (int)i;
+    }
+
+    return v;
+}
+
+int main(int argc, char** argv) {
     const std::size_t N{3000000}; // Adjust as needed
+
+    if (argc == 3 && std::string_view{argv[1]} == "--peak") {
+        load_lookup_table(make_random_ints(N, -1000000, 1000000), make_index_values(N), argv[2]);
+        std::cout << self_peak_rss_kib() << "\n";
+        return 0;
+    }
+
     const int trials{5};
     auto rands_d = make_random_doubles(N, -1e6, 1e6);
     auto rands_i = make_random_ints(N, -1000000, 1000000);
@@ -185,25 +396,92 @@ int main() {
         std::cout << "[insert + get M] HashMap: " << best_my << " ms" << " | std::unordered_map: " << best_stl << " ms\n";
     }
 
-    // BinarySearchTree vs. std::set (insert + contains)
+    // HashMap vs. std::unordered_map (insert + get) by key pattern
     {
-        const std::size_t M{N / 5};
+        const std::size_t M{N};
+        const std::vector<int> seq_i{make_sequential_ints(M)};
+        const std::vector<int> strided_i{make_strided_ints(M, 64)};
+        const std::vector<int>* patterns[]{&seq_i, &strided_i, &rands_i};
+        const char* names[]{"sequential", "strided", "random"};
+
+        for (int p{0}; p < 3; ++p) {
+            const std::vector<int>& keys{*patterns[p]};
+            long long best_my{1LL << 62};
+            long long best_stl{1LL << 62};
+
+            for (int t{0}; t < trials; ++t) {
+                best_my = std::min(best_my, time_ms([&]{
+                    HashMap m;
+
+                    for (std::size_t i{0}; i < M; ++i) {
+                        m.insert(keys[i], (int)i);
+                    }
+
+                    int out{0};
+                    int hits{0};
+
+                    for (std::size_t i{0}; i < M; ++i) {
+                        if (m.get(keys[i], out)) {
+                            hits += out;
+                        }
+                    }
+
+                    sink_int = hits;
+                }));
+
+                best_stl = std::min(best_stl, time_ms([&]{
+                    std::unordered_map<int,int> m;
+
+                    for (std::size_t i{0}; i < M; ++i) {
+                        m[keys[i]] = (int)i;
+                    }
+
+                    int hits{0};
+
+                    for (std::size_t i{0}; i < M; ++i) {
+                        auto it{m.find(keys[i])};
+
+                        if (it != m.end()) {
+                            hits += it->second;
+                        }
+                    }
+
+                    sink_int = hits;
+                }));
+            }
+
+            std::cout << "[insert + get M, " << names[p] << " keys] HashMap: " << best_my << " ms"
+                      << " | std::unordered_map: " << best_stl << " ms\n";
+        }
+    }
+
+    // HashMap<std::string> vs. std::unordered_map<std::string> (insert + get by std::string_view)
+    {
+        const std::size_t M{N / 3};
+        std::vector<std::string> keys;
+        keys.reserve(M);
+
+        for (std::size_t i{0}; i < M; ++i) {
+            keys.push_back("user:" + std::to_string(rands_i[i]) + ":session");
+        }
+
         long long best_my{1LL << 62};
         long long best_stl{1LL << 62};
 
         for (int t{0}; t < trials; ++t) {
             best_my = std::min(best_my, time_ms([&]{
-                BinarySearchTree bst;
+                HashMap<std::string, int> m;
 
                 for (std::size_t i{0}; i < M; ++i) {
-                    bst.insert(rands_d[i]);
+                    m.insert_or_assign(keys[i], (int)i);
                 }
 
+                int out{0};
                 int hits{0};
 
                 for (std::size_t i{0}; i < M; ++i) {
-                    if (bst.contains(rands_d[i])) {
-                        ++hits;
+                    if (m.get(std::string_view{keys[i]}, out)) {
+                        hits += out;
                     }
                 }
 
@@ -211,17 +489,20 @@ int main() {
             }));
 
             best_stl = std::min(best_stl, time_ms([&]{
-                std::set<double> s;
+                std::unordered_map<std::string, int> m;
 
                 for (std::size_t i{0}; i < M; ++i) {
-                    s.insert(rands_d[i]);
+                    m.insert_or_assign(keys[i], (int)i);
                 }
 
                 int hits{0};
 
+                // No heterogeneous lookup before C++20, so each probe builds a std::string
                 for (std::size_t i{0}; i < M; ++i) {
-                    if (s.find(rands_d[i]) != s.end()) {
-                        ++hits;
+                    auto it{m.find(std::string{std::string_view{keys[i]}})};
+
+                    if (it != m.end()) {
+                        hits += it->second;
                     }
                 }
 
@@ -229,7 +510,1573 @@ int main() {
             }));
         }
 
-        std::cout << "[insert + contains M] BST: " << best_my << " ms" << " | std::set: " << best_stl << " ms\n";
+        std::cout << "[insert + get M / 3, string keys] HashMap: " << best_my << " ms" << " | std::unordered_map: " << best_stl << " ms\n";
+    }
+
+    // HashMap vs. std::unordered_map (worst single insert)
+    {
+        const std::size_t M{N};
+        long long worst_my{0};
+        long long worst_stl{0};
+
+        for (int t{0}; t < trials; ++t) {
+            HashMap m;
+            std::unordered_map<int,int> u;
+
+            for (std::size_t i{0}; i < M; ++i) {
+                auto start{Clock::now()};
+                m.insert(rands_i[i], (int)i);
+                auto end{Clock::now()};
+                worst_my = std::max<long long>(worst_my, std::chrono::duration_cast<std::chrono::microseconds>(end - start).count());
+            }
+
+            for (std::size_t i{0}; i < M; ++i) {
+                auto start{Clock::now()};
+                u[rands_i[i]] = (int)i;
+                auto end{Clock::now()};
+                worst_stl = std::max<long long>(worst_stl, std::chrono::duration_cast<std::chrono::microseconds>(end - start).count());
+            }
+
+            sink_int = (int)(m.get_size() + u.size());
+        }
+
+        std::cout << "[worst single insert M] HashMap: " << worst_my << " us" << " | std::unordered_map: " << worst_stl << " us\n";
+    }
+
+#ifdef HASHMAP_STATS
+    // HashMap statistics: key % capacity vs. the default hash on strided keys (insert + get)
+    {
+        const std::vector<int> keys{make_strided_ints(N / 10, 1024)};
+        HashMap<int, int, IdentityHash> identity;
+        HashMap<> mixed;
+        int out{0};
+
+        for (std::size_t i{0}; i < keys.size(); ++i) {
+            identity.insert(keys[i], (int)i);
+            mixed.insert(keys[i], (int)i);
+        }
+
+        for (int key : keys) {
+            identity.get(key, out);
+            mixed.get(key, out);
+        }
+
+        std::cout << "[stats strided N/10, key % capacity] " << identity.get_stats().to_json() << "\n";
+        std::cout << "[stats strided N/10, MixHash] " << mixed.get_stats().to_json() << "\n";
+    }
+#endif
+
+    // HashMap get vs. get_many / insert vs. insert_many (table larger than the last-level cache)
+    {
+        const std::size_t M{N * 3};
+        const std::size_t B{256};
+        std::vector<int> keys{make_random_ints(M, -2000000000, 2000000000, 777)};
+        std::vector<int> values(M);
+        std::vector<int> out(B);
+        bool found[B];
+
+        for (std::size_t i{0}; i < M; ++i) {
+            values[i] = (int)i;
+        }
+
+        long long best_one{1LL << 62};
+        long long best_many{1LL << 62};
+
+        for (int t{0}; t < trials; ++t) {
+            best_one = std::min(best_one, time_ms([&]{
+                HashMap m;
+
+                for (std::size_t i{0}; i < M; ++i) {
+                    m.insert(keys[i], values[i]);
+                }
+
+                sink_int = (int)m.get_size();
+            }));
+
+            best_many = std::min(best_many, time_ms([&]{
+                HashMap m;
+                m.insert_many(keys.data(), values.data(), M);
+                sink_int = (int)m.get_size();
+            }));
+        }
+
+        std::cout << "[insert 3N] HashMap insert: " << best_one << " ms" << " | insert_many: " << best_many << " ms\n";
+
+        HashMap m;
+        m.insert_many(keys.data(), values.data(), M);
+        std::vector<int> probes{make_random_ints(M, 0, (int)M - 1, 4242)};
+
+        for (std::size_t i{0}; i < M; ++i) {
+            probes[i] = keys[probes[i]];
+        }
+
+        best_one = 1LL << 62;
+        best_many = 1LL << 62;
+
+        for (int t{0}; t < trials; ++t) {
+            best_one = std::min(best_one, time_ms([&]{
+                int v{0};
+                int hits{0};
+
+                for (std::size_t i{0}; i < M; ++i) {
+                    if (m.get(probes[i], v)) {
+                        hits += v;
+                    }
+                }
+
+                sink_int = hits;
+            }));
+
+            best_many = std::min(best_many, time_ms([&]{
+                int hits{0};
+
+                for (std::size_t i{0}; i < M; i += B) {
+                    std::size_t count{std::min(B, M - i)};
+                    m.get_many(probes.data() + i, count, out.data(), found);
+
+                    for (std::size_t j{0}; j < count; ++j) {
+                        hits += found[j] ? out[j] : 0;
+                    }
+                }
+
+                sink_int = hits;
+            }));
+        }
+
+        std::cout << "[get 3N] HashMap get: " << best_one << " ms" << " | get_many (" << B << " keys): " << best_many << " ms\n";
+    }
+
+    // HashMap repeated insert vs. reserve vs. bulk construction (load time and peak memory)
+    {
+        const std::vector<int> values{make_index_values(N)};
+        const char* modes[]{"insert", "reserve", "bulk"};
+        const char* names[]{"insert", "reserve + insert", "bulk"};
+        long long base_kib{peak_rss_kib(argv[0], "none")};
+        std::cout << "[load N]";
+
+        for (int k{0}; k < 3; ++k) {
+            long long best{1LL << 62};
+
+            for (int t{0}; t < trials; ++t) {
+                best = std::min(best, time_ms([&]{
+                    load_hashmap(rands_i, values, modes[k]);
+                }));
+            }
+
+            std::cout << (k == 0 ? " HashMap " : " | ") << names[k] << ": " << best << " ms, "
+                      << peak_rss_kib(argv[0], modes[k]) - base_kib << " KiB peak";
+        }
+
+        std::cout << "\n";
+    }
+
+    // FrozenHashMap vs. HashMap vs. DenseHashMap vs. std::unordered_map (get, and peak memory of the loaded table)
+    {
+        const std::vector<int> values{make_index_values(N)};
+        HashMap<> my;
+        DenseHashMap<> dense;
+        std::unordered_map<int, int> stl;
+
+        for (std::size_t i{0}; i < N; ++i) {
+            my.insert(rands_i[i], values[i]);
+            dense.insert(rands_i[i], values[i]);
+            stl[rands_i[i]] = values[i];
+        }
+
+        long long build_ms{0};
+        FrozenHashMap<> frozen;
+        build_ms = time_ms([&]{
+            frozen = FrozenHashMap<>::build(my);
+        });
+        frozen.save(frozen_image);
+
+        // Looks up a shuffled copy of the keys so consecutive gets touch unrelated memory
+        std::vector<int> queries{rands_i};
+        std::shuffle(queries.begin(), queries.end(), std::mt19937{777});
+        long long best_my{1LL << 62};
+        long long best_dense{1LL << 62};
+        long long best_frozen{1LL << 62};
+        long long best_stl{1LL << 62};
+
+        for (int t{0}; t < trials; ++t) {
+            best_my = std::min(best_my, time_ms([&]{
+                int out{0};
+                int hits{0};
+
+                for (int key : queries) {
+                    if (my.get(key, out)) {
+                        hits += out;
+                    }
+                }
+
+                sink_int = hits;
+            }));
+
+            best_dense = std::min(best_dense, time_ms([&]{
+                int out{0};
+                int hits{0};
+
+                for (int key : queries) {
+                    if (dense.get(key, out)) {
+                        hits += out;
+                    }
+                }
+
+                sink_int = hits;
+            }));
+
+            best_frozen = std::min(best_frozen, time_ms([&]{
+                int out{0};
+                int hits{0};
+
+                for (int key : queries) {
+                    if (frozen.get(key, out)) {
+                        hits += out;
+                    }
+                }
+
+                sink_int = hits;
+            }));
+
+            best_stl = std::min(best_stl, time_ms([&]{
+                int hits{0};
+
+                for (int key : queries) {
+                    auto it{stl.find(key)};
+
+                    if (it != stl.end()) {
+                        hits += it->second;
+                    }
+                }
+
+                sink_int = hits;
+            }));
+        }
+
+        std::cout << "[get N shuffled] FrozenHashMap: " << best_frozen << " ms | HashMap: " << best_my << " ms"
+                  << " | DenseHashMap: " << best_dense << " ms | std::unordered_map: " << best_stl << " ms\n";
+
+        long long base_kib{peak_rss_kib(argv[0], "none")};
+        std::cout << "[table memory] FrozenHashMap: " << peak_rss_kib(argv[0], "frozen") - base_kib << " KiB ("
+                  << frozen.bits_per_key() << " bits/key of hash, built in " << build_ms << " ms)"
+                  << " | HashMap: " << peak_rss_kib(argv[0], "insert") - base_kib << " KiB"
+                  << " | DenseHashMap: " << peak_rss_kib(argv[0], "dense") - base_kib << " KiB"
+                  << " | std::unordered_map: " << peak_rss_kib(argv[0], "stl") - base_kib << " KiB\n";
+        std::remove(frozen_image);
+    }
+
+    // HashMap (iterator / for_each) vs. DenseHashMap vs. std::unordered_map (iterate, copy, clear by load factor)
+    {
+        const std::size_t M{N / 4};
+        const std::size_t spreads[]{1, 4, 16}; // Reserve room for spread * M entries to thin out the buckets
+
+        for (std::size_t spread : spreads) {
+            HashMap<> my;
+            DenseHashMap<> dense;
+            std::unordered_map<int, int> stl;
+            my.reserve(M * spread);
+            dense.reserve(M * spread);
+            stl.reserve(M * spread);
+
+            for (std::size_t i{0}; i < M; ++i) {
+                my.insert(rands_i[i], (int)i);
+                dense.insert(rands_i[i], (int)i);
+                stl[rands_i[i]] = (int)i;
+            }
+
+            long long best_it{1LL << 62};
+            long long best_fe{1LL << 62};
+            long long best_dense{1LL << 62};
+            long long best_stl{1LL << 62};
+
+            for (int t{0}; t < trials; ++t) {
+                best_it = std::min(best_it, time_ms([&]{
+                    long long sum{0};
+
+                    for (auto [key, value] : my) {
+                        sum += key + value;
+                    }
+
+                    sink_int = (int)sum;
+                }));
+
+                best_fe = std::min(best_fe, time_ms([&]{
+                    long long sum{0};
+                    my.for_each([&](const int& key, const int& value) {
+                        sum += key + value;
+                    });
+                    sink_int = (int)sum;
+                }));
+
+                best_dense = std::min(best_dense, time_ms([&]{
+                    long long sum{0};
+
+                    for (auto [key, value] : dense) {
+                        sum += key + value;
+                    }
+
+                    sink_int = (int)sum;
+                }));
+
+                best_stl = std::min(best_stl, time_ms([&]{
+                    long long sum{0};
+
+                    for (const auto& [key, value] : stl) {
+                        sum += key + value;
+                    }
+
+                    sink_int = (int)sum;
+                }));
+            }
+
+            std::cout << "[iterate N/4, load " << my.load_factor() << "] HashMap iterator: " << best_it << " ms"
+                      << " | for_each: " << best_fe << " ms | DenseHashMap: " << best_dense << " ms"
+                      << " | std::unordered_map: " << best_stl << " ms\n";
+
+            long long copy_my{1LL << 62};
+            long long copy_dense{1LL << 62};
+            long long copy_stl{1LL << 62};
+            long long clear_my{1LL << 62};
+            long long clear_dense{1LL << 62};
+            long long clear_stl{1LL << 62};
+
+            for (int t{0}; t < trials; ++t) {
+                HashMap<> my_copy;
+                DenseHashMap<> dense_copy;
+                std::unordered_map<int, int> stl_copy;
+                copy_my = std::min(copy_my, time_ms([&]{ my_copy = my; }));
+                copy_dense = std::min(copy_dense, time_ms([&]{ dense_copy = dense; }));
+                copy_stl = std::min(copy_stl, time_ms([&]{ stl_copy = stl; }));
+                clear_my = std::min(clear_my, time_ms([&]{ my_copy.clear(); }));
+                clear_dense = std::min(clear_dense, time_ms([&]{ dense_copy.clear(); }));
+                clear_stl = std::min(clear_stl, time_ms([&]{ stl_copy.clear(); }));
+            }
+
+            std::cout << "[copy N/4, load " << my.load_factor() << "] HashMap: " << copy_my << " ms"
+                      << " | DenseHashMap: " << copy_dense << " ms | std::unordered_map: " << copy_stl << " ms\n";
+            std::cout << "[clear N/4, load " << my.load_factor() << "] HashMap: " << clear_my << " ms"
+                      << " | DenseHashMap: " << clear_dense << " ms | std::unordered_map: " << clear_stl << " ms\n";
+        }
+    }
+
+    // LruCache (LRU / CLOCK) vs. std::unordered_map + std::list LRU (Zipfian trace replay, get then put on miss)
+    {
+        const std::size_t U{N / 4};
+        const std::vector<int> trace{make_zipf_ints(N, U, 0.99)};
+        const std::size_t sizes[]{U / 100, U / 10};
+
+        for (std::size_t cap : sizes) {
+            long long best_lru{1LL << 62};
+            long long best_clock{1LL << 62};
+            long long best_stl{1LL << 62};
+            double ratio_lru{0.0};
+            double ratio_clock{0.0};
+            double ratio_stl{0.0};
+
+            for (int t{0}; t < trials; ++t) {
+                best_lru = std::min(best_lru, time_ms([&]{
+                    LruCache<> c(cap);
+                    int out{0};
+
+                    for (int key : trace) {
+                        if (!c.get(key, out)) {
+                            c.put(key, key);
+                        }
+                    }
+
+                    ratio_lru = c.hit_ratio();
+                }));
+
+                best_clock = std::min(best_clock, time_ms([&]{
+                    LruCache<> c(cap, EvictionPolicy::Clock);
+                    int out{0};
+
+                    for (int key : trace) {
+                        if (!c.get(key, out)) {
+                            c.put(key, key);
+                        }
+                    }
+
+                    ratio_clock = c.hit_ratio();
+                }));
+
+                best_stl = std::min(best_stl, time_ms([&]{
+                    std::list<std::pair<int, int>> order;
+                    std::unordered_map<int, std::list<std::pair<int, int>>::iterator> where;
+                    std::size_t hits{0};
+
+                    for (int key : trace) {
+                        auto it{where.find(key)};
+
+                        if (it != where.end()) {
+                            order.splice(order.begin(), order, it->second);
+                            ++hits;
+                            continue;
+                        }
+
+                        if (order.size() == cap) {
+                            where.erase(order.back().first);
+                            order.pop_back();
+                        }
+
+                        order.emplace_front(key, key);
+                        where[key] = order.begin();
+                    }
+
+                    ratio_stl = 1.0 * hits / trace.size();
+                }));
+            }
+
+            std::cout << "[zipf 0.99 N, cache " << cap << " of " << U << "] LruCache LRU: " << best_lru << " ms (hit ratio " << ratio_lru
+                      << ") | CLOCK: " << best_clock << " ms (" << ratio_clock << ") | std::unordered_map + std::list: "
+                      << best_stl << " ms (" << ratio_stl << ")\n";
+        }
+    }
+
+    // ConcurrentHashMap vs. mutex-wrapped HashMap (read/write mixes across thread counts)
+    {
+        const std::size_t ops{N};
+        const int read_pcts[]{95, 50, 5};
+        const int thread_counts[]{1, 2, 4, 8, 16, 32};
+
+        for (int read_pct : read_pcts) {
+            for (int threads : thread_counts) {
+                std::size_t per_thread{ops / threads};
+                long long best_my{1LL << 62};
+                long long best_lock{1LL << 62};
+
+                // Each thread runs its own key stream; key i is a read when i % 100 < read_pct
+                auto run{[&](auto&& body) {
+                    return time_ms([&]{
+                        std::vector<std::thread> pool;
+                        std::vector<int> results(threads);
+
+                        for (int t{0}; t < threads; ++t) {
+                            pool.emplace_back([&, t]{
+                                const int* keys{rands_i.data() + (t * per_thread) % (N - per_thread + 1)};
+                                results[t] = body(keys, per_thread);
+                            });
+                        }
+
+                        for (std::thread& th : pool) {
+                            th.join();
+                        }
+
+                        sink_int = results[0];
+                    });
+                }};
+
+                for (int t{0}; t < trials; ++t) {
+                    ConcurrentHashMap<> cm;
+                    HashMap m;
+                    std::mutex m_lock;
+
+                    best_my = std::min(best_my, run([&](const int* keys, std::size_t n){
+                        int v{0};
+                        int hits{0};
+
+                        for (std::size_t i{0}; i < n; ++i) {
+                            if ((int)(i % 100) < read_pct) {
+                                hits += cm.get(keys[i], v) ? v : 0;
+                            } else {
+                                cm.insert(keys[i], (int)i);
+                            }
+                        }
+
+                        return hits;
+                    }));
+
+                    best_lock = std::min(best_lock, run([&](const int* keys, std::size_t n){
+                        int v{0};
+                        int hits{0};
+
+                        for (std::size_t i{0}; i < n; ++i) {
+                            std::lock_guard<std::mutex> guard{m_lock};
+
+                            if ((int)(i % 100) < read_pct) {
+                                hits += m.get(keys[i], v) ? v : 0;
+                            } else {
+                                m.insert(keys[i], (int)i);
+                            }
+                        }
+
+                        return hits;
+                    }));
+                }
+
+                std::cout << "[" << read_pct << "/" << 100 - read_pct << " read/write N, " << threads << " threads] ConcurrentHashMap: "
+                          << best_my << " ms" << " | HashMap + mutex: " << best_lock << " ms\n";
+            }
+        }
+    }
+
+    // LockFreeHashMap vs. ConcurrentHashMap (get throughput across reader threads while one writer runs)
+    {
+        const std::size_t M{N / 2};
+        const int reader_counts[]{1, 2, 4, 8, 16};
+
+        // Readers each perform M gets; the writer churns keys outside the read set until they finish
+        auto run{[&](auto& map, int readers) {
+            std::atomic<bool> done{false};
+            std::thread writer{[&]{
+                for (int k{0}; !done.load(std::memory_order_relaxed); ++k) {
+                    map.insert(2000000 + k % 100000, k);
+                    map.remove(2000000 + (k + 50000) % 100000);
+                }
+            }};
+
+            long long ms{time_ms([&]{
+                std::vector<std::thread> pool;
+                std::vector<int> results(readers);
+
+                for (int t{0}; t < readers; ++t) {
+                    pool.emplace_back([&, t]{
+                        int v{0};
+                        int hits{0};
+
+                        for (std::size_t i{0}; i < M; ++i) {
+                            hits += map.get(rands_i[(i + t * 7919) % M], v) ? v : 0;
+                        }
+
+                        results[t] = hits;
+                    });
+                }
+
+                for (std::thread& th : pool) {
+                    th.join();
+                }
+
+                sink_int = results[0];
+            })};
+
+            done.store(true);
+            writer.join();
+
+            return ms;
+        }};
+
+        for (int readers : reader_counts) {
+            long long best_my{1LL << 62};
+            long long best_sharded{1LL << 62};
+
+            for (int t{0}; t < trials; ++t) {
+                LockFreeHashMap<> lf;
+                ConcurrentHashMap<> cm;
+
+                for (std::size_t i{0}; i < M; ++i) {
+                    lf.insert(rands_i[i], (int)i);
+                    cm.insert(rands_i[i], (int)i);
+                }
+
+                best_my = std::min(best_my, run(lf, readers));
+                best_sharded = std::min(best_sharded, run(cm, readers));
+            }
+
+            std::cout << "[get M x " << readers << " readers + 1 writer] LockFreeHashMap: " << best_my << " ms ("
+                      << (long long)M * readers / std::max(best_my, 1LL) << " gets/ms)"
+                      << " | ConcurrentHashMap: " << best_sharded << " ms ("
+                      << (long long)M * readers / std::max(best_sharded, 1LL) << " gets/ms)\n";
+        }
+    }
+
+    // BinarySearchTree vs. std::set (insert + contains)
+    {
+        const std::size_t M{N / 5};
+        long long best_my{1LL << 62};
+        long long best_stl{1LL << 62};
+
+        for (int t{0}; t < trials; ++t) {
+            best_my = std::min(best_my, time_ms([&]{
+                BinarySearchTree bst;
+
+                for (std::size_t i{0}; i < M; ++i) {
+                    bst.insert(rands_d[i]);
+                }
+
+                int hits{0};
+
+                for (std::size_t i{0}; i < M; ++i) {
+                    if (bst.contains(rands_d[i])) {
+                        ++hits;
+                    }
+                }
+
+                sink_int = hits;
+            }));
+
+            best_stl = std::min(best_stl, time_ms([&]{
+                std::set<double> s;
+
+                for (std::size_t i{0}; i < M; ++i) {
+                    s.insert(rands_d[i]);
+                }
+
+                int hits{0};
+
+                for (std::size_t i{0}; i < M; ++i) {
+                    if (s.find(rands_d[i]) != s.end()) {
+                        ++hits;
+                    }
+                }
+
+                sink_int = hits;
+            }));
+        }
+
+        std::cout << "[insert + contains M] BST: " << best_my << " ms" << " | std::set: " << best_stl << " ms\n";
+    }
+
+    // AVLTree vs. BinarySearchTree vs. std::set on random, ascending and descending keys (insert + contains).
+    // Ordered input degrades BinarySearchTree into a list, so it only gets a small prefix of the keys.
+    {
+        const std::size_t M{N / 5};
+        const std::size_t small{M / 300};
+        const char* names[3]{"random", "ascending", "descending"};
+
+        for (int order{0}; order < 3; ++order) {
+            std::vector<double> keys(M);
+
+            for (std::size_t i{0}; i < M; ++i) {
+                keys[i] = order == 0 ? rands_d[i] : order == 1 ? double(i) : double(M - i);
+            }
+
+            auto run{[&](auto& tree, std::size_t count) {
+                for (std::size_t i{0}; i < count; ++i) {
+                    tree.insert(keys[i]);
+                }
+
+                int hits{0};
+
+                for (std::size_t i{0}; i < count; ++i) {
+                    if (tree.contains(keys[i])) {
+                        ++hits;
+                    }
+                }
+
+                sink_int = hits;
+            }};
+
+            long long best_avl{1LL << 62};
+            long long best_bst{1LL << 62};
+            long long best_stl{1LL << 62};
+            std::size_t avl_height{0};
+            std::size_t bst_height{0};
+
+            for (int t{0}; t < trials; ++t) {
+                best_avl = std::min(best_avl, time_ms([&]{
+                    AVLTree avl;
+                    run(avl, M);
+                    avl_height = avl.height();
+                }));
+
+                best_bst = std::min(best_bst, time_ms([&]{
+                    BinarySearchTree bst;
+                    run(bst, small);
+                    bst_height = bst.height();
+                }));
+
+                best_stl = std::min(best_stl, time_ms([&]{
+                    std::set<double> s;
+
+                    for (std::size_t i{0}; i < M; ++i) {
+                        s.insert(keys[i]);
+                    }
+
+                    int hits{0};
+
+                    for (std::size_t i{0}; i < M; ++i) {
+                        if (s.find(keys[i]) != s.end()) {
+                            ++hits;
+                        }
+                    }
+
+                    sink_int = hits;
+                }));
+            }
+
+            std::cout << "[insert + contains M, " << names[order] << "] AVLTree: " << best_avl << " ms (height " << avl_height << ")"
+                      << " | std::set: " << best_stl << " ms"
+                      << " | BST on M/300: " << best_bst << " ms (height " << bst_height << ")\n";
+        }
+    }
+
+    // BPlusTree vs. std::set at growing sizes: random inserts, bulk build, point lookups and
+    // range scans of about 100 keys. Raise N to reach the sizes where both are memory-bound.
+    for (std::size_t M : {N / 3, N}) {
+        const std::size_t scans{M / 10};
+        const double width{100 * 2e6 / M};
+        long long best_insert_my{1LL << 62};
+        long long best_insert_stl{1LL << 62};
+        long long best_bulk{1LL << 62};
+        long long best_get_my{1LL << 62};
+        long long best_get_stl{1LL << 62};
+        long long best_scan_my{1LL << 62};
+        long long best_scan_stl{1LL << 62};
+        BPlusTree tree;
+        std::set<double> s;
+
+        for (int t{0}; t < trials; ++t) {
+            tree.clear();
+            s.clear();
+
+            best_insert_my = std::min(best_insert_my, time_ms([&]{
+                for (std::size_t i{0}; i < M; ++i) {
+                    tree.insert(rands_d[i]);
+                }
+            }));
+
+            best_insert_stl = std::min(best_insert_stl, time_ms([&]{
+                for (std::size_t i{0}; i < M; ++i) {
+                    s.insert(rands_d[i]);
+                }
+            }));
+
+            best_bulk = std::min(best_bulk, time_ms([&]{
+                BPlusTree bulk(rands_d.data(), M);
+                sink_int = static_cast<int>(bulk.get_size());
+            }));
+
+            best_get_my = std::min(best_get_my, time_ms([&]{
+                int hits{0};
+
+                for (std::size_t i{0}; i < M; ++i) {
+                    hits += tree.contains(rands_d[M - 1 - i]);
+                }
+
+                sink_int = hits;
+            }));
+
+            best_get_stl = std::min(best_get_stl, time_ms([&]{
+                int hits{0};
+
+                for (std::size_t i{0}; i < M; ++i) {
+                    hits += s.find(rands_d[M - 1 - i]) != s.end();
+                }
+
+                sink_int = hits;
+            }));
+
+            best_scan_my = std::min(best_scan_my, time_ms([&]{
+                double sum{0.0};
+
+                for (std::size_t i{0}; i < scans; ++i) {
+                    tree.for_each_in_range(rands_d[i], rands_d[i] + width, [&](double k) { sum += k; });
+                }
+
+                sink_int = static_cast<int>(sum);
+            }));
+
+            best_scan_stl = std::min(best_scan_stl, time_ms([&]{
+                double sum{0.0};
+
+                for (std::size_t i{0}; i < scans; ++i) {
+                    for (auto it{s.lower_bound(rands_d[i])}; it != s.end() && *it < rands_d[i] + width; ++it) {
+                        sum += *it;
+                    }
+                }
+
+                sink_int = static_cast<int>(sum);
+            }));
+        }
+
+        std::cout << "[" << M << " keys] BPlusTree insert: " << best_insert_my << " ms | std::set insert: " << best_insert_stl << " ms"
+                  << " | BPlusTree bulk build: " << best_bulk << " ms\n";
+        std::cout << "[" << M << " keys] BPlusTree contains: " << best_get_my << " ms | std::set find: " << best_get_stl << " ms\n";
+        std::cout << "[" << M << " keys, " << scans << " scans of ~100] BPlusTree: " << best_scan_my << " ms"
+                  << " | std::set: " << best_scan_stl << " ms\n";
+    }
+
+    // FrozenSet vs. BinarySearchTree vs. std::set vs. std::lower_bound on a sorted array
+    {
+        const std::size_t M{N / 5};
+        BinarySearchTree bst;
+        std::set<double> s;
+
+        for (std::size_t i{0}; i < M; ++i) {
+            bst.insert(rands_d[i]);
+            s.insert(rands_d[i]);
+        }
+
+        std::vector<double> sorted(s.begin(), s.end());
+        long long best_build{1LL << 62};
+        long long best_frozen{1LL << 62};
+        long long best_bst{1LL << 62};
+        long long best_stl{1LL << 62};
+        long long best_array{1LL << 62};
+        long long best_frozen_lb{1LL << 62};
+        long long best_stl_lb{1LL << 62};
+        long long best_array_lb{1LL << 62};
+        FrozenSet frozen;
+
+        for (int t{0}; t < trials; ++t) {
+            best_build = std::min(best_build, time_ms([&]{
+                frozen = FrozenSet::build(bst);
+            }));
+
+            auto count_hits{[&](auto&& contains) {
+                return time_ms([&]{
+                    int hits{0};
+
+                    for (std::size_t i{0}; i < M; ++i) {
+                        hits += contains(rands_d[M - 1 - i]);
+                    }
+
+                    sink_int = hits;
+                });
+            }};
+
+            best_frozen = std::min(best_frozen, count_hits([&](double k) { return frozen.contains(k); }));
+            best_bst = std::min(best_bst, count_hits([&](double k) { return bst.contains(k); }));
+            best_stl = std::min(best_stl, count_hits([&](double k) { return s.find(k) != s.end(); }));
+            best_array = std::min(best_array, count_hits([&](double k) { return std::binary_search(sorted.begin(), sorted.end(), k); }));
+
+            // Probes between keys, summing each probe's lower bound
+            auto sum_bounds{[&](auto&& lower_bound) {
+                return time_ms([&]{
+                    double sum{0.0};
+
+                    for (std::size_t i{0}; i < M; ++i) {
+                        sum += lower_bound(rands_d[M + i]);
+                    }
+
+                    sink_int = static_cast<int>(sum);
+                });
+            }};
+
+            best_frozen_lb = std::min(best_frozen_lb, sum_bounds([&](double k) {
+                double found{0.0};
+                frozen.lower_bound(k, found);
+                return found;
+            }));
+            best_stl_lb = std::min(best_stl_lb, sum_bounds([&](double k) {
+                auto it{s.lower_bound(k)};
+                return it == s.end() ? 0.0 : *it;
+            }));
+            best_array_lb = std::min(best_array_lb, sum_bounds([&](double k) {
+                auto it{std::lower_bound(sorted.begin(), sorted.end(), k)};
+                return it == sorted.end() ? 0.0 : *it;
+            }));
+        }
+
+        std::cout << "[contains M] FrozenSet: " << best_frozen << " ms (build " << best_build << " ms)"
+                  << " | BST: " << best_bst << " ms | std::set: " << best_stl << " ms"
+                  << " | sorted array binary_search: " << best_array << " ms\n";
+        std::cout << "[lower_bound M] FrozenSet: " << best_frozen_lb << " ms | std::set: " << best_stl_lb << " ms"
+                  << " | sorted array std::lower_bound: " << best_array_lb << " ms\n";
+    }
+
+    // BinarySearchTree copy, in-order walk, height and clear on a balanced (random keys) and a
+    // degenerate (ascending keys) tree. Building the degenerate tree is quadratic, so it is smaller.
+    {
+        const std::size_t sizes[2]{N / 5, N / 150};
+        const char* names[2]{"balanced", "degenerate"};
+
+        for (int shape{0}; shape < 2; ++shape) {
+            BinarySearchTree source;
+
+            for (std::size_t i{0}; i < sizes[shape]; ++i) {
+                source.insert(shape == 0 ? rands_d[i] : double(i));
+            }
+
+            long long best_copy{1LL << 62};
+            long long best_walk{1LL << 62};
+            long long best_height{1LL << 62};
+            long long best_clear{1LL << 62};
+
+            for (int t{0}; t < trials; ++t) {
+                BinarySearchTree copy;
+
+                best_copy = std::min(best_copy, time_ms([&]{
+                    copy = source;
+                }));
+
+                best_walk = std::min(best_walk, time_ms([&]{
+                    sink_int = copy.is_valid_bst();
+                }));
+
+                best_height = std::min(best_height, time_ms([&]{
+                    sink_int = static_cast<int>(copy.height());
+                }));
+
+                best_clear = std::min(best_clear, time_ms([&]{
+                    copy.clear();
+                }));
+            }
+
+            std::cout << "[BST " << names[shape] << ", " << sizes[shape] << " nodes] copy: " << best_copy << " ms"
+                      << " | in-order walk: " << best_walk << " ms | height: " << best_height << " ms"
+                      << " | clear: " << best_clear << " ms\n";
+        }
+    }
+
+    // Full in-order export: BinarySearchTree to_array / for_each_inorder / iterators vs. std::set iteration
+    {
+        const std::size_t M{N / 5};
+        BinarySearchTree bst;
+        std::set<double> s;
+
+        for (std::size_t i{0}; i < M; ++i) {
+            bst.insert(rands_d[i]);
+            s.insert(rands_d[i]);
+        }
+
+        long long best_array{1LL << 62};
+        long long best_visit{1LL << 62};
+        long long best_iter{1LL << 62};
+        long long best_stl{1LL << 62};
+        DynamicArray out;
+
+        for (int t{0}; t < trials; ++t) {
+            best_array = std::min(best_array, time_ms([&]{
+                bst.to_array(out);
+                sink_int = static_cast<int>(out.get_size());
+            }));
+
+            best_visit = std::min(best_visit, time_ms([&]{
+                double sum{0.0};
+                bst.for_each_inorder([&sum](double k) { sum += k; });
+                sink_int = static_cast<int>(sum);
+            }));
+
+            best_iter = std::min(best_iter, time_ms([&]{
+                double sum{0.0};
+
+                for (double k : bst) {
+                    sum += k;
+                }
+
+                sink_int = static_cast<int>(sum);
+            }));
+
+            best_stl = std::min(best_stl, time_ms([&]{
+                double sum{0.0};
+
+                for (double k : s) {
+                    sum += k;
+                }
+
+                sink_int = static_cast<int>(sum);
+            }));
+        }
+
+        std::cout << "[in-order export M] BST to_array: " << best_array << " ms | for_each_inorder: " << best_visit << " ms"
+                  << " | iterators: " << best_iter << " ms | std::set iteration: " << best_stl << " ms\n";
+    }
+
+    // Mixed inserts and order-statistic queries (rank, select, count_range): BinarySearchTree vs. a
+    // sorted DynamicArray with binary search, whose inserts shift the tail
+    {
+        const std::size_t M{N / 30};
+        long long best_my{1LL << 62};
+        long long best_array{1LL << 62};
+
+        for (int t{0}; t < trials; ++t) {
+            best_my = std::min(best_my, time_ms([&]{
+                BinarySearchTree bst;
+                double sum{0.0};
+
+                for (std::size_t i{0}; i < M; ++i) {
+                    bst.insert(rands_d[i]);
+                    sum += bst.rank(rands_d[M + i]);
+                    sum += bst.select(i / 2);
+                    sum += bst.count_range(rands_d[M + i], rands_d[M + i] + 1000.0);
+                }
+
+                sink_int = static_cast<int>(sum);
+            }));
+
+            best_array = std::min(best_array, time_ms([&]{
+                DynamicArray sorted;
+                auto rank{[&sorted](double value) {
+                    const double* first{&sorted[0]};
+                    return static_cast<std::size_t>(std::lower_bound(first, first + sorted.get_size(), value) - first);
+                }};
+                double sum{0.0};
+
+                for (std::size_t i{0}; i < M; ++i) {
+                    std::size_t pos{sorted.empty() ? 0 : rank(rands_d[i])};
+
+                    if (pos == sorted.get_size() || sorted[pos] != rands_d[i]) {
+                        sorted.insert(pos, rands_d[i]);
+                    }
+
+                    sum += rank(rands_d[M + i]);
+                    sum += sorted[i / 2];
+                    sum += rank(rands_d[M + i] + 1000.0) - rank(rands_d[M + i]);
+                }
+
+                sink_int = static_cast<int>(sum);
+            }));
+        }
+
+        std::cout << "[insert + rank + select + count_range M/30] BST: " << best_my << " ms"
+                  << " | sorted DynamicArray: " << best_array << " ms\n";
+    }
+
+    // BinarySearchTree bulk load (build_from_unsorted, one and four threads) vs. incremental
+    // inserts of the same random keys, then contains on each resulting tree
+    {
+        const std::size_t M{N / 5};
+        long long best_insert{1LL << 62};
+        long long best_bulk{1LL << 62};
+        long long best_bulk_parallel{1LL << 62};
+        long long best_get_insert{1LL << 62};
+        long long best_get_bulk{1LL << 62};
+        std::size_t insert_height{0};
+        std::size_t bulk_height{0};
+
+        for (int t{0}; t < trials; ++t) {
+            BinarySearchTree inserted;
+            BinarySearchTree bulk;
+
+            best_insert = std::min(best_insert, time_ms([&]{
+                for (std::size_t i{0}; i < M; ++i) {
+                    inserted.insert(rands_d[i]);
+                }
+            }));
+
+            best_bulk_parallel = std::min(best_bulk_parallel, time_ms([&]{
+                bulk = BinarySearchTree::build_from_unsorted(rands_d.data(), M, 4);
+            }));
+
+            best_bulk = std::min(best_bulk, time_ms([&]{
+                bulk = BinarySearchTree::build_from_unsorted(rands_d.data(), M);
+            }));
+
+            auto count_hits{[&](const BinarySearchTree& tree) {
+                return time_ms([&]{
+                    int hits{0};
+
+                    for (std::size_t i{0}; i < M; ++i) {
+                        hits += tree.contains(rands_d[M - 1 - i]);
+                    }
+
+                    sink_int = hits;
+                });
+            }};
+
+            best_get_insert = std::min(best_get_insert, count_hits(inserted));
+            best_get_bulk = std::min(best_get_bulk, count_hits(bulk));
+            insert_height = inserted.height();
+            bulk_height = bulk.height();
+        }
+
+        std::cout << "[load M] BST inserts: " << best_insert << " ms (height " << insert_height << ")"
+                  << " | build_from_unsorted: " << best_bulk << " ms (height " << bulk_height << ")"
+                  << " | with 4 threads: " << best_bulk_parallel << " ms\n";
+        std::cout << "[contains M after load] BST inserts: " << best_get_insert << " ms"
+                  << " | build_from_unsorted: " << best_get_bulk << " ms\n";
+    }
+
+    // CompactBinarySearchTree vs. BinarySearchTree vs. std::set (contains, and peak memory per key)
+    {
+        const std::size_t M{N / 5};
+        BinarySearchTree bst;
+        CompactBinarySearchTree compact;
+        std::set<double> s;
+
+        for (std::size_t i{0}; i < M; ++i) {
+            bst.insert(rands_d[i]);
+            compact.insert(rands_d[i]);
+            s.insert(rands_d[i]);
+        }
+
+        long long best_my{1LL << 62};
+        long long best_compact{1LL << 62};
+        long long best_stl{1LL << 62};
+
+        for (int t{0}; t < trials; ++t) {
+            auto count_hits{[&](auto&& contains) {
+                return time_ms([&]{
+                    int hits{0};
+
+                    for (std::size_t i{0}; i < M; ++i) {
+                        hits += contains(rands_d[M - 1 - i]);
+                    }
+
+                    sink_int = hits;
+                });
+            }};
+
+            best_my = std::min(best_my, count_hits([&](double k) { return bst.contains(k); }));
+            best_compact = std::min(best_compact, count_hits([&](double k) { return compact.contains(k); }));
+            best_stl = std::min(best_stl, count_hits([&](double k) { return s.find(k) != s.end(); }));
+        }
+
+        std::vector<int> unique_keys(rands_i);
+        std::sort(unique_keys.begin(), unique_keys.end());
+        double keys{static_cast<double>(std::unique(unique_keys.begin(), unique_keys.end()) - unique_keys.begin())};
+        long long base_kib{peak_rss_kib(argv[0], "none")};
+        std::cout << "[contains M] CompactBST: " << best_compact << " ms | BST: " << best_my << " ms | std::set: " << best_stl << " ms\n";
+        std::cout << "[bytes per key] CompactBST: " << (peak_rss_kib(argv[0], "compactbst") - base_kib) * 1024 / keys
+                  << " | BST: " << (peak_rss_kib(argv[0], "bst") - base_kib) * 1024 / keys
+                  << " | std::set: " << (peak_rss_kib(argv[0], "stlset") - base_kib) * 1024 / keys << "\n";
+    }
+
+    // ConcurrentOrderedSet vs. mutex-wrapped BinarySearchTree (mixed contains / insert / erase across
+    // thread counts on a pre-filled set; writes alternate between inserting and erasing)
+    {
+        const std::size_t M{N / 5};
+        const std::size_t ops{N};
+        const int read_pcts[]{90, 50};
+        const int thread_counts[]{1, 2, 4, 8, 16};
+
+        for (int read_pct : read_pcts) {
+            for (int threads : thread_counts) {
+                std::size_t per_thread{ops / threads};
+                long long best_my{1LL << 62};
+                long long best_lock{1LL << 62};
+
+                auto run{[&](auto&& body) {
+                    return time_ms([&]{
+                        std::vector<std::thread> pool;
+                        std::vector<int> results(threads);
+
+                        for (int t{0}; t < threads; ++t) {
+                            pool.emplace_back([&, t]{
+                                const double* keys{rands_d.data() + (t * per_thread) % (N - per_thread + 1)};
+                                results[t] = body(keys, per_thread);
+                            });
+                        }
+
+                        for (std::thread& th : pool) {
+                            th.join();
+                        }
+
+                        sink_int = results[0];
+                    });
+                }};
+
+                for (int t{0}; t < trials; ++t) {
+                    ConcurrentOrderedSet cs;
+                    BinarySearchTree bst;
+                    std::mutex bst_lock;
+
+                    for (std::size_t i{0}; i < M; ++i) {
+                        cs.insert(rands_d[i]);
+                        bst.insert(rands_d[i]);
+                    }
+
+                    best_my = std::min(best_my, run([&](const double* keys, std::size_t n){
+                        int hits{0};
+
+                        for (std::size_t i{0}; i < n; ++i) {
+                            int slot{(int)(i % 100)};
+
+                            if (slot < read_pct) {
+                                hits += cs.contains(keys[i]);
+                            } else if (slot % 2 == 0) {
+                                cs.insert(keys[i]);
+                            } else {
+                                cs.erase(keys[i]);
+                            }
+                        }
+
+                        return hits;
+                    }));
+
+                    best_lock = std::min(best_lock, run([&](const double* keys, std::size_t n){
+                        int hits{0};
+
+                        for (std::size_t i{0}; i < n; ++i) {
+                            int slot{(int)(i % 100)};
+                            std::lock_guard<std::mutex> guard{bst_lock};
+
+                            if (slot < read_pct) {
+                                hits += bst.contains(keys[i]);
+                            } else if (slot % 2 == 0) {
+                                bst.insert(keys[i]);
+                            } else {
+                                bst.erase(keys[i]);
+                            }
+                        }
+
+                        return hits;
+                    }));
+                }
+
+                std::cout << "[" << read_pct << "/" << 100 - read_pct << " read/write N on M keys, " << threads << " threads] ConcurrentOrderedSet: "
+                          << best_my << " ms" << " | BST + mutex: " << best_lock << " ms\n";
+            }
+        }
+    }
+
+    // PersistentBinarySearchTree vs. BinarySearchTree: cost of a snapshot (O(1) share vs. a deep copy),
+    // and of insert + erase with no snapshot alive vs. a fresh snapshot held across every 1000 updates
+    {
+        const std::size_t M{N / 5};
+        const std::size_t updates{M / 2};
+        const std::size_t snapshots{100};
+        BinarySearchTree bst;
+
+        for (std::size_t i{0}; i < M; ++i) {
+            bst.insert(rands_d[i]);
+        }
+
+        PersistentBinarySearchTree persistent{bst};
+        long long best_copy{1LL << 62};
+        long long best_snapshot{1LL << 62};
+        long long best_bst{1LL << 62};
+        long long best_unshared{1LL << 62};
+        long long best_shared{1LL << 62};
+
+        for (int t{0}; t < trials; ++t) {
+            best_copy = std::min(best_copy, time_ms([&]{
+                for (std::size_t i{0}; i < snapshots / 10; ++i) {
+                    BinarySearchTree copy{bst};
+                    sink_int = (int)copy.get_size();
+                }
+            }) * 10);
+
+            best_snapshot = std::min(best_snapshot, time_ms([&]{
+                for (std::size_t i{0}; i < snapshots; ++i) {
+                    PersistentBinarySearchTree copy{persistent.snapshot()};
+                    sink_int = (int)copy.get_size();
+                }
+            }));
+
+            // Each round inserts keys that are absent and erases them again, so the trees end as they began
+            auto churn{[&](auto& tree, auto&& before_batch) {
+                return time_ms([&]{
+                    for (std::size_t i{0}; i < updates; ++i) {
+                        if (i % 1000 == 0) {
+                            before_batch();
+                        }
+
+                        tree.insert(rands_d[i] + 0.5);
+                    }
+
+                    for (std::size_t i{0}; i < updates; ++i) {
+                        tree.erase(rands_d[i] + 0.5);
+                    }
+                });
+            }};
+
+            best_bst = std::min(best_bst, churn(bst, []{}));
+            best_unshared = std::min(best_unshared, churn(persistent, []{}));
+            PersistentBinarySearchTree held;
+            best_shared = std::min(best_shared, churn(persistent, [&]{ held = persistent.snapshot(); }));
+        }
+
+        std::cout << "[" << snapshots << " snapshots of M keys] PersistentBST snapshot: " << best_snapshot
+                  << " ms | BST copy constructor: " << best_copy << " ms\n";
+        std::cout << "[insert + erase M/2] PersistentBST, no snapshots: " << best_unshared << " ms | PersistentBST, snapshot per 1000 updates: "
+                  << best_shared << " ms | BST: " << best_bst << " ms\n";
+    }
+
+    // AVLTree join-based union / intersection / difference (one and four threads) vs. std::set_union /
+    // std::set_intersection / std::set_difference on sorted vectors, for two equal sets and for a set
+    // 1/100th the size of the other. Keys are whole numbers so that the sets overlap.
+    {
+        const std::size_t M{N / 5};
+        const std::size_t smalls[]{M, M / 100};
+
+        for (std::size_t m : smalls) {
+            AVLTree a;
+            AVLTree b;
+            std::vector<double> va;
+            std::vector<double> vb;
+
+            for (std::size_t i{0}; i < m; ++i) {
+                a.insert(std::floor(rands_d[i]));
+                va.push_back(std::floor(rands_d[i]));
+            }
+
+            for (std::size_t i{M}; i < 2 * M; ++i) {
+                b.insert(std::floor(rands_d[i]));
+                vb.push_back(std::floor(rands_d[i]));
+            }
+
+            for (std::vector<double>* v : {&va, &vb}) {
+                std::sort(v->begin(), v->end());
+                v->erase(std::unique(v->begin(), v->end()), v->end());
+            }
+
+            const char* names[]{"union", "intersection", "difference"};
+
+            for (int op{0}; op < 3; ++op) {
+                long long best_one{1LL << 62};
+                long long best_four{1LL << 62};
+                long long best_stl{1LL << 62};
+
+                for (int t{0}; t < trials; ++t) {
+                    for (unsigned threads : {1u, 4u}) {
+                        AVLTree result{a};
+                        long long ms{time_ms([&]{
+                            if (op == 0) {
+                                result.union_with(b, threads);
+                            } else if (op == 1) {
+                                result.intersect_with(b, threads);
+                            } else {
+                                result.difference_with(b, threads);
+                            }
+
+                            sink_int = (int)result.get_size();
+                        })};
+                        (threads == 1 ? best_one : best_four) = std::min(threads == 1 ? best_one : best_four, ms);
+                    }
+
+                    best_stl = std::min(best_stl, time_ms([&]{
+                        std::vector<double> out;
+
+                        if (op == 0) {
+                            std::set_union(va.begin(), va.end(), vb.begin(), vb.end(), std::back_inserter(out));
+                        } else if (op == 1) {
+                            std::set_intersection(va.begin(), va.end(), vb.begin(), vb.end(), std::back_inserter(out));
+                        } else {
+                            std::set_difference(va.begin(), va.end(), vb.begin(), vb.end(), std::back_inserter(out));
+                        }
+
+                        sink_int = (int)out.size();
+                    }));
+                }
+
+                std::cout << "[" << names[op] << ", " << (m == M ? "M with M" : "M/100 with M") << "] AVLTree: " << best_one
+                          << " ms | AVLTree, 4 threads: " << best_four << " ms | std::" << (op == 0 ? "set_union" : op == 1 ? "set_intersection" : "set_difference")
+                          << " on sorted vectors: " << best_stl << " ms\n";
+            }
+        }
+    }
+
+    // BinarySearchTree in Splay mode (every access, and only below depth 12) vs. static BinarySearchTree
+    // vs. AVLTree vs. std::set under Zipfian lookups of varying skew. The trees hold every key of the
+    // universe, inserted in random order.
+    {
+        const std::size_t U{N / 10};
+        const double skews[]{0.6, 0.99, 1.2};
+        std::vector<double> keys(U);
+
+        for (std::size_t r{0}; r < U; ++r) {
+            keys[r] = (double)(int)(r * 2654435761u);
+        }
+
+        std::shuffle(keys.begin(), keys.end(), std::mt19937{7});
+        BinarySearchTree bst;
+        AVLTree avl;
+        std::set<double> s;
+
+        for (double k : keys) {
+            bst.insert(k);
+            avl.insert(k);
+            s.insert(k);
+        }
+
+        for (double skew : skews) {
+            const std::vector<int> trace{make_zipf_ints(N, U, skew)};
+            long long best_static{1LL << 62};
+            long long best_splay{1LL << 62};
+            long long best_lazy{1LL << 62};
+            long long best_avl{1LL << 62};
+            long long best_stl{1LL << 62};
+
+            auto count_hits{[&](auto&& lookup) {
+                return time_ms([&]{
+                    int hits{0};
+
+                    for (int k : trace) {
+                        hits += lookup((double)k);
+                    }
+
+                    sink_int = hits;
+                });
+            }};
+
+            for (int t{0}; t < trials; ++t) {
+                BinarySearchTree splay{bst};
+                splay.set_access_mode(BinarySearchTree::AccessMode::Splay);
+                BinarySearchTree lazy{bst};
+                lazy.set_access_mode(BinarySearchTree::AccessMode::Splay, 12);
+                best_static = std::min(best_static, count_hits([&](double k) { return bst.contains(k); }));
+                best_splay = std::min(best_splay, count_hits([&](double k) { return splay.access(k); }));
+                best_lazy = std::min(best_lazy, count_hits([&](double k) { return lazy.access(k); }));
+                best_avl = std::min(best_avl, count_hits([&](double k) { return avl.contains(k); }));
+                best_stl = std::min(best_stl, count_hits([&](double k) { return s.find(k) != s.end(); }));
+            }
+
+            std::cout << "[zipf " << skew << " N lookups, " << U << " keys] BST splay: " << best_splay << " ms | BST splay below depth 12: "
+                      << best_lazy << " ms | BST: " << best_static << " ms | AVLTree: " << best_avl << " ms | std::set: " << best_stl << " ms\n";
+        }
+    }
+
+    // FlatSet vs. BinarySearchTree vs. std::set (vs. std::flat_set where the library has it) at small
+    // and medium sizes: build by single inserts and by bulk construction, then N contains (half misses)
+    {
+        const std::size_t sizes[]{1000, 10000, 100000};
+
+        for (std::size_t M : sizes) {
+            long long best_flat_insert{1LL << 62};
+            long long best_flat_bulk{1LL << 62};
+            long long best_bst_insert{1LL << 62};
+            long long best_stl_insert{1LL << 62};
+            long long best_flat{1LL << 62};
+            long long best_bst{1LL << 62};
+            long long best_stl{1LL << 62};
+#if defined(__cpp_lib_flat_set)
+            long long best_stl_flat{1LL << 62};
+#endif
+
+            for (int t{0}; t < trials; ++t) {
+                FlatSet flat;
+                BinarySearchTree bst;
+                std::set<double> s;
+
+                best_flat_insert = std::min(best_flat_insert, time_ms([&]{
+                    for (std::size_t i{0}; i < M; ++i) {
+                        flat.insert(rands_d[i]);
+                    }
+
+                    flat.flush();
+                }));
+
+                best_flat_bulk = std::min(best_flat_bulk, time_ms([&]{
+                    FlatSet bulk{rands_d.data(), M};
+                    sink_int = (int)bulk.get_size();
+                }));
+
+                best_bst_insert = std::min(best_bst_insert, time_ms([&]{
+                    for (std::size_t i{0}; i < M; ++i) {
+                        bst.insert(rands_d[i]);
+                    }
+                }));
+
+                best_stl_insert = std::min(best_stl_insert, time_ms([&]{
+                    for (std::size_t i{0}; i < M; ++i) {
+                        s.insert(rands_d[i]);
+                    }
+                }));
+
+                // Every second query is a key that was inserted, the rest are other random keys
+                auto count_hits{[&](auto&& contains) {
+                    return time_ms([&]{
+                        int hits{0};
+
+                        for (std::size_t i{0}; i < N; ++i) {
+                            hits += contains(i % 2 == 0 ? rands_d[(i / 2) % M] : rands_d[N - 1 - i / 2]);
+                        }
+
+                        sink_int = hits;
+                    });
+                }};
+
+                best_flat = std::min(best_flat, count_hits([&](double k) { return flat.contains(k); }));
+                best_bst = std::min(best_bst, count_hits([&](double k) { return bst.contains(k); }));
+                best_stl = std::min(best_stl, count_hits([&](double k) { return s.find(k) != s.end(); }));
+#if defined(__cpp_lib_flat_set)
+                std::flat_set<double> fs(s.begin(), s.end());
+                best_stl_flat = std::min(best_stl_flat, count_hits([&](double k) { return fs.contains(k); }));
+#endif
+            }
+
+            std::cout << "[build " << M << " keys] FlatSet inserts: " << best_flat_insert << " ms | FlatSet bulk: " << best_flat_bulk
+                      << " ms | BST: " << best_bst_insert << " ms | std::set: " << best_stl_insert << " ms\n";
+            std::cout << "[contains N on " << M << " keys] FlatSet: " << best_flat << " ms | BST: " << best_bst << " ms | std::set: " << best_stl << " ms";
+#if defined(__cpp_lib_flat_set)
+            std::cout << " | std::flat_set: " << best_stl_flat << " ms";
+#endif
+            std::cout << "\n";
+        }
+    }
+
+    // HashMap / BinarySearchTree contains with and without a Bloom filter in front (90% misses)
+    {
+        const std::size_t M{N};
+        HashMap<> my;
+        BlockedBloomFilter blocked(M);
+        CountingBloomFilter counting(M);
+
+        // Even keys are stored, odd keys miss
+        for (std::size_t i{0}; i < M; ++i) {
+            my.insert(rands_i[i] * 2, (int)i);
+            blocked.insert(rands_i[i] * 2);
+            counting.insert(rands_i[i] * 2);
+        }
+
+        std::vector<int> queries(M);
+
+        for (std::size_t i{0}; i < M; ++i) {
+            queries[i] = i % 10 == 0 ? rands_i[i] * 2 : rands_i[i] * 2 + 1;
+        }
+
+        long long best_plain{1LL << 62};
+        long long best_blocked{1LL << 62};
+        long long best_counting{1LL << 62};
+
+        for (int t{0}; t < trials; ++t) {
+            best_plain = std::min(best_plain, time_ms([&]{
+                int hits{0};
+
+                for (int key : queries) {
+                    hits += my.contains(key);
+                }
+
+                sink_int = hits;
+            }));
+
+            best_blocked = std::min(best_blocked, time_ms([&]{
+                int hits{0};
+
+                for (int key : queries) {
+                    hits += blocked.may_contain(key) && my.contains(key);
+                }
+
+                sink_int = hits;
+            }));
+
+            best_counting = std::min(best_counting, time_ms([&]{
+                int hits{0};
+
+                for (int key : queries) {
+                    hits += counting.may_contain(key) && my.contains(key);
+                }
+
+                sink_int = hits;
+            }));
+        }
+
+        std::cout << "[contains M, 90% misses] HashMap: " << best_plain << " ms | BlockedBloomFilter + HashMap: " << best_blocked
+                  << " ms | CountingBloomFilter + HashMap: " << best_counting << " ms\n";
+
+        const std::size_t T{N / 5};
+        BinarySearchTree bst;
+        BlockedBloomFilter tree_filter(T);
+
+        for (std::size_t i{0}; i < T; ++i) {
+            bst.insert(rands_d[i]);
+            tree_filter.insert(rands_d[i]);
+        }
+
+        std::vector<double> tree_queries(T);
+
+        for (std::size_t i{0}; i < T; ++i) {
+            tree_queries[i] = i % 10 == 0 ? rands_d[i] : rands_d[i] + 0.5;
+        }
+
+        best_plain = 1LL << 62;
+        best_blocked = 1LL << 62;
+
+        for (int t{0}; t < trials; ++t) {
+            best_plain = std::min(best_plain, time_ms([&]{
+                int hits{0};
+
+                for (double x : tree_queries) {
+                    hits += bst.contains(x);
+                }
+
+                sink_int = hits;
+            }));
+
+            best_blocked = std::min(best_blocked, time_ms([&]{
+                int hits{0};
+
+                for (double x : tree_queries) {
+                    hits += tree_filter.may_contain(x) && bst.contains(x);
+                }
+
+                sink_int = hits;
+            }));
+        }
+
+        std::cout << "[contains M, 90% misses] BST: " << best_plain << " ms | BlockedBloomFilter + BST: " << best_blocked << " ms\n";
     }
 
     std::cout << "\n(sink_double = " << sink_double << ", sink_int = " << sink_int << ")\n";
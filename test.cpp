@@ -1,17 +1,49 @@
 // Unit tests for data structures library
-// Compile: clang++ -std=c++17 -O2 -Wall -Wextra -Wpedantic test.cpp DynamicArray.cpp \
-// Stack.cpp LinkedList.cpp Queue.cpp HashMap.cpp BinarySearchTree.cpp -o test && ./test
+// Compile: clang++ -std=c++17 -O2 -Wall -Wextra -Wpedantic -pthread test.cpp DynamicArray.cpp \
+// Stack.cpp LinkedList.cpp Queue.cpp HashMap.cpp DenseHashMap.cpp FrozenHashMap.cpp \
+// ConcurrentHashMap.cpp EpochManager.cpp LockFreeHashMap.cpp BloomFilter.cpp \
+// LruCache.cpp BinarySearchTree.cpp AVLTree.cpp BPlusTree.cpp FrozenSet.cpp \
+// CompactBinarySearchTree.cpp ConcurrentOrderedSet.cpp PersistentBinarySearchTree.cpp \
+// FlatSet.cpp -o test && ./test
+// Add -DHASHMAP_STATS to also build and test HashMap's statistics
 
 #include "DynamicArray.h"
 #include "LinkedList.h"
 #include "Stack.h"
 #include "Queue.h"
 #include "HashMap.h"
+#include "DenseHashMap.h"
+#include "FrozenHashMap.h"
+#include "ConcurrentHashMap.h"
+#include "LockFreeHashMap.h"
+#include "BloomFilter.h"
+#include "LruCache.h"
 #include "BinarySearchTree.h"
+#include "AVLTree.h"
+#include "BPlusTree.h"
+#include "FrozenSet.h"
+#include "CompactBinarySearchTree.h"
+#include "ConcurrentOrderedSet.h"
+#include "PersistentBinarySearchTree.h"
+#include "FlatSet.h"
 
 #include <iostream>
+#include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <atomic>
+#include <thread>
+#include <vector>
 
 // Unit test helpers
 static int g_tests_run{0};
@@ -348,95 +380,2206 @@ static void test_hashmap_copy_and_move() {
     assert(e.get(29, out) && out == 1029);
 }
 
+static void test_hashmap_power_of_two_capacity_structured_keys() {
+    HashMap m;
+    int out{0};
+
+    // Multiples of a power of two all land in one bucket under key % capacity
+    for (int k{0}; k < 1000; ++k) {
+        m.insert(k * 1024, k);
+        std::size_t cap{m.get_capacity()};
+        assert((cap & (cap - 1)) == 0);
+    }
+
+    assert(m.get_size() == 1000);
+    assert(m.load_factor() <= 0.7);
+
+    for (int k{0}; k < 1000; ++k) {
+        assert(m.get(k * 1024, out) && out == k);
+    }
+
+    assert(!m.contains(1));
+    assert(!m.contains(-1024));
+    m.insert(-2147483647 - 1, 7);
+    assert(m.get(-2147483647 - 1, out) && out == 7);
+}
+
+static void test_hashmap_string_keys_heterogeneous_lookup() {
+    HashMap<std::string, int> m;
+    m.insert("alpha", 1);
+    m.insert(std::string(40, 'x'), 2);
+    m.insert("", 3);
+    assert(m.get_size() == 3);
+    std::string_view sv{"alpha"};
+    int out{0};
+    assert(m.contains(sv));
+    assert(m.get(sv, out) && out == 1);
+    assert(m.find("alpha") != nullptr && *m.find("alpha") == 1);
+    assert(m.contains(std::string_view{std::string(40, 'x')}));
+    assert(m.contains(std::string_view{}));
+    assert(!m.contains(std::string_view{"alph"}));
+    assert(m.find(std::string_view{"beta"}) == nullptr);
+    *m.find(sv) = 10;
+    assert(m.get("alpha", out) && out == 10);
+    m.remove(sv);
+    assert(!m.contains("alpha"));
+    assert(m.get_size() == 2);
+
+    HashMap<std::int64_t, std::int64_t> big;
+    const std::int64_t base{std::int64_t{1} << 40};
+
+    for (std::int64_t k{0}; k < 100; ++k) {
+        big.insert(base + (k << 32), k);
+    }
+
+    std::int64_t out64{0};
+    assert(big.get_size() == 100);
+    assert(big.get(base + (std::int64_t{99} << 32), out64) && out64 == 99);
+    assert(!big.contains(base + 1));
+}
+
+static int g_counted_constructions{0};
+
+struct Counted {
+    Counted(int v): value{v} {
+        ++g_counted_constructions;
+    }
+
+    int value;
+};
+
+static void test_hashmap_try_emplace_insert_or_assign() {
+    HashMap<int, Counted> m;
+    g_counted_constructions = 0;
+    assert(m.try_emplace(1, 100));
+    assert(g_counted_constructions == 1);
+    assert(!m.try_emplace(1, 200));
+    assert(g_counted_constructions == 1);
+    assert(m.find(1)->value == 100);
+    assert(!m.insert_or_assign(1, Counted{300}));
+    assert(m.find(1)->value == 300);
+    assert(m.insert_or_assign(2, Counted{400}));
+    assert(m.get_size() == 2);
+
+    HashMap<std::string, std::string> s;
+    std::string key{"key"};
+    assert(s.try_emplace(std::move(key), 3, 'v'));
+    assert(*s.find("key") == "vvv");
+    assert(!s.insert_or_assign(std::string{"key"}, "w"));
+    assert(*s.find("key") == "w");
+}
+
+static void test_hashmap_incremental_rehash() {
+    HashMap m;
+    int out{0};
+    int n{0};
+
+    while (!m.is_rehashing()) {
+        m.insert(n, n * 2);
+        ++n;
+    }
+
+    // Lookups, overwrites and removes see keys in both the old and new tables
+    for (int k{0}; k < n; ++k) {
+        assert(m.get(k, out) && out == k * 2);
+    }
+
+    m.insert(0, -1);
+    assert(m.get(0, out) && out == -1);
+    m.remove(1);
+    assert(!m.contains(1));
+    assert(m.get_size() == (std::size_t)n - 1);
+    HashMap copy(m);
+    assert(!copy.is_rehashing());
+    assert(copy.get_size() == m.get_size());
+    HashMap moved(std::move(m));
+    assert(moved.is_rehashing());
+
+    for (int k{2}; k < n; ++k) {
+        assert(copy.get(k, out) && out == k * 2);
+        assert(moved.get(k, out) && out == k * 2);
+    }
+
+    for (int k{n}; k < 10000; ++k) {
+        moved.insert(k, k * 2);
+    }
+
+    assert(moved.get_size() == 10000 - 1);
+    assert(moved.load_factor() <= 0.7);
+
+    for (int k{2}; k < 10000; ++k) {
+        assert(moved.get(k, out) && out == k * 2);
+    }
+
+    moved.clear();
+    assert(!moved.is_rehashing());
+    assert(moved.empty());
+    assert(m.empty() && !m.contains(2));
+}
+
+static void test_hashmap_get_many_insert_many() {
+    HashMap m;
+    const std::size_t n{1000};
+    int keys[n];
+    int values[n];
+
+    for (std::size_t i{0}; i < n; ++i) {
+        keys[i] = (int)i * 7 - 3000;
+        values[i] = (int)i;
+    }
+
+    m.insert_many(keys, values, n);
+    assert(m.get_size() == n);
+    m.insert_many(keys, values, 10); // Overwrites, does not duplicate
+    assert(m.get_size() == n);
+
+    // Every other probe misses, and the batch does not divide evenly
+    const std::size_t q{2 * n + 5};
+    int probes[q];
+    int out[q];
+    bool found[q];
+
+    for (std::size_t i{0}; i < q; ++i) {
+        probes[i] = (i % 2 == 0) ? keys[(i / 2) % n] : keys[(i / 2) % n] + 1;
+    }
+
+    assert(m.get_many(probes, q, out, found) == n + 3);
+
+    for (std::size_t i{0}; i < q; ++i) {
+        assert(found[i] == (i % 2 == 0));
+
+        if (found[i]) {
+            assert(out[i] == (int)((i / 2) % n));
+        }
+    }
+
+    assert(m.get_many(probes, 0, out, found) == 0);
+}
+
+static void test_hashmap_reserve_bulk_build_shrink() {
+    HashMap m;
+    m.reserve(1000);
+    std::size_t cap{m.get_capacity()};
+    assert(cap >= 1000 && (cap & (cap - 1)) == 0);
+
+    for (int k{0}; k < 1000; ++k) {
+        m.insert(k, k);
+    }
+
+    assert(m.get_capacity() == cap);
+    assert(!m.is_rehashing());
+
+    for (int k{0}; k < 990; ++k) {
+        m.remove(k);
+    }
+
+    m.shrink_to_fit();
+    assert(m.get_capacity() == 16);
+    int out{0};
+
+    for (int k{990}; k < 1000; ++k) {
+        assert(m.get(k, out) && out == k);
+    }
+
+    const std::size_t n{5000};
+    std::vector<int> keys(n);
+    std::vector<int> values(n);
+
+    for (std::size_t i{0}; i < n; ++i) {
+        keys[i] = (int)(i % 4000) * 3;
+        values[i] = (int)i;
+    }
+
+    HashMap serial(keys.data(), values.data(), n);
+    HashMap parallel(keys.data(), values.data(), n, 4);
+    assert(serial.get_size() == 4000);
+    assert(parallel.get_size() == 4000);
+    assert(!parallel.is_rehashing());
+
+    // Later duplicates win, as with repeated insert
+    for (std::size_t i{0}; i < 4000; ++i) {
+        int expected{i < n - 4000 ? (int)i + 4000 : (int)i};
+        assert(serial.get((int)i * 3, out) && out == expected);
+        assert(parallel.get((int)i * 3, out) && out == expected);
+    }
+
+    HashMap none(keys.data(), values.data(), 0, 8);
+    assert(none.empty());
+
+    // Spans several hashing slices
+    std::vector<int> many(150000);
+
+    for (std::size_t i{0}; i < many.size(); ++i) {
+        many[i] = (int)i;
+    }
+
+    HashMap big(many.data(), many.data(), many.size(), 3);
+    assert(big.get_size() == many.size());
+    assert(big.get(0, out) && out == 0);
+    assert(big.get(149999, out) && out == 149999);
+    assert(big.get(65536, out) && out == 65536);
+
+    // A value copy that throws partway through leaves nothing behind (checked under ASan)
+    struct Fragile {
+        int v;
+        Fragile(int new_v): v{new_v} {}
+        Fragile(const Fragile& orig): v{orig.v} {
+            if (v == 100000) {
+                throw std::runtime_error{"copy failed"};
+            }
+        }
+        Fragile& operator=(const Fragile& rhs) = default;
+    };
+    std::vector<Fragile> fragile(many.begin(), many.end());
+    bool threw{false};
+
+    try {
+        HashMap<int, Fragile> partial(many.data(), fragile.data(), many.size(), 3);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+
+    assert(threw);
+}
+
+static void test_hashmap_iterators_and_for_each() {
+    HashMap m;
+    assert(m.begin() == m.end());
+
+    for (int k{0}; k < 200; ++k) {
+        m.insert(k, k * 2);
+    }
+
+    // Stop partway through a rehash so both tables hold entries
+    while (!m.is_rehashing()) {
+        m.insert(m.get_size(), (int)m.get_size() * 2);
+    }
+
+    std::vector<int> seen(m.get_size(), 0);
+    std::size_t count{0};
+
+    for (auto [key, value] : m) {
+        assert(value == key * 2);
+        ++seen[key];
+        ++count;
+    }
+
+    assert(count == m.get_size());
+
+    for (int s : seen) {
+        assert(s == 1);
+    }
+
+    for (HashMap<>::iterator it{m.begin()}; it != m.end(); ++it) {
+        it.value() += 1;
+    }
+
+    const HashMap<>& cm{m};
+    long long sum{0};
+    HashMap<>::const_iterator cit{m.begin()};
+    assert(cit == cm.begin());
+
+    for (; cit != cm.end(); cit++) {
+        assert(cit.value() == cit.key() * 2 + 1);
+        sum += cit.key();
+    }
+
+    long long visited{0};
+    cm.for_each([&](const int& key, const int& value) {
+        assert(value == key * 2 + 1);
+        visited += key;
+    });
+    assert(visited == sum);
+
+    m.for_each([](const int&, int& value) {
+        value = 0;
+    });
+    int out{-1};
+    assert(m.get(5, out) && out == 0);
+}
+
+#ifdef HASHMAP_STATS
+// Hashes an int to itself, so the bucket is key % capacity
+struct IdentityHash {
+    std::uint64_t operator()(int key) const {
+        return static_cast<std::uint64_t>(static_cast<unsigned>(key));
+    }
+};
+
+static void test_hashmap_stats() {
+    HashMap<> mixed;
+    HashMap<int, int, IdentityHash> identity;
+
+    for (int k{0}; k < 4000; ++k) {
+        mixed.insert(k * 1024, k);
+        identity.insert(k * 1024, k);
+    }
+
+    HashMapStats good{mixed.get_stats()};
+    HashMapStats bad{identity.get_stats()};
+    assert(good.size == 4000 && good.capacity == mixed.get_capacity());
+    assert(good.operations == 4000 && bad.operations == 4000);
+    assert(good.rehashes > 0 && good.rehashes == bad.rehashes);
+    assert(good.bytes_allocated > good.bytes_in_use - 1 && good.bytes_in_use > 0);
+
+    // Multiples of 1024 share their low bits, so key % capacity piles them into few buckets
+    assert(bad.collisions_per_operation() > 100 * (good.collisions_per_operation() + 0.01));
+    assert(bad.probe_lengths[HashMapStats::histogram_size - 1] > 0);
+    std::uint64_t buckets{0};
+
+    for (std::size_t i{0}; i < HashMapStats::histogram_size; ++i) {
+        buckets += good.occupancy[i];
+    }
+
+    assert(buckets == good.capacity || mixed.is_rehashing());
+
+    int out{0};
+    mixed.reset_stats();
+    assert(mixed.get(1024, out) && !mixed.get(1, out));
+    good = mixed.get_stats();
+    assert(good.operations == 2 && good.rehashes == 0 && good.rehash_ns == 0);
+
+    std::string json{good.to_json()};
+    assert(json.front() == '{' && json.back() == '}');
+    assert(json.find("\"operations\":2") != std::string::npos);
+    assert(json.find("\"probe_lengths\":[") != std::string::npos);
+    assert(json.find("\"occupancy\":[") != std::string::npos);
+}
+#endif
+
+// DenseHashMap tests
+static void test_densehashmap_basic_and_swap_remove() {
+    DenseHashMap<> m;
+    assert(m.empty());
+    assert(m.begin() == m.end());
+
+    for (int k{0}; k < 1000; ++k) {
+        assert(m.try_emplace(k, k));
+    }
+
+    assert(!m.try_emplace(3, 99));
+    assert(!m.insert_or_assign(3, 33));
+    assert(m.get_size() == 1000);
+    assert(m.load_factor() <= 0.7);
+    int out{0};
+    assert(m.get(3, out) && out == 33);
+
+    // Entries come back in insertion order while nothing has been removed
+    int expected{0};
+
+    for (auto [key, value] : m) {
+        assert(key == expected);
+        (void)value;
+        ++expected;
+    }
+
+    // Removing from the middle moves the last entry into the hole
+    for (int k{0}; k < 1000; k += 2) {
+        m.remove(k);
+    }
+
+    m.remove(12345);
+    assert(m.get_size() == 500);
+
+    for (int k{0}; k < 1000; ++k) {
+        assert(m.contains(k) == (k % 2 == 1));
+    }
+
+    std::size_t count{0};
+    m.for_each([&](const int& key, int& value) {
+        assert(key % 2 == 1);
+        value = -key;
+        ++count;
+    });
+    assert(count == 500);
+    assert(*m.find(7) == -7);
+    assert(m.find(8) == nullptr);
+
+    DenseHashMap<std::string, int> s;
+    s.reserve(100);
+    std::size_t cap{s.get_capacity()};
+
+    for (int k{0}; k < 100; ++k) {
+        s.insert("key" + std::to_string(k), k);
+    }
+
+    assert(s.get_capacity() == cap);
+    s.remove("key0");
+    assert(s.get("key99", out) && out == 99);
+    assert(!s.contains("key0"));
+}
+
+static void test_densehashmap_copy_move_clear() {
+    DenseHashMap<std::string, std::string> a;
+
+    for (int k{0}; k < 300; ++k) {
+        a.insert(std::to_string(k), "v" + std::to_string(k));
+    }
+
+    DenseHashMap<std::string, std::string> b(a);
+    a.remove("5");
+    assert(b.contains("5") && !a.contains("5"));
+    std::string out;
+    assert(b.get("299", out) && out == "v299");
+
+    DenseHashMap<std::string, std::string> c;
+    c.insert("x", "y");
+    c = b;
+    assert(c.get_size() == 300 && !c.contains("x"));
+
+    DenseHashMap<std::string, std::string> d(std::move(b));
+    assert(d.get_size() == 300);
+    assert(b.empty());
+    b.insert("reuse", "ok");
+    assert(b.get("reuse", out) && out == "ok");
+
+    DenseHashMap<std::string, std::string> e;
+    e = std::move(d);
+    assert(e.get_size() == 300 && d.empty());
+
+    std::size_t cap{e.get_capacity()};
+    e.clear();
+    assert(e.empty() && e.get_capacity() == cap);
+    assert(!e.contains("1"));
+    e.insert("1", "one");
+    assert(e.get("1", out) && out == "one");
+
+    const DenseHashMap<std::string, std::string>& ce{e};
+    std::size_t count{0};
+
+    for (DenseHashMap<std::string, std::string>::const_iterator it{ce.begin()}; it != ce.end(); ++it) {
+        assert(it.key() == "1" && (*it).second == "one");
+        ++count;
+    }
+
+    assert(count == 1);
+}
+
+// FrozenHashMap tests
+static void test_frozenhashmap_build_and_lookup() {
+    HashMap<> source;
+
+    for (int k{0}; k < 20000; ++k) {
+        source.insert(k * 7 - 50000, k);
+    }
+
+    FrozenHashMap<> frozen{FrozenHashMap<>::build(source)};
+    assert(frozen.get_size() == source.get_size());
+    assert(frozen.bits_per_key() < 4.0);
+    int out{-1};
+
+    for (int k{0}; k < 20000; ++k) {
+        assert(frozen.get(k * 7 - 50000, out) && out == k);
+    }
+
+    for (int k{0}; k < 20000; ++k) {
+        assert(!frozen.contains(k * 7 - 49999));
+    }
+
+    assert(*frozen.find(-50000) == 0);
+    assert(frozen.find(2) == nullptr);
+
+    FrozenHashMap<> copy(frozen);
+    FrozenHashMap<> moved(std::move(frozen));
+    assert(frozen.empty() && !frozen.contains(-50000));
+    assert(copy.get(7 * 123 - 50000, out) && out == 123);
+    assert(moved.get(7 * 456 - 50000, out) && out == 456);
+
+    // Every small size builds, whatever its table size factors into
+    HashMap<> growing;
+
+    for (int n{1}; n <= 300; ++n) {
+        growing.insert(n, -n);
+        FrozenHashMap<> small{FrozenHashMap<>::build(growing)};
+        assert(small.get(n, out) && out == -n);
+    }
+
+    HashMap<> none;
+    FrozenHashMap<> empty{FrozenHashMap<>::build(none)};
+    assert(empty.empty() && !empty.contains(0));
+
+    HashMap<> one;
+    one.insert(42, 1);
+    FrozenHashMap<> single{FrozenHashMap<>::build(one)};
+    assert(single.get(42, out) && out == 1);
+    assert(!single.contains(43));
+
+    HashMap<std::string, int> words;
+
+    for (int k{0}; k < 500; ++k) {
+        words.insert("word" + std::to_string(k), k);
+    }
+
+    FrozenHashMap<std::string, int> frozen_words{FrozenHashMap<std::string, int>::build(words)};
+    assert(frozen_words.get("word321", out) && out == 321);
+    assert(!frozen_words.contains("word500"));
+}
+
+static void test_frozenhashmap_save_and_load() {
+    const std::string path{"frozenhashmap_test.bin"};
+    HashMap<std::int64_t, std::int64_t> source;
+
+    for (std::int64_t k{0}; k < 5000; ++k) {
+        source.insert(k * k, -k);
+    }
+
+    FrozenHashMap<std::int64_t, std::int64_t> frozen{FrozenHashMap<std::int64_t, std::int64_t>::build(source)};
+    assert(frozen.save(path));
+
+    FrozenHashMap<std::int64_t, std::int64_t> loaded;
+    assert(loaded.load(path));
+    assert(loaded.get_size() == 5000);
+    std::int64_t out{0};
+
+    for (std::int64_t k{0}; k < 5000; ++k) {
+        assert(loaded.get(k * k, out) && out == -k);
+    }
+
+    assert(!loaded.contains(2));
+
+    // Images saved for other key or value types are rejected and leave the map alone
+    FrozenHashMap<> other;
+    assert(!other.load(path));
+    assert(other.empty());
+    assert(!loaded.load(path + ".missing"));
+    assert(loaded.get_size() == 5000);
+
+    // Truncated, padded or corrupted images are rejected too
+    std::string image;
+    {
+        std::ifstream in{path, std::ios::binary};
+        image.assign(std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{});
+    }
+
+    auto load_changed{[&](std::string bytes) {
+        std::ofstream{path, std::ios::binary | std::ios::trunc}.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        return loaded.load(path);
+    }};
+    std::size_t pilots_at{8 * sizeof(std::uint64_t)};
+    std::size_t remap_at{pilots_at + 1000 * sizeof(std::uint16_t)};
+    assert(!load_changed(image.substr(0, image.size() - 1)));
+    assert(!load_changed(image + '\0'));
+    std::string bad_size{image};
+    bad_size[3 * sizeof(std::uint64_t)] = 1;
+    assert(!load_changed(bad_size));
+    std::string bad_pilot{image};
+    bad_pilot[pilots_at] = static_cast<char>(bad_pilot[pilots_at] ^ 0x5A);
+    bad_pilot[pilots_at + 1] = static_cast<char>(bad_pilot[pilots_at + 1] ^ 0x5A);
+    assert(!load_changed(bad_pilot));
+    std::string bad_remap{image};
+    bad_remap[remap_at + 3] = static_cast<char>(0x7F);
+    assert(!load_changed(bad_remap));
+    assert(loaded.get_size() == 5000);
+    assert(load_changed(image));
+
+    FrozenHashMap<std::int64_t, std::int64_t> empty;
+    assert(empty.save(path));
+    assert(loaded.load(path));
+    assert(loaded.empty());
+
+    // The padding after each 4-byte value is saved as zeros
+    HashMap<std::int64_t, std::int32_t> narrow;
+
+    for (std::int32_t k{0}; k < 100; ++k) {
+        narrow.insert(k, ~k);
+    }
+
+    FrozenHashMap<std::int64_t, std::int32_t> frozen_narrow{FrozenHashMap<std::int64_t, std::int32_t>::build(narrow)};
+    assert(frozen_narrow.save(path));
+    std::ifstream in{path, std::ios::binary};
+    std::string bytes{std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+    std::size_t entries_at{bytes.size() - 100 * 16};
+
+    for (std::size_t i{0}; i < 100; ++i) {
+        assert(bytes.compare(entries_at + i * 16 + 12, 4, std::string(4, '\0')) == 0);
+    }
+
+    std::remove(path.c_str());
+}
+
+// ConcurrentHashMap tests
+static std::size_t counted_hashes{0};
+
+struct CountingHash {
+    std::uint64_t operator()(const std::string& key) const {
+        ++counted_hashes;
+        return MixHash{}(key);
+    }
+};
+
+static void test_concurrenthashmap_basic() {
+    ConcurrentHashMap<> m(5);
+    assert(m.get_shard_count() == 8);
+    assert(m.empty());
+    m.insert(1, 10);
+    m.insert(2, 20);
+    assert(m.try_emplace(3, 30));
+    assert(!m.try_emplace(3, 31));
+    assert(!m.insert_or_assign(1, 11));
+    assert(m.get_size() == 3);
+    int out{0};
+    assert(m.get(1, out) && out == 11);
+    assert(m.contains(3));
+    m.remove(2);
+    assert(!m.contains(2));
+    assert(m.get_size() == 2);
+    m.clear();
+    assert(m.empty());
+
+    ConcurrentHashMap<> single(1);
+    single.insert(7, 70);
+    assert(single.get(7, out) && out == 70);
+
+    // The shard map reuses the hash that picked the shard
+    ConcurrentHashMap<std::string, int, CountingHash> words(4);
+    counted_hashes = 0;
+    words.insert("alpha", 1);
+    assert(words.try_emplace("beta", 2));
+    assert(words.get("alpha", out) && out == 1);
+    assert(words.contains("beta"));
+    words.remove("alpha");
+    assert(!words.contains("alpha"));
+    assert(counted_hashes == 6);
+}
+
+static void test_concurrenthashmap_parallel_writers_and_readers() {
+    ConcurrentHashMap<> m;
+    const int threads{4};
+    const int per_thread{5000};
+    std::vector<std::thread> pool;
+
+    for (int t{0}; t < threads; ++t) {
+        pool.emplace_back([&m, t] {
+            for (int k{0}; k < per_thread; ++k) {
+                m.insert(t * per_thread + k, k);
+            }
+        });
+    }
+
+    // Readers run alongside the writers and only ever see complete values
+    for (int t{0}; t < 2; ++t) {
+        pool.emplace_back([&m] {
+            int out{0};
+
+            for (int k{0}; k < per_thread; ++k) {
+                if (m.get(k, out)) {
+                    assert(out == k);
+                }
+            }
+        });
+    }
+
+    for (std::thread& th : pool) {
+        th.join();
+    }
+
+    assert(m.get_size() == (std::size_t)(threads * per_thread));
+    int out{0};
+
+    for (int k{0}; k < threads * per_thread; ++k) {
+        assert(m.get(k, out) && out == k % per_thread);
+    }
+}
+
+// LockFreeHashMap tests
+static void test_lockfreehashmap_basic_and_rehash() {
+    LockFreeHashMap<> m;
+    assert(m.empty());
+    int out{0};
+
+    for (int k{0}; k < 5000; ++k) {
+        assert(m.insert_or_assign(k, k * 3));
+    }
+
+    assert(m.get_size() == 5000);
+    assert(m.get_capacity() >= 5000);
+
+    for (int k{0}; k < 5000; ++k) {
+        assert(m.get(k, out) && out == k * 3);
+    }
+
+    assert(!m.insert_or_assign(7, -7));
+    assert(m.get(7, out) && out == -7);
+    m.remove(8);
+    m.remove(123456);
+    assert(!m.contains(8));
+    assert(m.get_size() == 4999);
+    m.clear();
+    assert(m.empty());
+    assert(!m.contains(7));
+    m.insert(1, 1);
+    assert(m.get(1, out) && out == 1);
+}
+
+static void test_lockfreehashmap_readers_during_writes() {
+    LockFreeHashMap<> m;
+    const int stable{2000};
+
+    for (int k{0}; k < stable; ++k) {
+        m.insert(k, k);
+    }
+
+    // Stable keys must stay visible to readers while the writer grows the table
+    // several times and churns the other keys
+    std::atomic<bool> done{false};
+    std::vector<std::thread> readers;
+
+    for (int t{0}; t < 3; ++t) {
+        readers.emplace_back([&m, &done] {
+            int out{0};
+
+            while (!done.load()) {
+                for (int k{0}; k < stable; ++k) {
+                    assert(m.get(k, out) && out == k);
+                }
+            }
+        });
+    }
+
+    std::size_t expected{stable};
+
+    for (int k{stable}; k < 60000; ++k) {
+        m.insert(k, k);
+
+        if (k % 3 == 0) {
+            m.remove(k);
+        } else {
+            ++expected;
+        }
+    }
+
+    done.store(true);
+
+    for (std::thread& th : readers) {
+        th.join();
+    }
+
+    assert(m.get_size() == expected);
+}
+
+// BloomFilter tests
+static void test_blockedbloomfilter_no_false_negatives() {
+    const int n{20000};
+    BlockedBloomFilter f(n);
+    assert(f.get_bit_count() >= 10 * (std::size_t)n);
+
+    for (int k{0}; k < n; ++k) {
+        assert(!f.may_contain(k * 2));
+    }
+
+    for (int k{0}; k < n; ++k) {
+        f.insert(k * 2);
+    }
+
+    int false_positives{0};
+
+    for (int k{0}; k < n; ++k) {
+        assert(f.may_contain(k * 2));
+        false_positives += f.may_contain(k * 2 + 1);
+    }
+
+    // About 1% expected at 10 bits per key
+    assert(false_positives < n / 40);
+
+    BlockedBloomFilter copy(f);
+    BlockedBloomFilter moved(std::move(f));
+    assert(copy.may_contain(4000) && moved.may_contain(4000));
+    assert(!f.may_contain(4000));
+    f.insert(4000);
+    assert(f.may_contain(4000));
+    f = copy;
+    assert(f.may_contain(39998));
+
+    copy.clear();
+    assert(!copy.may_contain(4000));
+
+    BlockedBloomFilter words(100);
+    words.insert(std::string{"apple"});
+    words.insert(2.5);
+    assert(words.may_contain("apple") && words.may_contain(std::string_view{"apple"}));
+    assert(words.may_contain(2.5));
+
+    BlockedBloomFilter tiny(0);
+    tiny.insert(1);
+    assert(tiny.may_contain(1));
+}
+
+static void test_countingbloomfilter_remove() {
+    const int n{10000};
+    CountingBloomFilter f(n);
+
+    for (int k{0}; k < n; ++k) {
+        f.insert(k);
+    }
+
+    for (int k{0}; k < n; k += 2) {
+        f.remove(k);
+    }
+
+    int still_present{0};
+
+    for (int k{0}; k < n; ++k) {
+        if (k % 2 == 1) {
+            assert(f.may_contain(k));
+        } else {
+            still_present += f.may_contain(k);
+        }
+    }
+
+    assert(still_present < n / 20);
+
+    // A key inserted twice survives one removal
+    f.insert(-7);
+    f.insert(-7);
+    f.remove(-7);
+    assert(f.may_contain(-7));
+
+    CountingBloomFilter copy(f);
+
+    for (int k{1}; k < n; k += 2) {
+        f.remove(k);
+    }
+
+    f.remove(-7);
+    int remaining{0};
+
+    for (int k{-10}; k < n; ++k) {
+        remaining += f.may_contain(k);
+    }
+
+    assert(remaining == 0);
+    assert(copy.may_contain(1) && copy.may_contain(-7));
+
+    CountingBloomFilter moved(std::move(copy));
+    assert(moved.may_contain(3));
+    copy.insert(3);
+    copy.remove(3);
+    assert(!copy.may_contain(3));
+    moved.clear();
+    assert(!moved.may_contain(3));
+}
+
+// LruCache tests
+static void test_lrucache_lru_eviction_and_stats() {
+    LruCache<> c(3);
+    int out{0};
+    c.put(1, 10);
+    c.put(2, 20);
+    c.put(3, 30);
+    assert(c.get_size() == 3);
+
+    // 1 becomes most recent, so 2 is evicted next
+    assert(c.get(1, out) && out == 10);
+    c.put(4, 40);
+    assert(!c.contains(2));
+    assert(c.contains(1) && c.contains(3) && c.contains(4));
+
+    // Overwriting refreshes too
+    c.put(3, 33);
+    c.put(5, 50);
+    assert(!c.contains(1));
+    assert(c.get(3, out) && out == 33);
+    assert(!c.get(2, out));
+    assert(c.get_hits() == 2 && c.get_misses() == 1);
+    assert_double_eq(c.hit_ratio(), 2.0 / 3.0);
+
+    // Removed slots are reused before anything is evicted
+    c.remove(4);
+    c.remove(42);
+    assert(c.get_size() == 2);
+    c.put(6, 60);
+    assert(c.contains(3) && c.contains(5) && c.contains(6));
+    *c.find(6) = 66;
+    assert(c.get(6, out) && out == 66);
+
+    LruCache<> copy(c);
+    c.put(7, 70);
+    assert(!c.contains(5) && copy.contains(5));
+    copy.put(8, 80);
+    assert(!copy.contains(5) && copy.contains(3));
+
+    LruCache<> moved(std::move(c));
+    assert(moved.contains(7) && c.empty());
+    c.put(1, 1);
+    c.put(2, 2);
+    assert(c.get_size() == 1 && c.contains(2));
+
+    moved.clear();
+    moved.reset_stats();
+    assert(moved.empty() && moved.get_hits() == 0);
+    assert(moved.hit_ratio() == 0.0);
+
+    LruCache<std::string, std::string> s(2);
+    s.put("a", "x");
+    s.put("b", "y");
+    s.put("c", "z");
+    assert(!s.contains("a") && s.contains("c"));
+}
+
+static void test_lrucache_clock_second_chance() {
+    LruCache<> c(3, EvictionPolicy::Clock);
+    assert(c.get_policy() == EvictionPolicy::Clock);
+    int out{0};
+    c.put(1, 10);
+    c.put(2, 20);
+    c.put(3, 30);
+
+    // 1 and 3 are referenced, so the hand clears them and takes 2
+    assert(c.get(1, out) && c.get(3, out));
+    c.put(4, 40);
+    assert(!c.contains(2));
+    assert(c.contains(1) && c.contains(3) && c.contains(4));
+
+    // The hand gives 3 its second chance and takes 1, whose flag it cleared earlier
+    c.put(5, 50);
+    assert(!c.contains(1) && c.contains(3));
+    c.put(6, 60);
+    assert(!c.contains(4));
+
+    c.remove(5);
+    c.put(7, 70);
+    assert(c.contains(3) && c.contains(6) && c.contains(7));
+    assert(c.get_size() == 3);
+
+    // A large working set under churn never exceeds the capacity
+    LruCache<> big(100, EvictionPolicy::Clock);
+
+    for (int k{0}; k < 10000; ++k) {
+        big.put(k % 250, k);
+
+        if (k % 3 == 0) {
+            big.get(k % 50, out);
+        }
+    }
+
+    assert(big.get_size() == 100);
+}
+
 // BinarySearchTree tests
 static void test_bst_insert_contains_min_max_height_valid() {
     BinarySearchTree t;
     assert(t.empty());
-    assert(t.get_size() == 0);
+    assert(t.get_size() == 0);
+    assert(t.is_valid_bst());
+    t.insert(5);
+    t.insert(3);
+    t.insert(7);
+    t.insert(2);
+    t.insert(4);
+    t.insert(6);
+    t.insert(8);
+    assert(!t.empty());
+    assert(t.get_size() == 7);
+    assert(t.contains(5));
+    assert(t.contains(2));
+    assert(t.contains(8));
+    assert(!t.contains(999));
+    assert_double_eq(t.min(), 2.0);
+    assert_double_eq(t.max(), 8.0);
+    assert(t.height() == 3);
+    assert(t.is_valid_bst());
+}
+
+static void test_bst_no_duplicates() {
+    BinarySearchTree t;
+    t.insert(5);
+    t.insert(5);
+    t.insert(5);
+    assert(t.get_size() == 1);
+    assert(t.contains(5));
+    assert(t.is_valid_bst());
+}
+
+static void test_bst_erase_cases() {
+    BinarySearchTree t;
+
+    for (double v : {5,3,7,2,4,6,8}) {
+        t.insert(v);
+    }
+
+    assert(t.get_size() == 7);
+    t.erase(2);
+    assert(!t.contains(2));
+    assert(t.get_size() == 6);
+    assert(t.is_valid_bst());
+    t.erase(8);
+    assert(!t.contains(8));
+    assert(t.get_size() == 5);
+    assert(t.is_valid_bst());
+    t.erase(7);
+    assert(!t.contains(7));
+    assert(t.get_size() == 4);
+    assert(t.is_valid_bst());
+    t.erase(5);
+    assert(!t.contains(5));
+    assert(t.get_size() == 3);
+    assert(t.is_valid_bst());
+    t.clear();
+    assert(t.empty());
+    assert(t.get_size() == 0);
+}
+
+static void test_bst_copy_and_move() {
+    BinarySearchTree a;
+
+    for (double v : {10,5,15,3,7,12,18}) {
+        a.insert(v);
+    }
+
+    BinarySearchTree b(a);
+    assert(b.get_size() == a.get_size());
+    assert(b.contains(7));
+    assert_double_eq(b.min(), 3.0);
+    assert_double_eq(b.max(), 18.0);
+    assert(b.is_valid_bst());
+    BinarySearchTree c;
+    c = b;
+    assert(c.get_size() == 7);
+    assert(c.contains(12));
+    assert(c.is_valid_bst());
+    BinarySearchTree d(std::move(a));
+    assert(d.get_size() == 7);
+    assert(d.contains(15));
+    BinarySearchTree e;
+    e = std::move(b);
+    assert(e.get_size() == 7);
+    assert(e.contains(5));
+}
+
+static void test_bst_traversal_orders() {
+    BinarySearchTree t;
+
+    for (double v : {5,3,7,2,4,6,8}) {
+        t.insert(v);
+    }
+
+    std::ostringstream out;
+    std::streambuf* saved{std::cout.rdbuf(out.rdbuf())};
+    t.inorder_print();
+    t.preorder_print();
+    t.postorder_print();
+    t.levelorder_print();
+    BinarySearchTree{}.levelorder_print();
+    std::cout.rdbuf(saved);
+    assert(out.str() == "2 3 4 5 6 7 8 \n5 3 2 4 7 6 8 \n2 4 3 6 8 7 5 \n5 3 7 2 4 6 8 \n\n");
+}
+
+// Chains deeper than the walks' inline buffers, in both directions
+static void test_bst_degenerate_chains() {
+    const int n{5000};
+    BinarySearchTree up;
+    BinarySearchTree down;
+
+    for (int i{0}; i < n; ++i) {
+        up.insert(i);
+        down.insert(n - i);
+    }
+
+    assert(up.height() == static_cast<std::size_t>(n));
+    assert(down.height() == static_cast<std::size_t>(n));
+    assert(up.is_valid_bst());
+    assert(down.is_valid_bst());
+    BinarySearchTree copy(down);
+    assert(copy.get_size() == static_cast<std::size_t>(n));
+    assert(copy.height() == static_cast<std::size_t>(n));
+    assert(copy.is_valid_bst());
+    copy.erase(1);
+    copy.erase(n);
+    copy.erase(n / 2);
+    assert(copy.get_size() == static_cast<std::size_t>(n - 3));
+    assert(!copy.contains(n / 2));
+    assert(copy.contains(n / 2 + 1));
+    assert(copy.is_valid_bst());
+    std::ostringstream out;
+    std::streambuf* saved{std::cout.rdbuf(out.rdbuf())};
+    up.levelorder_print();
+    down.postorder_print();
+    std::cout.rdbuf(saved);
+    assert(out.str().size() > 0);
+    up.clear();
+    assert(up.empty());
+    assert(up.height() == 0);
+    copy = down;
+    assert(copy.get_size() == static_cast<std::size_t>(n));
+}
+
+static void test_bst_iterators_and_visitors() {
+    BinarySearchTree t;
+    std::set<double> model;
+    std::uint64_t x{3};
+    assert(t.begin() == t.end());
+    assert(t.rbegin() == t.rend());
+
+    for (int i{0}; i < 3000; ++i) {
+        x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+        double k{static_cast<double>((x >> 33) % 1000)};
+
+        if (i % 3 == 2) {
+            t.erase(k);
+            model.erase(k);
+        } else {
+            t.insert(k);
+            model.insert(k);
+        }
+    }
+
+    BinarySearchTree copy(t);
+
+    for (const BinarySearchTree* tree : {&t, &copy}) {
+        std::vector<double> forward(tree->begin(), tree->end());
+        std::vector<double> backward(tree->rbegin(), tree->rend());
+        assert(forward == std::vector<double>(model.begin(), model.end()));
+        assert(backward == std::vector<double>(model.rbegin(), model.rend()));
+    }
+
+    auto last{t.end()};
+    --last;
+    assert_double_eq(*last, t.max());
+    auto first{t.begin()};
+    assert_double_eq(*first++, t.min());
+    assert(*first > t.min());
+    DynamicArray sorted;
+    sorted.push_back(-1.0);
+    t.to_array(sorted);
+    assert(sorted.get_size() == model.size());
+    std::size_t i{0};
+
+    for (double k : t) {
+        assert_double_eq(sorted[i++], k);
+    }
+
+    BinarySearchTree small;
+
+    for (double v : {5,3,7,2,4,6,8}) {
+        small.insert(v);
+    }
+
+    std::string orders;
+    auto append{[&orders](double k) { orders += std::to_string(static_cast<int>(k)); }};
+    small.for_each_inorder(append);
+    orders += "|";
+    small.for_each_preorder(append);
+    orders += "|";
+    small.for_each_postorder(append);
+    orders += "|";
+    small.for_each_levelorder(append);
+    assert(orders == "2345678|5324768|2436875|5372468");
+
+    // Erasing a key with two children must not move its successor's key, so
+    // iterators to the successor still see it
+    auto four{std::next(small.begin(), 2)};
+    auto six{std::next(small.begin(), 4)};
+    small.erase(5);
+    small.erase(3);
+    assert_double_eq(*four, 4.0);
+    assert_double_eq(*six, 6.0);
+    assert_double_eq(*std::next(six), 7.0);
+    assert_double_eq(*std::prev(six), 4.0);
+    assert_double_eq(*std::prev(four), 2.0);
+    assert(small.is_valid_bst());
+}
+
+static void test_bst_order_statistics() {
+    BinarySearchTree t;
+    std::set<double> model;
+    std::uint64_t x{11};
+
+    for (int i{0}; i < 4000; ++i) {
+        x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+        double k{static_cast<double>((x >> 33) % 2000)};
+
+        if (i % 4 == 3) {
+            t.erase(k);
+            model.erase(k);
+        } else {
+            t.insert(k);
+            model.insert(k);
+        }
+    }
+
+    BinarySearchTree copy(t);
+    std::vector<double> sorted(model.begin(), model.end());
+
+    for (std::size_t k{0}; k < sorted.size(); ++k) {
+        assert_double_eq(t.select(k), sorted[k]);
+        assert_double_eq(copy.select(k), sorted[k]);
+    }
+
+    for (int i{-2}; i <= 2002; ++i) {
+        double probe{i + (i % 2) * 0.5};
+        std::size_t below{static_cast<std::size_t>(std::lower_bound(sorted.begin(), sorted.end(), probe) - sorted.begin())};
+        std::size_t not_above{static_cast<std::size_t>(std::upper_bound(sorted.begin(), sorted.end(), probe) - sorted.begin())};
+        assert(t.rank(probe) == below);
+        assert(t.lower_bound(probe) == (below == sorted.size() ? t.end() : t.lower_bound(sorted[below])));
+        assert(below == sorted.size() || *t.lower_bound(probe) == sorted[below]);
+        assert(not_above == sorted.size() ? t.upper_bound(probe) == t.end() : *t.upper_bound(probe) == sorted[not_above]);
+        assert(t.count_range(probe, probe + 37) == static_cast<std::size_t>(
+            std::lower_bound(sorted.begin(), sorted.end(), probe + 37) - sorted.begin()) - below);
+    }
+
+    assert(t.count_range(10, 10) == 0);
+    assert(t.count_range(20, 10) == 0);
+    std::vector<double> in_range;
+
+    for (double k : t.range(100, 200)) {
+        in_range.push_back(k);
+    }
+
+    assert(in_range == std::vector<double>(model.lower_bound(100), model.lower_bound(200)));
+    assert(t.range(200, 100).begin() == t.range(200, 100).end());
+}
+
+static void test_bst_build_from_sorted_and_unsorted() {
+    for (std::size_t n : {0, 1, 2, 3, 7, 8, 1000, 70000}) {
+        std::vector<double> keys(n);
+
+        for (std::size_t i{0}; i < n; ++i) {
+            keys[i] = 2.0 * i;
+        }
+
+        BinarySearchTree t{BinarySearchTree::build_from_sorted(keys.data(), n, 4)};
+        std::size_t levels{0};
+
+        while ((std::size_t{1} << levels) <= n) {
+            ++levels;
+        }
+
+        assert(t.get_size() == n);
+        assert(t.height() == levels);
+        assert(t.is_valid_bst());
+        assert(std::vector<double>(t.rbegin(), t.rend()) == std::vector<double>(keys.rbegin(), keys.rend()));
+
+        for (std::size_t i{0}; i < n; i += 1 + n / 50) {
+            assert(t.contains(keys[i]));
+            assert(!t.contains(keys[i] + 1));
+            assert_double_eq(t.select(i), keys[i]);
+            assert(t.rank(keys[i]) == i);
+        }
+
+        // Mixing block nodes with individually allocated ones, then erasing both kinds
+        for (std::size_t i{0}; i < n; i += 3) {
+            t.insert(keys[i] + 1);
+            t.erase(keys[i]);
+        }
+
+        assert(t.get_size() == n);
+        assert(t.is_valid_bst());
+        BinarySearchTree copy(t);
+        assert(copy.get_size() == n);
+        BinarySearchTree moved(std::move(t));
+        assert(moved.get_size() == n);
+        assert(t.empty());
+        moved = copy;
+        assert(moved.is_valid_bst());
+    }
+
+    double unsorted[]{5, 1, 4, 1, 5, 9, 2, 6, 5, 3};
+    BinarySearchTree u{BinarySearchTree::build_from_unsorted(unsorted, 10)};
+    assert(u.get_size() == 7);
+    assert(u.height() == 3);
+    assert(std::vector<double>(u.begin(), u.end()) == std::vector<double>({1, 2, 3, 4, 5, 6, 9}));
+}
+
+static void test_bst_splay_mode() {
+    BinarySearchTree t;
+    assert(t.get_access_mode() == BinarySearchTree::AccessMode::Static);
+    t.set_access_mode(BinarySearchTree::AccessMode::Splay);
+    std::set<double> model;
+    std::uint64_t x{29};
+
+    auto root_key{[](const BinarySearchTree& tree) {
+        double first{0.0};
+        bool seen{false};
+        tree.for_each_preorder([&](double value) {
+            first = seen ? first : value;
+            seen = true;
+        });
+
+        return first;
+    }};
+
+    for (int i{0}; i < 5000; ++i) {
+        x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+        double k{static_cast<double>((x >> 33) % 1000)};
+
+        if (i % 4 == 3) {
+            t.erase(k);
+            model.erase(k);
+        } else if (i % 4 == 2) {
+            assert(t.access(k) == (model.count(k) == 1));
+        } else {
+            t.insert(k);
+            model.insert(k);
+            assert_double_eq(root_key(t), k);
+        }
+    }
+
+    assert(t.is_valid_bst());
+    assert(t.get_size() == model.size());
+    assert(std::vector<double>(t.begin(), t.end()) == std::vector<double>(model.begin(), model.end()));
+
+    // Each access brings the key to the root, and subtree counts survive the rotations
+    for (double k : {*model.begin(), *model.rbegin(), *std::next(model.begin(), model.size() / 2)}) {
+        assert(t.access(k));
+        assert_double_eq(root_key(t), k);
+        assert(t.rank(k) == static_cast<std::size_t>(std::distance(model.begin(), model.find(k))));
+        assert_double_eq(t.select(t.rank(k)), k);
+    }
+
+    assert(t.is_valid_bst());
+
+    // Ascending inserts build a left chain; one access to the bottom roughly halves its depth
+    BinarySearchTree chain;
+    chain.set_access_mode(BinarySearchTree::AccessMode::Splay);
+
+    for (int i{0}; i < 1024; ++i) {
+        chain.insert(i);
+    }
+
+    assert(chain.height() == 1024);
+    assert(chain.access(0));
+    assert(chain.height() < 520);
+    assert(chain.is_valid_bst());
+
+    // Keys above the threshold depth stay where they are, and copies keep the mode
+    BinarySearchTree lazy{chain};
+    assert(lazy.get_access_mode() == BinarySearchTree::AccessMode::Splay);
+    lazy.set_access_mode(BinarySearchTree::AccessMode::Splay, 2000);
+    std::size_t before{lazy.height()};
+    assert(lazy.access(1) && !lazy.access(-1));
+    assert(lazy.height() == before);
+    lazy.set_access_mode(BinarySearchTree::AccessMode::Static);
+    assert(!lazy.access(5000));
+    assert(lazy.height() == before);
+    assert(chain.contains(1023) && lazy.is_valid_bst());
+}
+
+// AVLTree tests
+static void test_avltree_sorted_and_reverse_inserts_stay_balanced() {
+    const int n{1 << 12};
+    AVLTree up;
+    AVLTree down;
+
+    for (int i{0}; i < n; ++i) {
+        up.insert(i);
+        down.insert(n - 1 - i);
+        assert(up.is_valid_bst());
+    }
+
+    assert(down.is_valid_bst());
+    assert(up.get_size() == static_cast<std::size_t>(n));
+    assert(down.get_size() == static_cast<std::size_t>(n));
+    // A BinarySearchTree fed the same keys would be n levels deep
+    assert(up.height() <= 13 * 1.45);
+    assert(down.height() <= 13 * 1.45);
+    assert_double_eq(up.min(), 0.0);
+    assert_double_eq(up.max(), n - 1.0);
+
+    for (int i{0}; i < n; ++i) {
+        assert(up.contains(i));
+        assert(down.contains(i));
+    }
+
+    assert(!up.contains(-1));
+    assert(!up.contains(n));
+    up.insert(7);
+    assert(up.get_size() == static_cast<std::size_t>(n));
+}
+
+static void test_avltree_erase_keeps_balance() {
+    AVLTree t;
+    std::uint64_t x{12345};
+    std::vector<int> keys;
+
+    for (int i{0}; i < 2000; ++i) {
+        x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+        int k{static_cast<int>(x >> 40) % 5000};
+        t.insert(k);
+        keys.push_back(k);
+    }
+
+    assert(t.is_valid_bst());
+    std::size_t before{t.get_size()};
+    t.erase(-1);
+    assert(t.get_size() == before);
+
+    for (std::size_t i{0}; i < keys.size(); i += 2) {
+        t.erase(keys[i]);
+        assert(!t.contains(keys[i]));
+    }
+
+    assert(t.is_valid_bst());
+
+    for (std::size_t i{1}; i < keys.size(); i += 2) {
+        t.erase(keys[i]);
+    }
+
+    assert(t.empty());
+    assert(t.height() == 0);
+
+    for (double v : {5,3,7,2,4,6,8}) {
+        t.insert(v);
+    }
+
+    t.erase(5);
+    assert(!t.contains(5));
+    assert(t.get_size() == 6);
+    assert(t.is_valid_bst());
+}
+
+static void test_avltree_copy_and_move() {
+    AVLTree a;
+
+    for (int i{0}; i < 100; ++i) {
+        a.insert(i);
+    }
+
+    AVLTree b(a);
+    assert(b.get_size() == 100);
+    assert(b.height() == a.height());
+    assert(b.is_valid_bst());
+    AVLTree c;
+    c = b;
+    assert(c.get_size() == 100);
+    assert(c.contains(42));
+    assert(c.is_valid_bst());
+    AVLTree d(std::move(a));
+    assert(d.get_size() == 100);
+    assert(a.empty());
+    AVLTree e;
+    e = std::move(b);
+    assert(e.get_size() == 100);
+    assert(e.contains(99));
+    assert(b.empty());
+}
+
+static void test_avltree_split_and_join() {
+    AVLTree t;
+
+    for (int i{0}; i < 1000; ++i) {
+        t.insert(i);
+    }
+
+    AVLTree less;
+    AVLTree greater;
+    less.insert(-5);
+    assert(t.split(300, less, greater));
+    assert(t.empty());
+    assert(less.get_size() == 300 && greater.get_size() == 699);
+    assert(less.is_valid_bst() && greater.is_valid_bst());
+    assert_double_eq(less.max(), 299.0);
+    assert_double_eq(greater.min(), 301.0);
+    assert(!less.contains(-5));
+
+    AVLTree low;
+    AVLTree high;
+    assert(!less.split(10.5, low, high));
+    assert(low.get_size() == 11 && high.get_size() == 289);
+
+    // Joining trees of very different heights stays balanced
+    AVLTree joined{AVLTree::join(std::move(low), std::move(greater))};
+    assert(low.empty() && greater.empty());
+    assert(joined.get_size() == 710);
+    assert(joined.is_valid_bst());
+    assert(joined.contains(10) && !joined.contains(11) && joined.contains(999));
+    joined = AVLTree::join(std::move(joined), AVLTree{});
+    assert(joined.get_size() == 710 && joined.is_valid_bst());
+}
+
+// Random sets of every size ratio, checked against std::set_union and friends
+static void test_avltree_set_algebra_matches_std() {
+    std::uint64_t x{17};
+    const std::size_t sizes[][2]{{0, 50}, {50, 0}, {1, 3000}, {3000, 1}, {100, 20000}, {20000, 100}, {5000, 5000}};
+
+    for (auto [m, n] : sizes) {
+        for (unsigned threads : {1u, 4u}) {
+            std::vector<double> a;
+            std::vector<double> b;
+            AVLTree ta;
+            AVLTree tb;
+
+            for (std::size_t i{0}; i < m + n; ++i) {
+                x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+                double k{static_cast<double>((x >> 33) % (2 * (m + n)))};
+                (i < m ? a : b).push_back(k);
+                (i < m ? ta : tb).insert(k);
+            }
+
+            for (std::vector<double>* v : {&a, &b}) {
+                std::sort(v->begin(), v->end());
+                v->erase(std::unique(v->begin(), v->end()), v->end());
+            }
+
+            auto check{[](const AVLTree& t, const std::vector<double>& expected) {
+                assert(t.is_valid_bst());
+                assert(t.get_size() == expected.size());
+
+                for (double k : expected) {
+                    assert(t.contains(k));
+                }
+            }};
+
+            std::vector<double> expected;
+            AVLTree u{ta};
+            u.union_with(tb, threads);
+            std::set_union(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(expected));
+            check(u, expected);
+
+            expected.clear();
+            AVLTree in{ta};
+            in.intersect_with(tb, threads);
+            std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(expected));
+            check(in, expected);
+
+            expected.clear();
+            AVLTree d{ta};
+            d.difference_with(tb, threads);
+            std::set_difference(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(expected));
+            check(d, expected);
+            check(tb, b);
+        }
+    }
+
+    // Big enough to run the recursive halves on separate threads
+    AVLTree evens;
+    AVLTree thirds;
+
+    for (int i{0}; i < 150000; ++i) {
+        evens.insert(2.0 * i);
+        thirds.insert(3.0 * i);
+    }
+
+    AVLTree u{evens};
+    u.union_with(thirds, 4);
+    assert(u.get_size() == 150000 + 150000 - 50000 && u.is_valid_bst());
+    AVLTree in{evens};
+    in.intersect_with(thirds, 4);
+    assert(in.get_size() == 50000 && in.is_valid_bst() && in.contains(6) && !in.contains(4));
+    evens.difference_with(thirds, 4);
+    assert(evens.get_size() == 100000 && evens.is_valid_bst() && !evens.contains(6) && evens.contains(4));
+    u.union_with(u);
+    u.difference_with(u);
+    assert(u.empty());
+}
+
+// BPlusTree tests
+static void test_bplustree_matches_std_set() {
+    BPlusTree t;
+    std::set<double> model;
+    std::uint64_t x{99};
+    assert(t.is_valid());
+
+    for (int i{0}; i < 40000; ++i) {
+        x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+        double k{static_cast<double>((x >> 33) % 4000)};
+
+        // Insert-heavy first half, erase-heavy second half, so the tree grows to several levels and shrinks back
+        if ((x >> 20) % 4 < (i < 20000 ? 3u : 1u)) {
+            t.insert(k);
+            model.insert(k);
+        } else {
+            t.erase(k);
+            model.erase(k);
+        }
+
+        assert(t.contains(k) == (model.count(k) == 1));
+
+        if (i % 1000 == 0) {
+            assert(t.is_valid());
+        }
+    }
+
+    assert(t.is_valid());
+    assert(t.get_size() == model.size());
+    assert_double_eq(t.min(), *model.begin());
+    assert_double_eq(t.max(), *model.rbegin());
+    std::vector<double> keys;
+    t.for_each_in_range(-1.0, 5000.0, [&](double k) { keys.push_back(k); });
+    assert(keys == std::vector<double>(model.begin(), model.end()));
+    assert(t.count_range(100.0, 199.5) == static_cast<std::size_t>(std::distance(model.lower_bound(100.0), model.lower_bound(199.5))));
+
+    for (double k : keys) {
+        t.erase(k);
+    }
+
+    assert(t.empty());
+    assert(t.height() == 0);
+    assert(t.is_valid());
+}
+
+static void test_bplustree_sorted_inserts_and_erases() {
+    BPlusTree t;
+
+    for (int i{0}; i < 5000; ++i) {
+        t.insert(i);
+    }
+
+    assert(t.is_valid());
+    assert(t.get_size() == 5000);
+    assert(t.height() <= 4);
+
+    for (int i{4999}; i >= 0; i -= 2) {
+        t.erase(i);
+    }
+
+    assert(t.is_valid());
+    assert(t.get_size() == 2500);
+    assert(!t.contains(4999));
+    assert(t.contains(4998));
+
+    for (int i{0}; i < 5000; i += 2) {
+        t.erase(i);
+    }
+
+    assert(t.empty());
+    assert(t.is_valid());
+}
+
+static void test_bplustree_bulk_load_range_copy_move() {
+    std::vector<double> values;
+
+    for (int i{0}; i < 10000; ++i) {
+        values.push_back((i * 7919) % 10000);
+        values.push_back(i % 100);
+    }
+
+    BPlusTree a(values.data(), values.size());
+    assert(a.is_valid());
+    assert(a.get_size() == 10000);
+    assert(a.height() == 3);
+    assert_double_eq(a.min(), 0.0);
+    assert_double_eq(a.max(), 9999.0);
+    assert(a.count_range(10.0, 20.0) == 10);
+    assert(a.count_range(10.0, 10.0) == 0);
+    assert(a.count_range(9990.5, 1e9) == 9);
+    assert(a.count_range(5.5, 5.6) == 0);
+    double sum{0.0};
+    a.for_each_in_range(100.0, 104.0, [&](double k) { sum += k; });
+    assert_double_eq(sum, 406.0);
+    a.insert(-1.0);
+    a.erase(5000.0);
+    assert(a.is_valid());
+    assert(a.get_size() == 10000);
+
+    BPlusTree b(a);
+    assert(b.is_valid());
+    assert(b.get_size() == 10000);
+    assert(b.contains(-1.0));
+    assert(!b.contains(5000.0));
+    BPlusTree c;
+    c = b;
+    assert(c.is_valid());
+    assert(c.count_range(0.0, 100.0) == 100);
+    BPlusTree d(std::move(a));
+    assert(d.get_size() == 10000);
+    assert(a.empty());
+    assert(a.is_valid());
+    BPlusTree e;
+    e = std::move(b);
+    assert(e.contains(9999.0));
+    assert(b.empty());
+    BPlusTree f(values.data(), 0);
+    assert(f.empty());
+    assert(f.is_valid());
+}
+
+// FrozenSet tests
+static void test_frozenset_matches_sorted_array() {
+    std::uint64_t x{7};
+
+    for (std::size_t n : {0, 1, 2, 3, 7, 8, 9, 100, 1000, 4097}) {
+        BinarySearchTree tree;
+        std::set<double> model;
+
+        while (model.size() < n) {
+            x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+            double k{static_cast<double>((x >> 33) % 100000) / 4};
+            tree.insert(k);
+            model.insert(k);
+        }
+
+        FrozenSet set{FrozenSet::build(tree)};
+        std::vector<double> sorted(model.begin(), model.end());
+        assert(set.get_size() == n);
+        assert(set.empty() == (n == 0));
+
+        if (n > 0) {
+            assert_double_eq(set.min(), sorted.front());
+            assert_double_eq(set.max(), sorted.back());
+        }
+
+        for (int i{-1}; i <= 25001; ++i) {
+            double probe{i + 0.25 * (i % 4)};
+            auto it{std::lower_bound(sorted.begin(), sorted.end(), probe)};
+            double found{0.0};
+            assert(set.contains(probe) == (it != sorted.end() && *it == probe));
+            assert(set.lower_bound(probe, found) == (it != sorted.end()));
+            assert(it == sorted.end() || found == *it);
+            assert(set.rank(probe) == static_cast<std::size_t>(it - sorted.begin()));
+        }
+    }
+}
+
+static void test_frozenset_copy_and_move() {
+    BinarySearchTree tree;
+
+    for (double v : {10,5,15,3,7,12,18}) {
+        tree.insert(v);
+    }
+
+    FrozenSet a{FrozenSet::build(tree)};
+    FrozenSet b(a);
+    assert(b.get_size() == 7);
+    assert(b.contains(12));
+    assert(b.rank(12) == 4);
+    FrozenSet c;
+    assert(c.empty());
+    assert(!c.contains(0));
+    assert(c.rank(1) == 0);
+    c = b;
+    assert(c.contains(3));
+    FrozenSet d(std::move(a));
+    assert(d.get_size() == 7);
+    assert(a.empty());
+    assert(!a.contains(10));
+    FrozenSet e;
+    e = std::move(b);
+    assert(e.contains(18));
+    assert(b.empty());
+}
+
+// CompactBinarySearchTree tests
+static void test_compactbst_matches_std_set() {
+    CompactBinarySearchTree t;
+    std::set<double> model;
+    std::uint64_t x{5};
+    assert(t.is_valid_bst());
+    assert(t.height() == 0);
+
+    for (int i{0}; i < 6000; ++i) {
+        x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+        double k{static_cast<double>((x >> 33) % 1500)};
+
+        if (i % 3 == 2) {
+            t.erase(k);
+            model.erase(k);
+        } else {
+            t.insert(k);
+            model.insert(k);
+        }
+
+        assert(t.contains(k) == (model.count(k) == 1));
+    }
+
     assert(t.is_valid_bst());
+    assert(t.get_size() == model.size());
+    assert_double_eq(t.min(), *model.begin());
+    assert_double_eq(t.max(), *model.rbegin());
+
+    for (double k{0}; k < 1500; ++k) {
+        assert(t.contains(k) == (model.count(k) == 1));
+    }
+}
+
+static void test_compactbst_slot_reuse_copy_clear() {
+    CompactBinarySearchTree t;
+
+    for (double v : {5,3,7,2,4,6,8}) {
+        t.insert(v);
+    }
+
     t.insert(5);
-    t.insert(3);
-    t.insert(7);
-    t.insert(2);
-    t.insert(4);
-    t.insert(6);
-    t.insert(8);
-    assert(!t.empty());
     assert(t.get_size() == 7);
-    assert(t.contains(5));
-    assert(t.contains(2));
-    assert(t.contains(8));
-    assert(!t.contains(999));
-    assert_double_eq(t.min(), 2.0);
-    assert_double_eq(t.max(), 8.0);
     assert(t.height() == 3);
+    std::size_t bytes{t.memory_bytes()};
+    assert(bytes == 16 * 16);
+
+    // Erased slots are reused, so churn does not grow the arena
+    for (int round{0}; round < 100; ++round) {
+        t.erase(5);
+        t.erase(2);
+        t.insert(2);
+        t.insert(5);
+    }
+
+    assert(t.memory_bytes() == bytes);
+    assert(t.get_size() == 7);
     assert(t.is_valid_bst());
+    CompactBinarySearchTree copy(t);
+    assert(copy.get_size() == 7);
+    assert(copy.contains(5));
+    assert(copy.is_valid_bst());
+    copy.insert(100);
+    assert(!t.contains(100));
+    CompactBinarySearchTree assigned;
+    assigned = copy;
+    assert(assigned.get_size() == 8);
+    CompactBinarySearchTree moved(std::move(copy));
+    assert(moved.contains(100));
+    assert(copy.empty());
+    copy.insert(1);
+    assert(copy.contains(1));
+    t.clear();
+    assert(t.empty());
+    assert(!t.contains(5));
+    assert(t.memory_bytes() == bytes);
+    t.insert(9);
+    assert(t.get_size() == 1);
+    assert_double_eq(t.min(), 9.0);
+
+    // Slots past the 32-bit index space are refused rather than wrapped
+    bool threw{false};
+
+    try {
+        t.reserve(std::size_t{1} << 32);
+    } catch (const std::length_error&) {
+        threw = true;
+    }
+
+    assert(threw);
+    assert(t.memory_bytes() == bytes);
 }
 
-static void test_bst_no_duplicates() {
-    BinarySearchTree t;
-    t.insert(5);
-    t.insert(5);
-    t.insert(5);
-    assert(t.get_size() == 1);
-    assert(t.contains(5));
+// ConcurrentOrderedSet tests
+static void test_concurrentorderedset_matches_std_set() {
+    ConcurrentOrderedSet t;
+    std::set<double> model;
+    std::uint64_t x{11};
+    assert(t.empty());
+    assert(t.is_valid());
+    assert(std::isnan(t.min()) && std::isnan(t.max()));
+
+    for (int i{0}; i < 20000; ++i) {
+        x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+        double k{static_cast<double>((x >> 33) % 4000)};
+
+        if (i % 3 == 2) {
+            t.erase(k);
+            model.erase(k);
+        } else {
+            t.insert(k);
+            model.insert(k);
+        }
+
+        assert(t.contains(k) == (model.count(k) == 1));
+    }
+
+    assert(t.is_valid());
+    assert(t.get_size() == model.size());
+    assert_double_eq(t.min(), *model.begin());
+    assert_double_eq(t.max(), *model.rbegin());
+
+    // Emptied leaves at either end are skipped by min and max
+    for (double k : std::vector<double>(model.begin(), std::next(model.begin(), 200))) {
+        t.erase(k);
+        model.erase(k);
+    }
+
+    for (double k : std::vector<double>(std::prev(model.end(), 200), model.end())) {
+        t.erase(k);
+        model.erase(k);
+    }
+
+    assert_double_eq(t.min(), *model.begin());
+    assert_double_eq(t.max(), *model.rbegin());
+
+    for (double k{0}; k < 4000; ++k) {
+        t.erase(k);
+    }
+
+    assert(t.empty());
+    assert(t.is_valid());
+    assert(std::isnan(t.min()) && std::isnan(t.max()));
+    t.insert(7);
+    assert_double_eq(t.min(), 7.0);
+    assert_double_eq(t.max(), 7.0);
+}
+
+static void test_concurrentorderedset_parallel_writers_and_readers() {
+    ConcurrentOrderedSet t;
+    const int stable{2000};
+
+    // Even keys stay put; writers churn their own odd keys while readers check
+    // that every even key is always visible and min and max never move
+    for (int k{0}; k < stable; ++k) {
+        t.insert(2.0 * k);
+    }
+
+    std::atomic<bool> done{false};
+    std::vector<std::thread> pool;
+
+    for (int w{0}; w < 3; ++w) {
+        pool.emplace_back([&t, w] {
+            for (int round{0}; round < 3; ++round) {
+                for (int k{w}; k < stable - 1; k += 3) {
+                    t.insert(2.0 * k + 1);
+                }
+
+                for (int k{w}; k < stable - 1; k += 3) {
+                    if (round < 2 || k % 2 == 0) {
+                        t.erase(2.0 * k + 1);
+                    }
+                }
+            }
+        });
+    }
+
+    for (int r{0}; r < 2; ++r) {
+        pool.emplace_back([&t, &done] {
+            while (!done.load()) {
+                for (int k{0}; k < stable; ++k) {
+                    assert(t.contains(2.0 * k));
+                }
+
+                assert_double_eq(t.min(), 0.0);
+                assert_double_eq(t.max(), 2.0 * (stable - 1));
+            }
+        });
+    }
+
+    for (int w{0}; w < 3; ++w) {
+        pool[w].join();
+    }
+
+    done.store(true);
+
+    for (std::size_t i{3}; i < pool.size(); ++i) {
+        pool[i].join();
+    }
+
+    std::size_t expected{stable};
+
+    for (int k{0}; k < stable - 1; ++k) {
+        bool kept{k % 2 == 1};
+        assert(t.contains(2.0 * k + 1) == kept);
+        expected += kept;
+    }
+
+    assert(t.get_size() == expected);
+    assert(t.is_valid());
+}
+
+// PersistentBinarySearchTree tests
+static void test_persistentbst_snapshots_are_isolated() {
+    PersistentBinarySearchTree t;
+    std::set<double> model;
+    std::vector<PersistentBinarySearchTree> versions;
+    std::vector<std::set<double>> models;
+    std::uint64_t x{3};
+
+    // Keep a snapshot every 500 operations and check each still matches its model at the end
+    for (int i{0}; i < 6000; ++i) {
+        x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+        double k{static_cast<double>((x >> 33) % 1000)};
+
+        if (i % 3 == 2) {
+            t.erase(k);
+            model.erase(k);
+        } else {
+            t.insert(k);
+            model.insert(k);
+        }
+
+        if (i % 500 == 0) {
+            versions.push_back(t.snapshot());
+            models.push_back(model);
+            assert(versions.back().shares_root_with(t));
+        }
+    }
+
+    assert(t.is_valid_bst());
+    assert(t.get_size() == model.size());
+
+    for (std::size_t v{0}; v < versions.size(); ++v) {
+        assert(versions[v].is_valid_bst());
+        assert(versions[v].get_size() == models[v].size());
+
+        for (double k{0}; k < 1000; ++k) {
+            assert(versions[v].contains(k) == (models[v].count(k) == 1));
+        }
+    }
+
+    // Writing to a snapshot leaves the tree it came from alone
+    PersistentBinarySearchTree branch{versions[3]};
+    branch.insert(5000);
+    branch.erase(*models[3].begin());
+    assert(!versions[3].contains(5000));
+    assert(versions[3].contains(*models[3].begin()));
+    assert(!t.contains(5000));
+    assert(branch.get_size() == models[3].size());
+    assert_double_eq(branch.max(), 5000.0);
+
+    versions.clear();
     assert(t.is_valid_bst());
+    assert_double_eq(t.min(), *model.begin());
+    assert_double_eq(t.max(), *model.rbegin());
+    t.clear();
+    assert(t.empty());
+    assert(branch.contains(5000));
 }
 
-static void test_bst_erase_cases() {
-    BinarySearchTree t;
+static void test_persistentbst_build_move_and_threads() {
+    BinarySearchTree source;
 
     for (double v : {5,3,7,2,4,6,8}) {
-        t.insert(v);
+        source.insert(v);
     }
 
+    PersistentBinarySearchTree t{source};
     assert(t.get_size() == 7);
-    t.erase(2);
-    assert(!t.contains(2));
-    assert(t.get_size() == 6);
-    assert(t.is_valid_bst());
-    t.erase(8);
-    assert(!t.contains(8));
-    assert(t.get_size() == 5);
-    assert(t.is_valid_bst());
-    t.erase(7);
-    assert(!t.contains(7));
-    assert(t.get_size() == 4);
+    assert(t.height() == 3);
     assert(t.is_valid_bst());
+    PersistentBinarySearchTree moved{std::move(t)};
+    assert(t.empty());
+    assert(moved.contains(4));
+    t = moved;
+    assert(t.shares_root_with(moved));
     t.erase(5);
-    assert(!t.contains(5));
-    assert(t.get_size() == 3);
-    assert(t.is_valid_bst());
-    t.clear();
+    assert(!t.contains(5) && moved.contains(5));
+    assert(t.is_valid_bst() && moved.is_valid_bst());
+
+    // Readers walk frozen versions while the writer keeps changing its own
+    PersistentBinarySearchTree writer;
+
+    for (int k{0}; k < 2000; ++k) {
+        writer.insert((k * 7919) % 2000);
+    }
+
+    std::vector<std::thread> readers;
+
+    for (int r{0}; r < 3; ++r) {
+        readers.emplace_back([version = writer.snapshot()] {
+            for (int round{0}; round < 5; ++round) {
+                for (int k{0}; k < 2000; ++k) {
+                    assert(version.contains(k));
+                }
+            }
+
+            assert(version.is_valid_bst());
+        });
+    }
+
+    for (int k{0}; k < 2000; k += 2) {
+        writer.erase(k);
+        writer.insert(k + 0.5);
+    }
+
+    for (std::thread& th : readers) {
+        th.join();
+    }
+
+    assert(writer.get_size() == 2000);
+    assert(!writer.contains(0) && writer.contains(0.5) && writer.contains(1));
+    assert(writer.is_valid_bst());
+}
+
+// FlatSet / FlatMap tests
+static void test_flatset_matches_std_set() {
+    FlatSet t;
+    std::set<double> model;
+    std::uint64_t x{41};
     assert(t.empty());
-    assert(t.get_size() == 0);
+
+    // Enough inserts between erases to cross several batch merges
+    for (int i{0}; i < 20000; ++i) {
+        x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+        double k{static_cast<double>((x >> 33) % 3000)};
+
+        if (i % 5 == 4) {
+            t.erase(k);
+            model.erase(k);
+        } else {
+            t.insert(k);
+            model.insert(k);
+        }
+
+        assert(t.contains(k) == (model.count(k) == 1));
+        assert(t.get_size() == model.size());
+    }
+
+    assert_double_eq(t.min(), *model.begin());
+    assert_double_eq(t.max(), *model.rbegin());
+
+    for (double k{-1}; k <= 3000; ++k) {
+        assert(t.contains(k) == (model.count(k) == 1));
+    }
+
+    DynamicArray out;
+    t.to_array(out);
+    assert(out.get_size() == model.size());
+    std::size_t i{0};
+
+    for (double k : model) {
+        assert_double_eq(out[i++], k);
+    }
+
+    // Bulk insert skips keys already present and duplicates within the batch
+    const double more[]{-5, 3000, 1, 1, 3001, -5};
+    t.insert(more, 6);
+    model.insert(std::begin(more), std::end(more));
+    assert(t.get_size() == model.size());
+    assert_double_eq(t.min(), -5.0);
+    assert_double_eq(t.max(), 3001.0);
+
+    std::size_t odd{static_cast<std::size_t>(std::count_if(model.begin(), model.end(), [](double k) { return static_cast<long long>(k) % 2 != 0; }))};
+    assert(t.erase_if([](double k) { return static_cast<long long>(k) % 2 != 0; }) == odd);
+    assert(t.get_size() == model.size() - odd);
+    assert(!t.contains(1) && !t.contains(3001) && !t.contains(-5) && t.contains(3000));
 }
 
-static void test_bst_copy_and_move() {
-    BinarySearchTree a;
+static void test_flatset_flatmap_bulk_copy_move() {
+    const double values[]{9, 3, 7, 3, 1, 9};
+    FlatSet s{values, 6};
+    assert(s.get_size() == 4);
+    assert_double_eq(s.min(), 1.0);
+    assert_double_eq(s.max(), 9.0);
+    s.insert(0.5);
+    FlatSet copy{s};
+    copy.erase(0.5);
+    assert(s.contains(0.5) && !copy.contains(0.5));
+    FlatSet moved{std::move(copy)};
+    assert(moved.get_size() == 4 && copy.empty());
+    copy.insert(2);
+    assert(copy.contains(2));
+    s = moved;
+    assert(s.get_size() == 4 && !s.contains(0.5));
+    s.clear();
+    assert(s.empty() && !s.contains(1));
 
-    for (double v : {10,5,15,3,7,12,18}) {
-        a.insert(v);
+    // A repeated key keeps its last value, and insert assigns over an existing one
+    const double keys[]{5, 2, 5, 8};
+    const double vals[]{50, 20, 55, 80};
+    FlatMap m{keys, vals, 4};
+    double v{0.0};
+    assert(m.get_size() == 3);
+    assert(m.get(5, v) && v == 55);
+    m.insert(2, 21);
+    assert(m.get(2, v) && v == 21);
+
+    for (int k{100}; k < 500; ++k) {
+        m.insert(k, 2.0 * k);
     }
 
-    BinarySearchTree b(a);
-    assert(b.get_size() == a.get_size());
-    assert(b.contains(7));
-    assert_double_eq(b.min(), 3.0);
-    assert_double_eq(b.max(), 18.0);
-    assert(b.is_valid_bst());
-    BinarySearchTree c;
-    c = b;
-    assert(c.get_size() == 7);
-    assert(c.contains(12));
-    assert(c.is_valid_bst());
-    BinarySearchTree d(std::move(a));
-    assert(d.get_size() == 7);
-    assert(d.contains(15));
-    BinarySearchTree e;
-    e = std::move(b);
-    assert(e.get_size() == 7);
-    assert(e.contains(5));
+    m.insert(150, -1);
+    m.insert(450, -2);
+    assert(m.get_size() == 403);
+    assert(m.get(150, v) && v == -1);
+    assert(m.get(450, v) && v == -2);
+    assert(m.get(499, v) && v == 998);
+    assert(!m.get(99, v));
+    assert_double_eq(m.min(), 2.0);
+    assert_double_eq(m.max(), 499.0);
+    m.erase(5);
+    m.erase(499);
+    assert(!m.contains(5) && !m.contains(499) && m.get_size() == 401);
+    assert(m.erase_if([](double, double value) { return value < 0; }) == 2);
+    assert(!m.contains(150) && m.contains(151));
+    FlatMap mc{m};
+    mc.insert(1, 1);
+    assert(!m.contains(1) && mc.get_size() == 400);
+    FlatMap mm;
+    mm = std::move(mc);
+    assert(mm.get(1, v) && v == 1 && mc.empty());
 }
 
 // Main
@@ -463,12 +2606,84 @@ int main() {
     RUN_TEST(test_hashmap_basic_insert_get_remove);
     RUN_TEST(test_hashmap_rehash_stability);
     RUN_TEST(test_hashmap_copy_and_move);
+    RUN_TEST(test_hashmap_power_of_two_capacity_structured_keys);
+    RUN_TEST(test_hashmap_string_keys_heterogeneous_lookup);
+    RUN_TEST(test_hashmap_try_emplace_insert_or_assign);
+    RUN_TEST(test_hashmap_incremental_rehash);
+    RUN_TEST(test_hashmap_get_many_insert_many);
+    RUN_TEST(test_hashmap_reserve_bulk_build_shrink);
+    RUN_TEST(test_hashmap_iterators_and_for_each);
+#ifdef HASHMAP_STATS
+    RUN_TEST(test_hashmap_stats);
+#endif
+
+    // DenseHashMap
+    RUN_TEST(test_densehashmap_basic_and_swap_remove);
+    RUN_TEST(test_densehashmap_copy_move_clear);
+
+    // FrozenHashMap
+    RUN_TEST(test_frozenhashmap_build_and_lookup);
+    RUN_TEST(test_frozenhashmap_save_and_load);
+
+    // ConcurrentHashMap
+    RUN_TEST(test_concurrenthashmap_basic);
+    RUN_TEST(test_concurrenthashmap_parallel_writers_and_readers);
+
+    // LockFreeHashMap
+    RUN_TEST(test_lockfreehashmap_basic_and_rehash);
+    RUN_TEST(test_lockfreehashmap_readers_during_writes);
+
+    // BloomFilter
+    RUN_TEST(test_blockedbloomfilter_no_false_negatives);
+    RUN_TEST(test_countingbloomfilter_remove);
+
+    // LruCache
+    RUN_TEST(test_lrucache_lru_eviction_and_stats);
+    RUN_TEST(test_lrucache_clock_second_chance);
 
     // BinarySearchTree
     RUN_TEST(test_bst_insert_contains_min_max_height_valid);
     RUN_TEST(test_bst_no_duplicates);
     RUN_TEST(test_bst_erase_cases);
     RUN_TEST(test_bst_copy_and_move);
+    RUN_TEST(test_bst_traversal_orders);
+    RUN_TEST(test_bst_degenerate_chains);
+    RUN_TEST(test_bst_iterators_and_visitors);
+    RUN_TEST(test_bst_order_statistics);
+    RUN_TEST(test_bst_build_from_sorted_and_unsorted);
+    RUN_TEST(test_bst_splay_mode);
+
+    // AVLTree
+    RUN_TEST(test_avltree_sorted_and_reverse_inserts_stay_balanced);
+    RUN_TEST(test_avltree_erase_keeps_balance);
+    RUN_TEST(test_avltree_copy_and_move);
+    RUN_TEST(test_avltree_split_and_join);
+    RUN_TEST(test_avltree_set_algebra_matches_std);
+
+    // BPlusTree
+    RUN_TEST(test_bplustree_matches_std_set);
+    RUN_TEST(test_bplustree_sorted_inserts_and_erases);
+    RUN_TEST(test_bplustree_bulk_load_range_copy_move);
+
+    // FrozenSet
+    RUN_TEST(test_frozenset_matches_sorted_array);
+    RUN_TEST(test_frozenset_copy_and_move);
+
+    // CompactBinarySearchTree
+    RUN_TEST(test_compactbst_matches_std_set);
+    RUN_TEST(test_compactbst_slot_reuse_copy_clear);
+
+    // ConcurrentOrderedSet
+    RUN_TEST(test_concurrentorderedset_matches_std_set);
+    RUN_TEST(test_concurrentorderedset_parallel_writers_and_readers);
+
+    // PersistentBinarySearchTree
+    RUN_TEST(test_persistentbst_snapshots_are_isolated);
+    RUN_TEST(test_persistentbst_build_move_and_threads);
+
+    // FlatSet / FlatMap
+    RUN_TEST(test_flatset_matches_std_set);
+    RUN_TEST(test_flatset_flatmap_bulk_copy_move);
     std::cout << "\nAll tests passed (" << g_tests_run << " tests).\n";
 
     return 0;